@@ -0,0 +1,111 @@
+#include "G4RunManagerFactory.hh"
+#include "G4UImanager.hh"
+#include "G4VisExecutive.hh"
+#include "G4UIExecutive.hh"
+#include "G4Threading.hh"
+#include "Randomize.hh"
+
+#include "DET01DetectorConstruction.hh"
+#include "DET01PhysicsList.hh"
+#include "DET01ActionInitialization.hh"
+#include "DET01EventSeeds.hh"
+
+#include <cstdlib>
+
+namespace {
+  void PrintUsage()
+  {
+    G4cerr << " Usage: det01 [macro] [-t nThreads|max] [-r serial|mt|tasking] [-s seed]" << G4endl;
+    G4cerr << "   -t : number of worker threads (default: Geant4 default, max = all cores)" << G4endl;
+    G4cerr << "   -r : run manager type (default: Geant4 build default)" << G4endl;
+    G4cerr << "   -s : master random seed; worker events are seeded from the master engine," << G4endl;
+    G4cerr << "        per-event seeds (/det01/seeds/) from /det01/seeds/base = seed" << G4endl;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  // Parse command line
+  G4String macro;
+  G4int nThreads = 0;
+  G4long seed = -1;
+  G4RunManagerType runManagerType = G4RunManagerType::Default;
+
+  for (G4int i=1; i<argc; i++) {
+    G4String arg = argv[i];
+    if (arg == "-t" && i+1 < argc) {
+      G4String value = argv[++i];
+      nThreads = (value == "max") ? G4Threading::G4GetNumberOfCores() : std::atoi(value.c_str());
+    }
+    else if (arg == "-r" && i+1 < argc) {
+      G4String value = argv[++i];
+      if (value == "serial") runManagerType = G4RunManagerType::Serial;
+      else if (value == "mt") runManagerType = G4RunManagerType::MT;
+      else if (value == "tasking") runManagerType = G4RunManagerType::Tasking;
+      else { PrintUsage(); return 1; }
+    }
+    else if (arg == "-s" && i+1 < argc) {
+      seed = std::atol(argv[++i]);
+    }
+    else if (arg[0] != '-' && macro.empty()) {
+      macro = arg;
+    }
+    else {
+      PrintUsage();
+      return 1;
+    }
+  }
+
+  // Interactive mode if no macro is given
+  G4UIExecutive* ui = nullptr;
+  if (macro.empty()) {
+    ui = new G4UIExecutive(argc, argv);
+  }
+
+  // Master seed. In MT/tasking mode every event is seeded from the master
+  // engine, so results do not depend on the number of threads.
+  if (seed >= 0) {
+    G4Random::setTheSeed(seed);
+  }
+
+  // Construct the run manager
+  auto* runManager = G4RunManagerFactory::CreateRunManager(runManagerType);
+  if (nThreads > 0) {
+    runManager->SetNumberOfThreads(nThreads);
+  }
+
+  // Set mandatory initialization classes
+  runManager->SetUserInitialization(new DET01DetectorConstruction());
+  runManager->SetUserInitialization(new DET01PhysicsList());
+  runManager->SetUserInitialization(new DET01ActionInitialization());
+
+  // Initialize visualization
+  G4VisManager* visManager = new G4VisExecutive;
+  visManager->Initialize();
+
+  // Get the pointer to the User Interface manager
+  G4UImanager* UImanager = G4UImanager::GetUIpointer();
+
+  // Per-event seeds follow the run seed (a macro may still set the base)
+  if (seed >= 0) {
+    DET01EventSeeds::GetInstance();
+    UImanager->ApplyCommand("/det01/seeds/base " + std::to_string(seed % 2147483647));
+  }
+
+  if (!ui) {
+    // batch mode
+    G4String command = "/control/execute ";
+    UImanager->ApplyCommand(command + macro);
+  }
+  else {
+    // interactive mode
+    UImanager->ApplyCommand("/control/execute init_vis.mac");
+    ui->SessionStart();
+    delete ui;
+  }
+
+  // Job termination
+  delete visManager;
+  delete runManager;
+  return 0;
+}
@@ -0,0 +1,293 @@
+// det01_bench: fixed-seed benchmark of the det01 simulation.
+//
+// Runs canned workloads on the standard geometry and prints one JSON object
+// per workload (JSON lines), so builds and machines can be compared:
+//   cosmic_optics   : cosmic muons (setup_cosmic.mac GPS source), full optical tracking
+//   cosmic_nooptics : same source, scintillation and Cerenkov inactivated
+//   cosmic_envelope : DET01CosmicGenerator (envelope-restricted muons), no optics
+//   scattering      : d-p elastic deuterons from the origin (the ring centre)
+//                     towards the ring acceptance,
+//                     on the 16-detector ring layout (22.5 / 30 deg, 8 per
+//                     ring, 150 cm)
+//
+// The cosmic workloads run on the default stack layout. A workload on another
+// layout than the previous one rebuilds the geometry before it is timed.
+//
+// Reported per workload: events, wall and CPU time, events/s, optical
+// photons/s, steps/s, output bytes per event and memory: the resident set
+// after the workload and its growth during it (rss_kb, rss_delta_kb), the
+// growth of the process peak (peak_rss_delta_kb) and the process peak
+// itself (peak_rss_kb, over all workloads so far: run one workload per
+// process to compare peaks). The initialization time is reported with
+// every workload. A failing UI command aborts the benchmark (exit code 2).
+//
+// Usage: det01_bench [all|<workload>...] [-t nThreads] [-n events]
+//                    [-s seed] [-c cosmicMacro] [-o out.jsonl]
+
+#include "G4RunManagerFactory.hh"
+#include "G4UImanager.hh"
+#include "G4UserTrackingAction.hh"
+#include "G4Track.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4AutoLock.hh"
+#include "G4Threading.hh"
+#include "G4Version.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include "DET01DetectorConstruction.hh"
+#include "DET01PhysicsList.hh"
+#include "DET01ActionInitialization.hh"
+
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+G4Mutex benchMutex = G4MUTEX_INITIALIZER;
+
+// Per-thread track/step counters, summed by the master after each run
+class BenchTrackingAction : public G4UserTrackingAction
+{
+  public:
+    static std::vector<BenchTrackingAction*>& Instances()
+    {
+      static std::vector<BenchTrackingAction*> instances;
+      return instances;
+    }
+
+    BenchTrackingAction() : fSteps(0), fPhotons(0)
+    {
+      G4AutoLock lock(&benchMutex);
+      Instances().push_back(this);
+    }
+
+    virtual void PostUserTrackingAction(const G4Track* track)
+    {
+      fSteps += track->GetCurrentStepNumber();
+      if (track->GetDefinition() == G4OpticalPhoton::OpticalPhotonDefinition()) fPhotons++;
+    }
+
+    G4long fSteps;
+    G4long fPhotons;
+};
+
+class BenchActionInitialization : public DET01ActionInitialization
+{
+  public:
+    virtual void Build() const
+    {
+      DET01ActionInitialization::Build();
+      SetUserAction(new BenchTrackingAction());
+    }
+};
+
+struct Workload {
+  G4String name;
+  G4int nEvents;
+  std::vector<G4String> geometry;   // layout commands, applied before a rebuild
+  std::vector<G4String> commands;
+};
+
+G4double CpuSeconds()
+{
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+       + 1e-6 * (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+G4long PeakRssKB()
+{
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;   // kB on Linux
+}
+
+// Current resident set (second field of /proc/self/statm, in pages)
+G4long RssKB()
+{
+  G4long pages = 0, resident = 0;
+  std::ifstream statm("/proc/self/statm");
+  if (!(statm >> pages >> resident)) return -1;
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+G4long FileSize(const G4String& name)
+{
+  struct stat st;
+  return (stat(name.c_str(), &st) == 0) ? G4long(st.st_size) : -1;
+}
+
+G4bool Apply(G4UImanager* UImanager, const G4String& command)
+{
+  G4int status = UImanager->ApplyCommand(command);
+  if (status == fCommandSucceeded) return true;
+  G4cerr << " det01_bench: \"" << command << "\" failed (status " << status << ")" << G4endl;
+  return false;
+}
+
+void PrintUsage()
+{
+  G4cerr << " Usage: det01_bench [all|cosmic_optics|cosmic_nooptics|cosmic_envelope|scattering ...]"
+         << " [-t nThreads] [-n events] [-s seed] [-c cosmicMacro] [-o out.jsonl]" << G4endl;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  // Parse command line
+  std::vector<G4String> selected;
+  G4int nThreads = 1;
+  G4int nEvents = 0;
+  G4long seed = 12345;
+  G4String cosmicMacro = "setup_cosmic.mac";
+  G4String outName;
+
+  for (G4int i=1; i<argc; i++) {
+    G4String arg = argv[i];
+    if (arg == "-t" && i+1 < argc) {
+      G4String value = argv[++i];
+      nThreads = (value == "max") ? G4Threading::G4GetNumberOfCores() : std::atoi(value.c_str());
+    }
+    else if (arg == "-n" && i+1 < argc) nEvents = std::atoi(argv[++i]);
+    else if (arg == "-s" && i+1 < argc) seed = std::atol(argv[++i]);
+    else if (arg == "-c" && i+1 < argc) cosmicMacro = argv[++i];
+    else if (arg == "-o" && i+1 < argc) outName = argv[++i];
+    else if (arg[0] != '-') selected.push_back(arg);
+    else { PrintUsage(); return 1; }
+  }
+  if (selected.empty() || selected[0] == "all") {
+    selected = {"cosmic_optics", "cosmic_nooptics", "cosmic_envelope", "scattering"};
+  }
+
+  // /control/execute of a missing macro does not fail
+  for (const auto& name : selected) {
+    if ((name == "cosmic_optics" || name == "cosmic_nooptics") && !std::ifstream(cosmicMacro)) {
+      G4cerr << " det01_bench: cannot read the cosmic macro " << cosmicMacro << " (-c)" << G4endl;
+      return 2;
+    }
+  }
+
+  std::ofstream outFile;
+  if (!outName.empty()) outFile.open(outName);
+  std::ostream& out = outName.empty() ? std::cout : outFile;
+
+  // Construct the run manager
+  G4Random::setTheSeed(seed);
+  auto* runManager = G4RunManagerFactory::CreateRunManager(
+      nThreads > 1 ? G4RunManagerType::Default : G4RunManagerType::Serial);
+  if (nThreads > 1) runManager->SetNumberOfThreads(nThreads);
+
+  runManager->SetUserInitialization(new DET01DetectorConstruction());
+  runManager->SetUserInitialization(new DET01PhysicsList());
+  runManager->SetUserInitialization(new BenchActionInitialization());
+
+  // Canned workloads (every workload sets the full geometry/generator/process state)
+  const std::vector<G4String> stack = {"/det01/geometry/layout stack"};
+  const std::vector<G4String> rings = {"/det01/geometry/layout rings", "/det01/geometry/rings 22.5 30",
+                                       "/det01/geometry/perRing 8", "/det01/geometry/distance 150 cm"};
+  std::vector<Workload> workloads = {
+    {"cosmic_optics", 1000, stack,
+     {"/det01/gun/mode gps", "/control/execute " + cosmicMacro,
+      "/process/activate Scintillation", "/process/activate Cerenkov"}},
+    {"cosmic_nooptics", 10000, stack,
+     {"/det01/gun/mode gps", "/control/execute " + cosmicMacro,
+      "/process/inactivate Scintillation", "/process/inactivate Cerenkov"}},
+    {"cosmic_envelope", 10000, stack,
+     {"/det01/gun/mode cosmic",
+      "/process/inactivate Scintillation", "/process/inactivate Cerenkov"}},
+    {"scattering", 10000, rings,
+     {"/det01/gun/mode scatter", "/det01/gun/vertex 0 0 0 cm", "/det01/scatter/energy 380 MeV",
+      "/det01/scatter/A 1.0", "/det01/scatter/B 0.0", "/det01/scatter/C 0.2",
+      "/det01/scatter/acceptance true",
+      "/process/activate Scintillation", "/process/activate Cerenkov"}}
+  };
+
+  G4UImanager* UImanager = G4UImanager::GetUIpointer();
+  for (const G4String command : {"/control/verbose 0", "/run/verbose 0",
+                                 "/event/verbose 0", "/tracking/verbose 0"}) {
+    if (!Apply(UImanager, command)) { delete runManager; return 2; }
+  }
+
+  auto t0 = std::chrono::steady_clock::now();
+  runManager->Initialize();
+  G4double initTime = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - t0).count();
+  std::vector<G4String> geometry = stack;
+
+  for (const auto& name : selected) {
+    const Workload* workload = nullptr;
+    for (const auto& w : workloads) if (w.name == name) workload = &w;
+    if (!workload) { PrintUsage(); return 1; }
+
+    // Layout of another workload: rebuild now, outside the timed run
+    std::vector<G4String> commands;
+    if (workload->geometry != geometry) {
+      geometry = workload->geometry;
+      commands = geometry;
+      commands.push_back("/run/reinitializeGeometry");
+      commands.push_back("/run/initialize");
+    }
+
+    G4String fileName = "DET01_Bench_" + workload->name;
+    commands.insert(commands.end(), workload->commands.begin(), workload->commands.end());
+    commands.push_back("/analysis/setFileName " + fileName);
+    for (const auto& command : commands) {
+      if (!Apply(UImanager, command)) { delete runManager; return 2; }
+    }
+
+    // Same seed for every workload and thread count
+    G4Random::setTheSeed(seed);
+    for (auto* counters : BenchTrackingAction::Instances()) counters->fSteps = counters->fPhotons = 0;
+
+    G4int n = (nEvents > 0) ? nEvents : workload->nEvents;
+    G4long rss0 = RssKB(), peak0 = PeakRssKB();
+    G4double cpu0 = CpuSeconds();
+    t0 = std::chrono::steady_clock::now();
+    runManager->BeamOn(n);
+    G4double wall = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - t0).count();
+    G4double cpu = CpuSeconds() - cpu0;
+    G4long rss = RssKB(), peak = PeakRssKB();
+
+    G4long steps = 0, photons = 0;
+    for (auto* counters : BenchTrackingAction::Instances()) {
+      steps += counters->fSteps;
+      photons += counters->fPhotons;
+    }
+    G4long bytes = FileSize(fileName + ".root");
+
+    std::ostringstream line;
+    line << "{\"workload\":\"" << workload->name << "\""
+         << ",\"geant4\":" << G4VERSION_NUMBER
+         << ",\"threads\":" << nThreads
+         << ",\"seed\":" << seed
+         << ",\"events\":" << n
+         << ",\"init_s\":" << initTime
+         << ",\"wall_s\":" << wall
+         << ",\"cpu_s\":" << cpu
+         << ",\"events_per_s\":" << (wall > 0. ? n / wall : 0.)
+         << ",\"photons_per_s\":" << (wall > 0. ? photons / wall : 0.)
+         << ",\"steps_per_s\":" << (wall > 0. ? steps / wall : 0.)
+         << ",\"optical_photons\":" << photons
+         << ",\"steps\":" << steps
+         << ",\"output_bytes_per_event\":" << (bytes >= 0 && n > 0 ? G4double(bytes) / n : -1.)
+         << ",\"rss_kb\":" << rss
+         << ",\"rss_delta_kb\":" << ((rss >= 0 && rss0 >= 0) ? rss - rss0 : 0)
+         << ",\"peak_rss_delta_kb\":" << peak - peak0
+         << ",\"peak_rss_kb\":" << peak
+         << "}";
+    out << line.str() << std::endl;
+  }
+
+  delete runManager;
+  return 0;
+}
@@ -0,0 +1,478 @@
+// det01_calib: energy calibration and jitter tables from det01 ntuples.
+//
+// Streams the event ntuple (CosmicData, or any /det01/output/ntupleName)
+// of one or more output files and prints, in the README format:
+//  - Energy calibration: Landau (Moyal) MPV of Edep_Scin<i> for events
+//    with at least --fold detectors above --edepMin; the reference energy
+//    is the mean MPV of the middle detectors (all but the first and last),
+//    matched to the experimental MPVs (--mpv, mV) as MeV/mV and mV/MeV.
+//  - Time resolution: variance of t_i - t_j for every detector pair (both
+//    with a time and, with --landauCut f, both above f x their MPV:
+//    software collimation), then the least-squares solution of
+//    sigma_i^2 + sigma_j^2 = sigma_ij^2 (6 equations, 4 unknowns for 4
+//    detectors). Times are Time_PMT<i> (first photon: optical spread) or,
+//    with --time digi, DigiTime_PMT<i> (/det01/output/digitized).
+//
+// Input files are read in parallel (-j threads, one file at a time per
+// thread): streaming shards, checkpoint parts, MPI ranks or scan jobs are
+// the chunks. Index files (*.txt: <name>_shards.txt, _parts.txt,
+// _ranks.txt) are expanded to the files they list. Every thread fills its
+// own histograms and pair moments, merged at the end; the Landau cut is
+// applied on a grid of --edepMax / 200 in both deposits, so one pass
+// serves any cut. Events are weighted with the Weight column.
+//
+// Usage: det01_calib [options] file.root|index.txt...
+//   -j threads  --ntuple name  --detectors n  --precision double|float
+//   --fold n (default: all)  --edepMin MeV  --edepMax MeV  --bins n
+//   --fitFraction f  --mpv mV,mV,...  --landauCut f  --time first|digi
+
+#include "G4RootAnalysisReader.hh"
+#include "G4Threading.hh"
+#include "globals.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const G4int kCutBins = 200;   // Landau-cut grid per axis
+
+struct Options {
+  G4String ntupleName = "CosmicData";
+  G4int nDet = 4;
+  G4bool useFloat = false;     // /det01/output/precision double
+  G4int fold = -1;              // -1: all detectors
+  G4double edepMin = 0.5;       // MeV
+  G4double edepMax = 100.;      // MeV
+  G4int bins = 1000;
+  G4double fitFraction = 0.2;
+  std::vector<G4double> mpvMeasured;   // mV
+  G4double landauCut = 0.;
+  G4bool digiTime = false;
+};
+
+// Weighted moments of t_i - t_j on the (Edep_i, Edep_j) cut grid
+struct PairMoments {
+  std::vector<G4double> sumW, sumWX, sumWXX;   // [cellI * kCutBins + cellJ]
+  void Init() { sumW.assign(kCutBins * kCutBins, 0.); sumWX = sumW; sumWXX = sumW; }
+};
+
+// Per-thread results
+struct Accumulators {
+  std::vector<std::vector<G4double>> hist, histW2;   // [det][bin] Edep
+  std::vector<PairMoments> pairs;                    // [pair]
+  G4long nRows = 0, nSelected = 0;
+  std::vector<G4String> errors;
+
+  void Init(const Options& opt)
+  {
+    hist.assign(opt.nDet, std::vector<G4double>(opt.bins, 0.));
+    histW2 = hist;
+    pairs.assign(opt.nDet * (opt.nDet - 1) / 2, PairMoments());
+    for (auto& p : pairs) p.Init();
+  }
+
+  void Add(const Accumulators& other)
+  {
+    for (size_t d=0; d<hist.size(); d++) {
+        for (size_t b=0; b<hist[d].size(); b++) {
+            hist[d][b] += other.hist[d][b];
+            histW2[d][b] += other.histW2[d][b];
+        }
+    }
+    for (size_t p=0; p<pairs.size(); p++) {
+        for (size_t c=0; c<pairs[p].sumW.size(); c++) {
+            pairs[p].sumW[c] += other.pairs[p].sumW[c];
+            pairs[p].sumWX[c] += other.pairs[p].sumWX[c];
+            pairs[p].sumWXX[c] += other.pairs[p].sumWXX[c];
+        }
+    }
+    nRows += other.nRows;
+    nSelected += other.nSelected;
+    errors.insert(errors.end(), other.errors.begin(), other.errors.end());
+  }
+};
+
+// Expand index files (one output file per line) into the file list
+void AddInput(const G4String& name, std::vector<G4String>& files)
+{
+  if (!G4StrUtil::ends_with(name, ".txt")) {
+      files.push_back(name);
+      return;
+  }
+  std::ifstream index(name);
+  G4String line;
+  while (std::getline(index, line)) {
+      G4StrUtil::strip(line);
+      if (line.empty()) continue;
+      if (!G4StrUtil::ends_with(line, ".root")) line += ".root";
+      files.push_back(line);
+  }
+}
+
+void ReadFile(const G4String& fileName, const Options& opt, Accumulators& acc)
+{
+  // Thread-local reader (the calling thread has a Geant4 thread id)
+  auto reader = G4RootAnalysisReader::Instance();
+  reader->SetVerboseLevel(0);
+
+  G4int ntupleId = reader->GetNtuple(opt.ntupleName, fileName);
+  if (ntupleId < 0) {
+      acc.errors.push_back("no " + opt.ntupleName + " ntuple in " + fileName);
+      return;
+  }
+
+  const G4int nDet = opt.nDet;
+  std::vector<G4double> edep(nDet, 0.), time(nDet, -1.);
+  std::vector<G4float> edepF(nDet, 0.), timeF(nDet, -1.);
+  G4double weight = 1.;
+  const G4String timeColumn = opt.digiTime ? "DigiTime_PMT" : "Time_PMT";
+  for (G4int i=0; i<nDet; i++) {
+      if (opt.useFloat) {
+          reader->SetNtupleFColumn(ntupleId, "Edep_Scin" + std::to_string(i), edepF[i]);
+          reader->SetNtupleFColumn(ntupleId, timeColumn + std::to_string(i), timeF[i]);
+      }
+      else {
+          reader->SetNtupleDColumn(ntupleId, "Edep_Scin" + std::to_string(i), edep[i]);
+          reader->SetNtupleDColumn(ntupleId, timeColumn + std::to_string(i), time[i]);
+      }
+  }
+  reader->SetNtupleDColumn(ntupleId, "Weight", weight);
+
+  const G4int fold = (opt.fold > 0) ? opt.fold : nDet;
+  const G4double binWidth = opt.edepMax / opt.bins;
+  const G4double cutWidth = opt.edepMax / kCutBins;
+  std::vector<G4int> cutCell(nDet);
+
+  while (reader->GetNtupleRow(ntupleId)) {
+      acc.nRows++;
+      if (opt.useFloat) {
+          for (G4int i=0; i<nDet; i++) { edep[i] = edepF[i]; time[i] = timeF[i]; }
+      }
+
+      G4int nFired = 0;
+      for (G4int i=0; i<nDet; i++) nFired += (edep[i] > opt.edepMin);
+      if (nFired < fold) continue;
+      acc.nSelected++;
+
+      for (G4int i=0; i<nDet; i++) {
+          G4int bin = G4int(edep[i] / binWidth);
+          if (edep[i] > opt.edepMin && bin < opt.bins) {
+              acc.hist[i][bin] += weight;
+              acc.histW2[i][bin] += weight * weight;
+          }
+          cutCell[i] = std::min(G4int(edep[i] / cutWidth), kCutBins - 1);
+      }
+
+      G4int pair = 0;
+      for (G4int i=0; i<nDet; i++) {
+          for (G4int j=i+1; j<nDet; j++, pair++) {
+              if (time[i] < 0. || time[j] < 0.) continue;
+              G4double dt = time[i] - time[j];
+              PairMoments& m = acc.pairs[pair];
+              G4int cell = cutCell[i] * kCutBins + cutCell[j];
+              m.sumW[cell] += weight;
+              m.sumWX[cell] += weight * dt;
+              m.sumWXX[cell] += weight * dt * dt;
+          }
+      }
+  }
+}
+
+// Moyal approximation of the Landau density, A exp(-(l + exp(-l)) / 2),
+// l = (x - mpv) / xi; least squares (Levenberg-Marquardt) on the bins above
+// fitFraction x peak around the peak. Returns false without a peak.
+G4bool FitLandau(const std::vector<G4double>& hist, const std::vector<G4double>& histW2,
+                 G4double binWidth, G4double fitFraction, G4double& mpv, G4double& xi)
+{
+  size_t peak = std::max_element(hist.begin(), hist.end()) - hist.begin();
+  if (hist[peak] <= 0.) return false;
+  size_t lo = peak, hi = peak;
+  while (lo > 0 && hist[lo-1] >= fitFraction * hist[peak]) lo--;
+  while (hi + 1 < hist.size() && hist[hi+1] >= fitFraction * hist[peak]) hi++;
+  if (hi - lo < 3) {
+      mpv = (peak + 0.5) * binWidth;
+      xi = 0.;
+      return true;
+  }
+
+  G4double p[3] = { hist[peak] / std::exp(-0.5), (peak + 0.5) * binWidth,
+                    std::max((hi - lo + 1) * binWidth / 3.6, binWidth) };
+  auto chi2 = [&](const G4double* q) {
+    G4double sum = 0.;
+    for (size_t b=lo; b<=hi; b++) {
+        G4double l = ((b + 0.5) * binWidth - q[1]) / q[2];
+        G4double r = hist[b] - q[0] * std::exp(-0.5 * (l + std::exp(-l)));
+        sum += r * r / std::max(histW2[b], 1.e-12);
+    }
+    return sum;
+  };
+
+  G4double lambda = 1.e-3;
+  G4double current = chi2(p);
+  for (G4int iter=0; iter<200; iter++) {
+      // Normal equations J^T W J, J^T W r
+      G4double jtj[3][3] = {{0.}}, jtr[3] = {0.};
+      for (size_t b=lo; b<=hi; b++) {
+          G4double x = (b + 0.5) * binWidth;
+          G4double l = (x - p[1]) / p[2];
+          G4double e = std::exp(-0.5 * (l + std::exp(-l)));
+          G4double f = p[0] * e;
+          G4double dfdl = -0.5 * f * (1. - std::exp(-l));
+          G4double grad[3] = { e, -dfdl / p[2], -dfdl * l / p[2] };
+          G4double w = 1. / std::max(histW2[b], 1.e-12);
+          G4double r = hist[b] - f;
+          for (G4int a=0; a<3; a++) {
+              jtr[a] += w * grad[a] * r;
+              for (G4int c=0; c<3; c++) jtj[a][c] += w * grad[a] * grad[c];
+          }
+      }
+      // Solve (J^T W J + lambda diag) delta = J^T W r (Cramer, 3x3)
+      G4double m[3][3];
+      for (G4int a=0; a<3; a++) {
+          for (G4int c=0; c<3; c++) m[a][c] = jtj[a][c] * ((a == c) ? 1. + lambda : 1.);
+      }
+      auto det3 = [](G4double q[3][3]) {
+        return q[0][0] * (q[1][1] * q[2][2] - q[1][2] * q[2][1])
+             - q[0][1] * (q[1][0] * q[2][2] - q[1][2] * q[2][0])
+             + q[0][2] * (q[1][0] * q[2][1] - q[1][1] * q[2][0]);
+      };
+      G4double d = det3(m);
+      if (d == 0.) break;
+      G4double trial[3];
+      for (G4int k=0; k<3; k++) {
+          G4double mk[3][3];
+          for (G4int a=0; a<3; a++) {
+              for (G4int c=0; c<3; c++) mk[a][c] = (c == k) ? jtr[a] : m[a][c];
+          }
+          trial[k] = p[k] + det3(mk) / d;
+      }
+      if (trial[2] <= 0.) { lambda *= 10.; continue; }
+
+      G4double next = chi2(trial);
+      if (next < current) {
+          G4bool converged = std::fabs(current - next) < 1.e-8 * std::max(current, 1.);
+          std::copy(trial, trial + 3, p);
+          current = next;
+          lambda = std::max(lambda / 10., 1.e-12);
+          if (converged) break;
+      }
+      else {
+          lambda *= 10.;
+          if (lambda > 1.e12) break;
+      }
+  }
+  mpv = p[1];
+  xi = p[2];
+  return true;
+}
+
+// Least squares of s_i + s_j = v_ij (normal equations, Gaussian elimination)
+std::vector<G4double> SolvePairVariances(G4int nDet, const std::vector<G4double>& pairVariance,
+                                         const std::vector<G4bool>& pairValid)
+{
+  std::vector<std::vector<G4double>> a(nDet, std::vector<G4double>(nDet + 1, 0.));
+  G4int pair = 0;
+  for (G4int i=0; i<nDet; i++) {
+      for (G4int j=i+1; j<nDet; j++, pair++) {
+          if (!pairValid[pair]) continue;
+          a[i][i] += 1.; a[j][j] += 1.; a[i][j] += 1.; a[j][i] += 1.;
+          a[i][nDet] += pairVariance[pair];
+          a[j][nDet] += pairVariance[pair];
+      }
+  }
+  std::vector<G4double> s(nDet, -1.);
+  for (G4int c=0; c<nDet; c++) {
+      G4int pivot = c;
+      for (G4int r=c+1; r<nDet; r++) {
+          if (std::fabs(a[r][c]) > std::fabs(a[pivot][c])) pivot = r;
+      }
+      if (std::fabs(a[pivot][c]) < 1.e-12) return s;   // underdetermined
+      std::swap(a[c], a[pivot]);
+      for (G4int r=0; r<nDet; r++) {
+          if (r == c) continue;
+          G4double factor = a[r][c] / a[c][c];
+          for (G4int k=c; k<=nDet; k++) a[r][k] -= factor * a[c][k];
+      }
+  }
+  for (G4int i=0; i<nDet; i++) s[i] = a[i][nDet] / a[i][i];
+  return s;
+}
+
+void PrintUsage()
+{
+  std::cerr << "Usage: det01_calib [options] file.root|index.txt..." << std::endl
+            << "  -j threads  --ntuple name  --detectors n  --precision float|double" << std::endl
+            << "  --fold n  --edepMin MeV  --edepMax MeV  --bins n  --fitFraction f" << std::endl
+            << "  --mpv mV,mV,...  --landauCut f  --time first|digi" << std::endl;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  Options opt;
+  G4int nThreads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<G4String> files;
+
+  for (G4int i=1; i<argc; i++) {
+      G4String arg = argv[i];
+      G4bool hasValue = (i+1 < argc);
+      if (arg == "-j" && hasValue) nThreads = std::max(1, std::atoi(argv[++i]));
+      else if (arg == "--ntuple" && hasValue) opt.ntupleName = argv[++i];
+      else if (arg == "--detectors" && hasValue) opt.nDet = std::atoi(argv[++i]);
+      else if (arg == "--precision" && hasValue) opt.useFloat = (G4String(argv[++i]) == "float");
+      else if (arg == "--fold" && hasValue) opt.fold = std::atoi(argv[++i]);
+      else if (arg == "--edepMin" && hasValue) opt.edepMin = std::atof(argv[++i]);
+      else if (arg == "--edepMax" && hasValue) opt.edepMax = std::atof(argv[++i]);
+      else if (arg == "--bins" && hasValue) opt.bins = std::atoi(argv[++i]);
+      else if (arg == "--fitFraction" && hasValue) opt.fitFraction = std::atof(argv[++i]);
+      else if (arg == "--landauCut" && hasValue) opt.landauCut = std::atof(argv[++i]);
+      else if (arg == "--time" && hasValue) opt.digiTime = (G4String(argv[++i]) == "digi");
+      else if (arg == "--mpv" && hasValue) {
+          std::stringstream list(argv[++i]);
+          G4String value;
+          while (std::getline(list, value, ',')) opt.mpvMeasured.push_back(std::atof(value.c_str()));
+      }
+      else if (arg[0] != '-') AddInput(arg, files);
+      else {
+          PrintUsage();
+          return 1;
+      }
+  }
+  if (files.empty() || opt.nDet < 2 || opt.bins <= 0 || opt.edepMax <= 0.) {
+      PrintUsage();
+      return 1;
+  }
+  nThreads = std::min<G4int>(nThreads, files.size());
+
+  // One file at a time per thread, thread-local accumulators
+  std::vector<Accumulators> perThread(nThreads);
+  std::atomic<size_t> next(0);
+  std::vector<std::thread> threads;
+  for (G4int t=0; t<nThreads; t++) {
+      threads.emplace_back([&, t]() {
+        G4Threading::G4SetThreadId(t);
+        perThread[t].Init(opt);
+        for (size_t f; (f = next.fetch_add(1)) < files.size(); ) ReadFile(files[f], opt, perThread[t]);
+      });
+  }
+  for (auto& thread : threads) thread.join();
+
+  Accumulators total;
+  total.Init(opt);
+  for (const auto& acc : perThread) total.Add(acc);
+  for (const auto& error : total.errors) std::cerr << "det01_calib: " << error << std::endl;
+
+  const G4int nDet = opt.nDet;
+  std::cout << "det01_calib: " << total.nRows << " events from " << files.size() << " file(s), "
+            << total.nSelected << " with >= " << ((opt.fold > 0) ? opt.fold : nDet)
+            << " detectors above " << opt.edepMin << " MeV" << std::endl << std::endl;
+
+  // Energy calibration
+  const G4double binWidth = opt.edepMax / opt.bins;
+  std::vector<G4double> mpv(nDet, 0.);
+  for (G4int i=0; i<nDet; i++) {
+      G4double xi;
+      if (!FitLandau(total.hist[i], total.histW2[i], binWidth, opt.fitFraction, mpv[i], xi)) mpv[i] = 0.;
+  }
+  G4double reference = 0.;
+  G4int nMiddle = 0;
+  for (G4int i=(nDet > 2 ? 1 : 0); i<(nDet > 2 ? nDet - 1 : nDet); i++) {
+      reference += mpv[i];
+      nMiddle++;
+  }
+  reference /= nMiddle;
+
+  std::cout << std::fixed;
+  std::cout << "### Energy Calibration" << std::endl
+            << "**Reference Energy (Simulation):** " << std::setprecision(2) << reference
+            << " MeV (Average of middle detectors";
+  for (G4int i=(nDet > 2 ? 1 : 0); i<(nDet > 2 ? nDet - 1 : nDet); i++) std::cout << " Scin" << i;
+  std::cout << ")." << std::endl << std::endl;
+
+  if (G4int(opt.mpvMeasured.size()) == nDet) {
+      std::cout << "| Detector | Experimental MPV (mV) | Calibration Constant (MeV/mV) | 1 MeV Signal (mV) |" << std::endl
+                << "| :--- | :--- | :--- | :--- |" << std::endl;
+      for (G4int i=0; i<nDet; i++) {
+          std::cout << "| **Det " << i + 1 << "** | " << std::setprecision(2) << opt.mpvMeasured[i]
+                    << " | **" << std::setprecision(4) << reference / opt.mpvMeasured[i] << "** | "
+                    << std::setprecision(2) << opt.mpvMeasured[i] / reference << " |" << std::endl;
+      }
+  }
+  else {
+      if (!opt.mpvMeasured.empty()) {
+          std::cerr << "det01_calib: --mpv needs " << nDet << " values" << std::endl;
+      }
+      std::cout << "| Detector | Simulated MPV (MeV) |" << std::endl
+                << "| :--- | :--- |" << std::endl;
+      for (G4int i=0; i<nDet; i++) {
+          std::cout << "| **Det " << i + 1 << "** | " << std::setprecision(2) << mpv[i] << " |" << std::endl;
+      }
+  }
+  std::cout << std::endl;
+
+  // Pair variances above the Landau cut (each detector above cut x its MPV)
+  const G4double cutWidth = opt.edepMax / kCutBins;
+  std::vector<G4int> firstCell(nDet, 0);
+  for (G4int i=0; i<nDet; i++) {
+      if (opt.landauCut > 0.) firstCell[i] = std::min(G4int(std::ceil(opt.landauCut * mpv[i] / cutWidth)), kCutBins);
+  }
+  const size_t nPairs = nDet * (nDet - 1) / 2;
+  std::vector<G4double> pairVariance(nPairs, 0.);
+  std::vector<G4bool> pairValid(nPairs, false);
+  size_t pair = 0;
+  for (G4int i=0; i<nDet; i++) {
+      for (G4int j=i+1; j<nDet; j++, pair++) {
+          const PairMoments& m = total.pairs[pair];
+          G4double w = 0., wx = 0., wxx = 0.;
+          for (G4int ci=firstCell[i]; ci<kCutBins; ci++) {
+              for (G4int cj=firstCell[j]; cj<kCutBins; cj++) {
+                  G4int cell = ci * kCutBins + cj;
+                  w += m.sumW[cell]; wx += m.sumWX[cell]; wxx += m.sumWXX[cell];
+              }
+          }
+          if (w <= 0.) continue;
+          G4double mean = wx / w;
+          pairVariance[pair] = std::max(wxx / w - mean * mean, 0.);
+          pairValid[pair] = true;
+      }
+  }
+  std::vector<G4double> s = SolvePairVariances(nDet, pairVariance, pairValid);
+
+  std::cout << "### Time Resolution" << std::endl
+            << "**Methodology:** Least-squares solution of " << std::count(pairValid.begin(), pairValid.end(), true)
+            << " pairwise variances (" << (opt.digiTime ? "DigiTime_PMT, CFD" : "Time_PMT, first photon");
+  if (opt.landauCut > 0.) std::cout << ", Landau cut " << std::setprecision(2) << opt.landauCut << " x MPV";
+  std::cout << ")." << std::endl << std::endl
+            << "| Detector | Intrinsic Jitter ($\\sigma$) | Resolution (FWHM) |" << std::endl
+            << "| :--- | :--- | :--- |" << std::endl;
+  const G4double fwhm = 2. * std::sqrt(2. * std::log(2.));
+  G4double sum = 0.;
+  G4int nValid = 0;
+  std::cout << std::setprecision(3);
+  for (G4int i=0; i<nDet; i++) {
+      std::cout << "| **Det " << i + 1 << "** | ";
+      if (s[i] < 0.) {
+          std::cout << "n/a | n/a |" << std::endl;
+          continue;
+      }
+      G4double sigma = std::sqrt(s[i]);
+      std::cout << sigma << " ns | " << fwhm * sigma << " ns |" << std::endl;
+      sum += sigma;
+      nValid++;
+  }
+  if (nValid > 0) {
+      std::cout << "| **Average** | **" << sum / nValid << " ns** | **" << fwhm * sum / nValid << " ns** |" << std::endl;
+  }
+  return total.errors.empty() ? 0 : 2;
+}
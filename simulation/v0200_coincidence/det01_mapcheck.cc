@@ -0,0 +1,155 @@
+// det01_mapcheck: compare a test run against a reference run.
+//
+// Compares the per-detector energy deposit, photoelectron and first-photon
+// time spectra of two runs with the same source (full vs fast optics, or
+// reference vs light physics variant) and prints mean, RMS and the
+// Kolmogorov-Smirnov distance for each detector.
+//
+// Usage: det01_mapcheck <reference.root> <test.root> [nDetectors] [double|float] [maxKS] [edep|all]
+// (double|float is the /det01/output/precision the runs were written with;
+// with maxKS the exit code is 2 if any Edep KS distance exceeds it, or any
+// Edep, PE or Time KS distance with "all", e.g. for reduced-yield optics)
+
+#include "G4RootAnalysisReader.hh"
+#include "globals.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+struct Spectra {
+  std::vector<std::vector<G4double>> edep;  // [det][event], events with a deposit
+  std::vector<std::vector<G4double>> pe;    // [det][event]
+  std::vector<std::vector<G4double>> time;  // [det][event], hit events only
+};
+
+G4bool ReadSpectra(G4RootAnalysisReader* reader, const G4String& fileName,
+                   G4int nDet, G4bool useFloat, Spectra& out)
+{
+  G4int ntupleId = reader->GetNtuple("CosmicData", fileName);
+  if (ntupleId < 0) {
+      std::cerr << "det01_mapcheck: no CosmicData ntuple in " << fileName << std::endl;
+      return false;
+  }
+
+  std::vector<G4int> pe(nDet, 0);
+  std::vector<G4double> time(nDet, 0.), edep(nDet, 0.);
+  std::vector<G4float> timeF(nDet, 0.), edepF(nDet, 0.);
+  for (G4int i=0; i<nDet; i++) {
+      if (useFloat) reader->SetNtupleFColumn(ntupleId, "Edep_Scin" + std::to_string(i), edepF[i]);
+      else reader->SetNtupleDColumn(ntupleId, "Edep_Scin" + std::to_string(i), edep[i]);
+      reader->SetNtupleIColumn(ntupleId, "PE_PMT" + std::to_string(i), pe[i]);
+      if (useFloat) reader->SetNtupleFColumn(ntupleId, "Time_PMT" + std::to_string(i), timeF[i]);
+      else reader->SetNtupleDColumn(ntupleId, "Time_PMT" + std::to_string(i), time[i]);
+  }
+
+  out.edep.assign(nDet, {});
+  out.pe.assign(nDet, {});
+  out.time.assign(nDet, {});
+  while (reader->GetNtupleRow(ntupleId)) {
+      for (G4int i=0; i<nDet; i++) {
+          if (useFloat) { time[i] = timeF[i]; edep[i] = edepF[i]; }
+          if (edep[i] > 0.) out.edep[i].push_back(edep[i]);
+          out.pe[i].push_back(pe[i]);
+          if (pe[i] > 0) out.time[i].push_back(time[i]);
+      }
+  }
+  return true;
+}
+
+void MeanRms(const std::vector<G4double>& v, G4double& mean, G4double& rms)
+{
+  mean = 0.; rms = 0.;
+  if (v.empty()) return;
+  for (auto x : v) mean += x;
+  mean /= v.size();
+  for (auto x : v) rms += (x - mean) * (x - mean);
+  rms = std::sqrt(rms / v.size());
+}
+
+// Two-sample Kolmogorov-Smirnov distance
+G4double KSDistance(std::vector<G4double> a, std::vector<G4double> b)
+{
+  if (a.empty() || b.empty()) return 1.;
+  std::sort(a.begin(), a.end());
+  std::sort(b.begin(), b.end());
+
+  size_t i = 0, j = 0;
+  G4double d = 0.;
+  while (i < a.size() && j < b.size()) {
+      G4double x = std::min(a[i], b[j]);
+      while (i < a.size() && a[i] <= x) i++;
+      while (j < b.size() && b[j] <= x) j++;
+      d = std::max(d, std::fabs(G4double(i) / a.size() - G4double(j) / b.size()));
+  }
+  return d;
+}
+
+G4double PrintRow(const char* label, G4int det,
+                  const std::vector<G4double>& ref, const std::vector<G4double>& test)
+{
+  G4double refMean, refRms, testMean, testRms;
+  MeanRms(ref, refMean, refRms);
+  MeanRms(test, testMean, testRms);
+  G4double ks = KSDistance(ref, test);
+
+  std::cout << std::setw(6) << label << std::setw(5) << det
+            << std::setw(12) << refMean << std::setw(12) << refRms
+            << std::setw(12) << testMean << std::setw(12) << testRms
+            << std::setw(10) << ks << std::endl;
+  return ks;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 3) {
+      std::cerr << "Usage: det01_mapcheck <reference.root> <test.root> [nDetectors] [double|float] [maxKS] [edep|all]" << std::endl;
+      return 1;
+  }
+  G4int nDet = (argc > 3) ? std::atoi(argv[3]) : 4;
+  G4bool useFloat = (argc > 4) && G4String(argv[4]) == "float";
+  G4double maxKS = (argc > 5) ? std::atof(argv[5]) : -1.;
+  G4bool gateAll = (argc > 6) && G4String(argv[6]) == "all";
+
+  auto reader = G4RootAnalysisReader::Instance();
+  reader->SetVerboseLevel(0);
+
+  Spectra ref, test;
+  if (!ReadSpectra(reader, argv[1], nDet, useFloat, ref)) return 1;
+  if (!ReadSpectra(reader, argv[2], nDet, useFloat, test)) return 1;
+
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << "Reference: " << argv[1] << "  Test: " << argv[2] << std::endl;
+  std::cout << std::setw(6) << "" << std::setw(5) << "PMT"
+            << std::setw(12) << "ref mean" << std::setw(12) << "ref rms"
+            << std::setw(12) << "test mean" << std::setw(12) << "test rms"
+            << std::setw(10) << "KS" << std::endl;
+
+  G4double worstEdep = 0., worstOptics = 0.;
+  for (G4int i=0; i<nDet; i++) {
+      worstEdep = std::max(worstEdep, PrintRow("Edep", i, ref.edep[i], test.edep[i]));
+  }
+  for (G4int i=0; i<nDet; i++) {
+      worstOptics = std::max(worstOptics, PrintRow("PE", i, ref.pe[i], test.pe[i]));
+  }
+  for (G4int i=0; i<nDet; i++) {
+      worstOptics = std::max(worstOptics, PrintRow("Time", i, ref.time[i], test.time[i]));
+  }
+
+  if (maxKS >= 0.) {
+      G4double worst = gateAll ? std::max(worstEdep, worstOptics) : worstEdep;
+      G4bool pass = worst <= maxKS;
+      std::cout << (gateAll ? "Edep/PE/Time KS " : "Edep KS ") << worst
+                << (pass ? " <= " : " > ") << maxKS
+                << (pass ? ": PASS" : ": FAIL") << std::endl;
+      if (!pass) return 2;
+  }
+  return 0;
+}
@@ -0,0 +1,139 @@
+// det01_ratecheck: compare the weighted rates of a biased run with an analog run.
+//
+// For each detector, the rate of events with a scintillator deposit above
+// a threshold is estimated from the Weight column, R = sum(w) / N over the
+// N events of the run (all events written: trigger off), with its
+// statistical error from sum(w^2). The mean weight of all events (1 for an
+// unbiased estimator) is checked the same way. Analog runs have weight 1.
+//
+// Usage: det01_ratecheck <analog.root> <biased.root> [nDetectors] [double|float] [maxPull] [threshold/MeV]
+// (double|float is the /det01/output/precision the runs were written with;
+// with maxPull the exit code is 2 if any |biased - analog| / sigma exceeds it)
+
+#include "G4RootAnalysisReader.hh"
+#include "globals.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+struct Rate {
+  G4double sumW = 0.;
+  G4double sumW2 = 0.;
+};
+
+struct Rates {
+  G4long events = 0;
+  Rate all;
+  std::vector<Rate> det;
+};
+
+G4bool ReadRates(G4RootAnalysisReader* reader, const G4String& fileName,
+                 G4int nDet, G4bool useFloat, G4double threshold, Rates& out)
+{
+  G4int ntupleId = reader->GetNtuple("CosmicData", fileName);
+  if (ntupleId < 0) {
+      std::cerr << "det01_ratecheck: no CosmicData ntuple in " << fileName << std::endl;
+      return false;
+  }
+
+  G4double weight = 1.;
+  std::vector<G4double> edep(nDet, 0.);
+  std::vector<G4float> edepF(nDet, 0.);
+  reader->SetNtupleDColumn(ntupleId, "Weight", weight);
+  for (G4int i=0; i<nDet; i++) {
+      if (useFloat) reader->SetNtupleFColumn(ntupleId, "Edep_Scin" + std::to_string(i), edepF[i]);
+      else reader->SetNtupleDColumn(ntupleId, "Edep_Scin" + std::to_string(i), edep[i]);
+  }
+
+  out = Rates();
+  out.det.assign(nDet, Rate());
+  auto add = [&](Rate& rate) { rate.sumW += weight; rate.sumW2 += weight * weight; };
+  while (reader->GetNtupleRow(ntupleId)) {
+      out.events++;
+      add(out.all);
+      for (G4int i=0; i<nDet; i++) {
+          if (useFloat) edep[i] = edepF[i];
+          if (edep[i] > threshold) add(out.det[i]);
+      }
+  }
+  if (out.events == 0) {
+      std::cerr << "det01_ratecheck: no events in " << fileName << std::endl;
+      return false;
+  }
+  return true;
+}
+
+// Rate per event and its error
+void Estimate(const Rate& rate, G4long events, G4double& value, G4double& error)
+{
+  value = rate.sumW / events;
+  error = std::sqrt(std::max(rate.sumW2 / events - value * value, 0.) / events);
+}
+
+G4double PrintRow(const char* label, G4int det,
+                  const Rate& analog, G4long analogEvents,
+                  const Rate& biased, G4long biasedEvents)
+{
+  G4double analogRate, analogError, biasedRate, biasedError;
+  Estimate(analog, analogEvents, analogRate, analogError);
+  Estimate(biased, biasedEvents, biasedRate, biasedError);
+  G4double sigma = std::sqrt(analogError * analogError + biasedError * biasedError);
+  G4double pull = (sigma > 0.) ? (biasedRate - analogRate) / sigma : 0.;
+
+  std::cout << std::setw(6) << label;
+  if (det >= 0) std::cout << std::setw(5) << det;
+  else std::cout << std::setw(5) << "";
+  std::cout << std::setw(12) << analogRate << std::setw(10) << analogError
+            << std::setw(12) << biasedRate << std::setw(10) << biasedError
+            << std::setw(8) << pull << std::endl;
+  return std::fabs(pull);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 3) {
+      std::cerr << "Usage: det01_ratecheck <analog.root> <biased.root> [nDetectors] [double|float] [maxPull] [threshold/MeV]" << std::endl;
+      return 1;
+  }
+  G4int nDet = (argc > 3) ? std::atoi(argv[3]) : 4;
+  G4bool useFloat = (argc > 4) && G4String(argv[4]) == "float";
+  G4double maxPull = (argc > 5) ? std::atof(argv[5]) : -1.;
+  G4double threshold = (argc > 6) ? std::atof(argv[6]) : 0.;
+
+  auto reader = G4RootAnalysisReader::Instance();
+  reader->SetVerboseLevel(0);
+
+  Rates analog, biased;
+  if (!ReadRates(reader, argv[1], nDet, useFloat, threshold, analog)) return 1;
+  if (!ReadRates(reader, argv[2], nDet, useFloat, threshold, biased)) return 1;
+
+  std::cout << std::fixed << std::setprecision(5);
+  std::cout << "Analog: " << argv[1] << " (" << analog.events << " events)  Biased: "
+            << argv[2] << " (" << biased.events << " events)" << std::endl;
+  std::cout << std::setw(6) << "" << std::setw(5) << "PMT"
+            << std::setw(12) << "analog" << std::setw(10) << "error"
+            << std::setw(12) << "biased" << std::setw(10) << "error"
+            << std::setw(8) << "pull" << std::endl;
+
+  G4double worst = PrintRow("All", -1, analog.all, analog.events, biased.all, biased.events);
+  for (G4int i=0; i<nDet; i++) {
+      worst = std::max(worst, PrintRow("Hit", i, analog.det[i], analog.events,
+                                       biased.det[i], biased.events));
+  }
+
+  if (maxPull >= 0.) {
+      G4bool pass = worst <= maxPull;
+      std::cout << "Weighted rate pull " << worst << (pass ? " <= " : " > ") << maxPull
+                << (pass ? ": PASS" : ": FAIL") << std::endl;
+      if (!pass) return 2;
+  }
+  return 0;
+}
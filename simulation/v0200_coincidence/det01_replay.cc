@@ -0,0 +1,289 @@
+// det01_replay: re-digitize photon-time sidecars without Geant4.
+//
+// Reads the <name>_photons[_t<i>].bin sidecars of det01 runs
+// (/det01/output/photonTimes true), folds the PMT response again (TTS,
+// single-PE gain spread, template, noise, CFD: DET01PmtResponse, the model
+// of DET01PmtDigitizer), applies a PMT trigger and writes the accepted
+// events to a ROOT ntuple (ReplayData):
+//   EventID, File (index on the command line), DigiAmp_PMT<i> [mV],
+//   DigiTime_PMT<i> (CFD, -1: none), NFired
+// A PMT fires when it has a CFD time and at least --trigAmp; an event is
+// accepted with at least --multiplicity fired PMTs whose CFD times lie
+// within --window (0: any spread).
+//
+// Events are decoded straight from the memory-mapped sidecars and spread
+// over -j threads, one block of records at a time; each block is written
+// in record order before the next one starts, so the digitized results
+// take one block of memory whatever the input size. The record index (file,
+// event: 16 bytes per event of all inputs) is the only part that grows with
+// the input. The random numbers of an event depend only on the seed, its
+// file and its record, so the output does not change with -j.
+//
+// Usage: det01_replay [options] -o out.root sidecar.bin...
+//   -j threads (default: all cores)  -s seed  -o output
+//   response : --gain mV --gainSpread rel --tts ns --noise mV
+//   template : --riseTime ns --fallTime ns --templateFile file
+//   sampling : --samplePeriod ns --samples n --preTrigger ns
+//   CFD      : --cfdFraction f --cfdDelay ns --threshold mV --baselineTime ns
+//   trigger  : --multiplicity n --window ns --trigAmp mV
+// Defaults are the /det01/digi/ defaults.
+
+#include "G4RootAnalysisManager.hh"
+#include "globals.hh"
+
+#include "DET01PhotonTimes.hh"
+#include "DET01PmtResponse.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// All times in ns, amplitudes in mV
+struct Settings {
+  DET01PmtResponse::Settings pmt;
+  int multiplicity = 1;
+  double window = 0.;
+  double trigAmp = 0.;
+};
+
+struct Result {
+  long eventID = 0;
+  int file = 0;
+  int nFired = 0;
+  bool accepted = false;
+  std::vector<float> amplitude, time;
+};
+
+struct Record {
+  int file;
+  std::size_t index;
+};
+
+// Standard normal deviates for DET01PmtResponse
+struct Gauss {
+  std::mt19937_64 engine;
+  std::normal_distribution<double> normal;
+  double operator()() { return normal(engine); }
+};
+
+std::uint64_t SplitMix64(std::uint64_t x)
+{
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+// One per thread: DET01PmtResponse with per-PMT seeded engines
+class Replayer
+{
+  public:
+    Replayer(const Settings& settings, const std::vector<float>& pulseTemplate)
+     : fSettings(settings), fResponse(settings.pmt, pulseTemplate)
+    {}
+
+    void Process(const DET01PhotonTimesReader& reader, const Record& record,
+                 std::uint64_t seed, Result& result)
+    {
+      // The slot held an event of the previous block
+      result.nFired = 0;
+      result.accepted = false;
+
+      reader.Read(record.index, result.eventID, fPeTimes);
+      const int nPmts = fPeTimes.size();
+      result.file = record.file;
+      result.amplitude.assign(nPmts, 0.f);
+      result.time.assign(nPmts, -1.f);
+
+      // Common window start of the event (sidecar times are sorted)
+      double first = -1.;
+      for (const auto& t : fPeTimes) {
+          if (!t.empty() && (first < 0. || t.front() < first)) first = t.front();
+      }
+      if (first < 0.) return;
+      const double windowStart = first - fSettings.pmt.preTrigger;
+
+      for (int pmt=0; pmt<nPmts; pmt++) {
+          const std::vector<double>& peTimes = fPeTimes[pmt];
+          if (peTimes.empty()) continue;
+
+          // The distribution caches a deviate: reset it with the engine
+          fGauss.engine.seed(SplitMix64(seed ^ SplitMix64((std::uint64_t(record.file) << 48)
+                                                         ^ (std::uint64_t(record.index) << 8) ^ pmt)));
+          fGauss.normal.reset();
+
+          DET01Waveform::Pulse pulse = fResponse.Digitize(peTimes.data(), peTimes.size(),
+                                                          windowStart, fGauss);
+          result.amplitude[pmt] = pulse.amplitude;
+          result.time[pmt] = pulse.time;
+      }
+
+      // Trigger: fired PMTs within the coincidence window
+      float tMin = 0.f, tMax = 0.f;
+      for (int pmt=0; pmt<nPmts; pmt++) {
+          if (result.time[pmt] < 0.f || result.amplitude[pmt] < fSettings.trigAmp) continue;
+          if (result.nFired == 0 || result.time[pmt] < tMin) tMin = result.time[pmt];
+          if (result.nFired == 0 || result.time[pmt] > tMax) tMax = result.time[pmt];
+          result.nFired++;
+      }
+      result.accepted = result.nFired >= fSettings.multiplicity
+                     && (fSettings.window <= 0. || tMax - tMin <= fSettings.window);
+    }
+
+  private:
+    const Settings& fSettings;
+    DET01PmtResponse fResponse;
+
+    Gauss fGauss;
+    std::vector<std::vector<double>> fPeTimes;
+};
+
+void PrintUsage()
+{
+  std::cerr << "Usage: det01_replay [options] -o out.root sidecar.bin..." << std::endl
+            << "  -j threads  -s seed  -o output" << std::endl
+            << "  --gain --gainSpread --tts --noise --riseTime --fallTime --templateFile" << std::endl
+            << "  --samplePeriod --samples --preTrigger --cfdFraction --cfdDelay --threshold" << std::endl
+            << "  --baselineTime --multiplicity --window --trigAmp" << std::endl
+            << "  (times in ns, amplitudes in mV; defaults as /det01/digi/)" << std::endl;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  Settings settings;
+  std::map<std::string, double*> realOptions = {
+    { "--gain", &settings.pmt.gain }, { "--gainSpread", &settings.pmt.gainSpread },
+    { "--tts", &settings.pmt.tts }, { "--noise", &settings.pmt.noise },
+    { "--riseTime", &settings.pmt.riseTime }, { "--fallTime", &settings.pmt.fallTime },
+    { "--samplePeriod", &settings.pmt.samplePeriod }, { "--preTrigger", &settings.pmt.preTrigger },
+    { "--cfdFraction", &settings.pmt.cfdFraction }, { "--cfdDelay", &settings.pmt.cfdDelay },
+    { "--threshold", &settings.pmt.threshold }, { "--baselineTime", &settings.pmt.baselineTime },
+    { "--window", &settings.window }, { "--trigAmp", &settings.trigAmp } };
+
+  int nThreads = std::max(1u, std::thread::hardware_concurrency());
+  std::uint64_t seed = 12345;
+  std::string outName = "DET01_Replay.root";
+  std::vector<std::string> inputs;
+
+  for (int i=1; i<argc; i++) {
+      std::string arg = argv[i];
+      if (i+1 < argc && realOptions.count(arg)) *realOptions[arg] = std::atof(argv[++i]);
+      else if (arg == "--samples" && i+1 < argc) settings.pmt.samples = std::atoi(argv[++i]);
+      else if (arg == "--multiplicity" && i+1 < argc) settings.multiplicity = std::atoi(argv[++i]);
+      else if (arg == "--templateFile" && i+1 < argc) settings.pmt.templateFile = argv[++i];
+      else if (arg == "-j" && i+1 < argc) nThreads = std::max(1, std::atoi(argv[++i]));
+      else if (arg == "-s" && i+1 < argc) seed = std::strtoull(argv[++i], nullptr, 10);
+      else if (arg == "-o" && i+1 < argc) outName = argv[++i];
+      else if (arg[0] != '-') inputs.push_back(arg);
+      else {
+          PrintUsage();
+          return 1;
+      }
+  }
+  if (inputs.empty() || settings.pmt.samples <= 0 || settings.pmt.samplePeriod <= 0.) {
+      PrintUsage();
+      return 1;
+  }
+
+  // Single-PE template, shared by the threads
+  std::vector<float> pulseTemplate = DET01PmtResponse::BuildTemplate(settings.pmt);
+  if (pulseTemplate.empty()) {
+      std::cerr << "det01_replay: cannot read single-PE template " << settings.pmt.templateFile << std::endl;
+      return 1;
+  }
+
+  // Map the sidecars
+  std::vector<std::unique_ptr<DET01PhotonTimesReader>> readers;
+  std::vector<Record> records;
+  int nPmts = -1;
+  for (std::size_t f=0; f<inputs.size(); f++) {
+      auto reader = std::make_unique<DET01PhotonTimesReader>();
+      std::string error;
+      if (!reader->Open(inputs[f], error)) {
+          std::cerr << "det01_replay: " << error << std::endl;
+          return 1;
+      }
+      if (nPmts >= 0 && reader->GetNPmts() != nPmts) {
+          std::cerr << "det01_replay: " << inputs[f] << " has " << reader->GetNPmts()
+                    << " PMTs, expected " << nPmts << std::endl;
+          return 1;
+      }
+      nPmts = reader->GetNPmts();
+      for (std::size_t i=0; i<reader->GetNEvents(); i++) records.push_back({ int(f), i });
+      readers.push_back(std::move(reader));
+  }
+
+  // Output: the accepted events
+  auto analysisManager = G4RootAnalysisManager::Instance();
+  analysisManager->SetVerboseLevel(0);
+  if (!analysisManager->OpenFile(outName)) {
+      std::cerr << "det01_replay: cannot open " << outName << std::endl;
+      return 1;
+  }
+  G4int ntupleId = analysisManager->CreateNtuple("ReplayData", "DET01 replayed digitization");
+  analysisManager->CreateNtupleIColumn(ntupleId, "EventID");
+  analysisManager->CreateNtupleIColumn(ntupleId, "File");
+  for (G4int i=0; i<nPmts; i++) analysisManager->CreateNtupleFColumn(ntupleId, "DigiAmp_PMT" + std::to_string(i));
+  for (G4int i=0; i<nPmts; i++) analysisManager->CreateNtupleFColumn(ntupleId, "DigiTime_PMT" + std::to_string(i));
+  analysisManager->CreateNtupleIColumn(ntupleId, "NFired");
+  analysisManager->FinishNtuple(ntupleId);
+
+  // Digitize in parallel (chunks of a block of events), then write the
+  // block in record order
+  auto start = std::chrono::steady_clock::now();
+  const std::size_t blockSize = 65536;
+  const std::size_t chunk = 256;
+  std::vector<Result> results(std::min(blockSize, records.size()));
+  std::size_t nAccepted = 0;
+  for (std::size_t blockBegin=0; blockBegin<records.size(); blockBegin+=blockSize) {
+      const std::size_t blockEnd = std::min(blockBegin + blockSize, records.size());
+      std::atomic<std::size_t> next(blockBegin);
+      auto work = [&]() {
+          Replayer replayer(settings, pulseTemplate);
+          for (std::size_t begin; (begin = next.fetch_add(chunk)) < blockEnd; ) {
+              std::size_t end = std::min(begin + chunk, blockEnd);
+              for (std::size_t i=begin; i<end; i++) {
+                  replayer.Process(*readers[records[i].file], records[i], seed, results[i - blockBegin]);
+              }
+          }
+      };
+      std::vector<std::thread> threads;
+      for (int t=0; t<nThreads; t++) threads.emplace_back(work);
+      for (auto& thread : threads) thread.join();
+
+      for (std::size_t i=0; i<blockEnd-blockBegin; i++) {
+          const Result& result = results[i];
+          if (!result.accepted) continue;
+          G4int column = 0;
+          analysisManager->FillNtupleIColumn(ntupleId, column++, result.eventID);
+          analysisManager->FillNtupleIColumn(ntupleId, column++, result.file);
+          for (G4int j=0; j<nPmts; j++) analysisManager->FillNtupleFColumn(ntupleId, column++, result.amplitude[j]);
+          for (G4int j=0; j<nPmts; j++) analysisManager->FillNtupleFColumn(ntupleId, column++, result.time[j]);
+          analysisManager->FillNtupleIColumn(ntupleId, column++, result.nFired);
+          analysisManager->AddNtupleRow(ntupleId);
+          nAccepted++;
+      }
+  }
+  analysisManager->Write();
+  analysisManager->CloseFile();
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << "det01_replay: " << records.size() << " events from " << inputs.size()
+            << " sidecar(s), " << nAccepted << " accepted, " << nThreads << " threads, "
+            << seconds << " s (" << records.size() / std::max(seconds, 1.e-9) << " events/s)"
+            << " -> " << outName << std::endl;
+  return 0;
+}
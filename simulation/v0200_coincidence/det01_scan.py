@@ -0,0 +1,227 @@
+#!/usr/bin/env python3
+"""det01_scan: parameter scans of det01 split into seeded jobs.
+
+A scan description (JSON, see scan_example.json) defines a grid of
+  geometry (/det01/geometry/ values) x polarisation (A, B, C)
+  x trigger threshold
+and the number of events per grid point. Every grid point is split into
+jobs of at most eventsPerJob events. Job k of grid point c is seeded with
+  seed = baseSeed + c * seedStride + k
+so a job reproduces on its own, and adding grid points or events does not
+change the seeds of existing jobs. The job seed is also the per-event seed
+base (/det01/seeds/base), and job k numbers its events from
+k * eventsPerJob (/det01/seeds/eventOffset), so the EventIDs of the merged
+grid point are unique.
+
+  det01_scan.py plan  scan.json scanDir   write the job macros and jobs.json
+  det01_scan.py run   scanDir [-j N]      run the pending jobs, N at a time
+  det01_scan.py job   scanDir index       run one job (cluster job arrays)
+  det01_scan.py array scanDir             write a SLURM array script
+  det01_scan.py merge scanDir             hadd the jobs of each grid point,
+                                          write index.csv
+"""
+
+import argparse
+import concurrent.futures
+import csv
+import itertools
+import json
+import os
+import shutil
+import subprocess
+import sys
+
+def grid_points(scan):
+    """Yield (geometry dict, (A, B, C), threshold) for every grid point."""
+    geometry = scan.get("geometry", {})
+    keys = sorted(geometry)
+    geometries = [dict(zip(keys, values))
+                  for values in itertools.product(*(geometry[k] for k in keys))]
+    for geo, pol, thr in itertools.product(geometries,
+                                           scan.get("polarization", [[1.0, 0.0, 0.0]]),
+                                           scan.get("threshold", [None])):
+        yield geo, tuple(pol), thr
+
+
+def job_macro(scan, point, events, output, seed, first_event):
+    geo, (a, b, c), thr = point
+    lines = ["# Generated by det01_scan.py"]
+    for key, value in geo.items():
+        lines.append("/det01/geometry/%s %s" % (key, value))
+    lines += scan.get("preInit", [])
+    lines.append("/run/initialize")
+    lines += scan.get("setup", [])
+    lines += ["/det01/seeds/base %d" % (seed % 2147483647), "/det01/seeds/eventOffset %d" % first_event]
+    lines += ["/det01/scatter/A %g" % a, "/det01/scatter/B %g" % b, "/det01/scatter/C %g" % c]
+    if thr is not None:
+        lines += ["/det01/trigger/enable true", "/det01/trigger/threshold %s" % thr]
+    lines += ["/analysis/setFileName %s" % output, "/run/beamOn %d" % events]
+    return "\n".join(lines) + "\n"
+
+
+def plan(args):
+    with open(args.scan) as f:
+        scan = json.load(f)
+    events = int(scan["events"])
+    per_job = int(scan.get("eventsPerJob", events))
+    base_seed = int(scan.get("baseSeed", 1))
+    stride = int(scan.get("seedStride", 100000))
+    n_chunks = (events + per_job - 1) // per_job
+    if n_chunks > stride:
+        sys.exit("det01_scan: %d jobs per grid point exceed seedStride %d" % (n_chunks, stride))
+
+    os.makedirs(os.path.join(args.dir, "jobs"), exist_ok=True)
+    jobs, points = [], []
+    for cfg, point in enumerate(grid_points(scan)):
+        geo, pol, thr = point
+        points.append({"config": cfg, "geometry": geo, "A": pol[0], "B": pol[1], "C": pol[2],
+                       "threshold": thr})
+        for chunk in range(n_chunks):
+            name = "job_%04d_%03d" % (cfg, chunk)
+            n = min(per_job, events - chunk * per_job)
+            seed = base_seed + cfg * stride + chunk
+            with open(os.path.join(args.dir, "jobs", name + ".mac"), "w") as f:
+                f.write(job_macro(scan, point, n, name, seed, chunk * per_job))
+            jobs.append({"index": len(jobs), "config": cfg, "chunk": chunk, "name": name,
+                         "events": n, "seed": seed})
+
+    with open(os.path.join(args.dir, "jobs.json"), "w") as f:
+        json.dump({"executable": scan.get("executable", "det01"),
+                   "ntuple": scan.get("ntuple", "CosmicData"),
+                   "points": points, "jobs": jobs}, f, indent=1)
+    print("det01_scan: %d grid points, %d jobs in %s" % (len(points), len(jobs), args.dir))
+
+
+def load(scan_dir):
+    with open(os.path.join(scan_dir, "jobs.json")) as f:
+        return json.load(f)
+
+
+def run_job(scan_dir, executable, job):
+    """Run one job in scanDir/jobs; a .done marker makes reruns skip it."""
+    work = os.path.join(os.path.abspath(scan_dir), "jobs")
+    done = os.path.join(work, job["name"] + ".done")
+    if os.path.exists(done):
+        return 0
+    with open(os.path.join(work, job["name"] + ".log"), "w") as log:
+        status = subprocess.call([executable, job["name"] + ".mac", "-t", "1", "-s", str(job["seed"])],
+                                 cwd=work, stdout=log, stderr=subprocess.STDOUT)
+    if status == 0:
+        open(done, "w").close()
+    return status
+
+
+def run(args):
+    scan = load(args.dir)
+    executable = shutil.which(scan["executable"]) or os.path.abspath(scan["executable"])
+    failed = 0
+    with concurrent.futures.ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        futures = {pool.submit(run_job, args.dir, executable, job): job for job in scan["jobs"]}
+        for future in concurrent.futures.as_completed(futures):
+            job = futures[future]
+            status = future.result()
+            if status != 0:
+                failed += 1
+            print("det01_scan: %s (seed %d) %s" % (job["name"], job["seed"],
+                                                    "ok" if status == 0 else "FAILED (%d)" % status))
+    if failed:
+        sys.exit("det01_scan: %d job(s) failed, see jobs/*.log" % failed)
+
+
+def job(args):
+    scan = load(args.dir)
+    executable = shutil.which(scan["executable"]) or os.path.abspath(scan["executable"])
+    sys.exit(run_job(args.dir, executable, scan["jobs"][args.index]))
+
+
+def array(args):
+    scan = load(args.dir)
+    script = os.path.join(args.dir, "submit_array.sh")
+    with open(script, "w") as f:
+        f.write("#!/bin/bash\n")
+        f.write("#SBATCH --job-name=det01_scan\n")
+        f.write("#SBATCH --array=0-%d\n" % (len(scan["jobs"]) - 1))
+        f.write("#SBATCH --cpus-per-task=1\n")
+        f.write("#SBATCH --output=%s/jobs/slurm_%%a.out\n" % os.path.abspath(args.dir))
+        f.write("%s %s job %s $SLURM_ARRAY_TASK_ID\n"
+                % (sys.executable, os.path.abspath(__file__), os.path.abspath(args.dir)))
+    os.chmod(script, 0o755)
+    print("det01_scan: sbatch %s (%d tasks), then det01_scan.py merge %s"
+          % (script, len(scan["jobs"]), args.dir))
+
+
+def merge(args):
+    scan = load(args.dir)
+    jobs_dir = os.path.join(args.dir, "jobs")
+    merged_dir = os.path.join(args.dir, "merged")
+    os.makedirs(merged_dir, exist_ok=True)
+
+    rows = []
+    for point in scan["points"]:
+        cfg = point["config"]
+        jobs = [j for j in scan["jobs"] if j["config"] == cfg]
+        missing = [j["name"] for j in jobs
+                   if not os.path.exists(os.path.join(jobs_dir, j["name"] + ".done"))]
+        if missing:
+            sys.exit("det01_scan: grid point %d incomplete (%s)" % (cfg, ", ".join(missing)))
+
+        output = "config_%04d.root" % cfg
+        inputs = [os.path.join(jobs_dir, j["name"] + ".root") for j in jobs]
+        status = subprocess.call(["hadd", "-f", "-k", os.path.join(merged_dir, output)] + inputs,
+                                 stdout=subprocess.DEVNULL)
+        if status != 0:
+            sys.exit("det01_scan: hadd failed for grid point %d" % cfg)
+
+        row = {"config": cfg, "file": os.path.join("merged", output), "ntuple": scan["ntuple"],
+               "events": sum(j["events"] for j in jobs),
+               "seeds": "%d-%d" % (jobs[0]["seed"], jobs[-1]["seed"]),
+               "A": point["A"], "B": point["B"], "C": point["C"],
+               "threshold": point["threshold"] if point["threshold"] is not None else ""}
+        for key, value in point["geometry"].items():
+            row["geometry." + key] = value
+        rows.append(row)
+
+    fields = []
+    for row in rows:
+        fields += [k for k in row if k not in fields]
+    with open(os.path.join(args.dir, "index.csv"), "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=fields)
+        writer.writeheader()
+        writer.writerows(rows)
+    print("det01_scan: %d grid points merged, index in %s"
+          % (len(rows), os.path.join(args.dir, "index.csv")))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Parameter scans of det01.")
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("plan", help="split a scan description into jobs")
+    p.add_argument("scan")
+    p.add_argument("dir")
+    p.set_defaults(func=plan)
+
+    p = sub.add_parser("run", help="run the pending jobs locally")
+    p.add_argument("dir")
+    p.add_argument("-j", "--jobs", type=int, default=os.cpu_count())
+    p.set_defaults(func=run)
+
+    p = sub.add_parser("job", help="run one job by index")
+    p.add_argument("dir")
+    p.add_argument("index", type=int)
+    p.set_defaults(func=job)
+
+    p = sub.add_parser("array", help="write a SLURM job array script")
+    p.add_argument("dir")
+    p.set_defaults(func=array)
+
+    p = sub.add_parser("merge", help="merge the job outputs per grid point")
+    p.add_argument("dir")
+    p.set_defaults(func=merge)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,384 @@
+// det01_server: persistent det01 that keeps geometry and physics warm.
+//
+// Builds the run manager once, executes the init macro (PreInit commands
+// and /run/initialize), builds the physics tables with /run/beamOn 0 and
+// then executes job macros one after the other in the same process: every
+// job starts in Idle state with materials, optical surfaces, geometry and
+// physics tables ready, and the worker threads started by the first job
+// stay alive for the next ones.
+//
+// Jobs come from a local socket or a spool directory:
+//   -u path : Unix socket. Every line a client sends names a job macro
+//             (relative to the server's working directory); the server
+//             answers one line per job, "OK <macro> <seconds>" or
+//             "FAIL <macro> <line>: <command>". The line "quit" stops it.
+//   -q dir  : spool directory. Every *.mac moved into dir (mv, so it is
+//             never read half-written) is run in name order and then moved
+//             to dir/done or dir/failed; a file named "quit" stops the server.
+// SIGINT/SIGTERM stop the server after the running job.
+//
+//   -p dir  : physics tables retrieved from dir if it holds any, otherwise
+//             stored there after the warm-up (/run/particle/retrieve|
+//             storePhysicsTable; this covers the EM tables, the HP data
+//             files are still read at start-up)
+//
+// Client: det01_server -c path job.mac [job.mac ...] submits the jobs to
+// a server socket and prints the answers (exit code 2 if one failed).
+//
+// Jobs share the UI state, so the settings of one job (trigger, output,
+// GPS, seeds) stay in effect for the next: each job macro should set what
+// it relies on, including /analysis/setFileName. PreInit-only commands
+// (/det01/optics/mode, /det01/pmt/, ...) belong in the init macro and fail
+// in a job; geometry changes go through /run/reinitializeGeometry.
+//
+// Example: server_init.mac (energy-only optics) with run_server_job.mac.
+//
+// Usage: det01_server <init.mac> (-u socket | -q dir) [-p tableDir]
+//                     [-t nThreads|max] [-r serial|mt|tasking] [-s seed]
+//        det01_server -c socket job.mac [job.mac ...]
+
+#include "G4RunManagerFactory.hh"
+#include "G4UImanager.hh"
+#include "G4UIcommandStatus.hh"
+#include "G4StateManager.hh"
+#include "G4Threading.hh"
+#include "Randomize.hh"
+
+#include "DET01DetectorConstruction.hh"
+#include "DET01PhysicsList.hh"
+#include "DET01ActionInitialization.hh"
+
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+volatile sig_atomic_t stopRequested = 0;
+
+void RequestStop(int) { stopRequested = 1; }
+
+void PrintUsage()
+{
+  G4cerr << " Usage: det01_server <init.mac> (-u socket | -q dir) [-p tableDir]"
+         << " [-t nThreads|max] [-r serial|mt|tasking] [-s seed]" << G4endl;
+  G4cerr << "        det01_server -c socket job.mac [job.mac ...]" << G4endl;
+}
+
+std::string Trim(const std::string& s)
+{
+  size_t first = s.find_first_not_of(" \t\r\n");
+  if (first == std::string::npos) return "";
+  size_t last = s.find_last_not_of(" \t\r\n");
+  return s.substr(first, last - first + 1);
+}
+
+struct JobResult {
+  G4bool ok = true;
+  G4int line = 0;          // failing line
+  G4String command;        // failing command, or the open error
+  G4double seconds = 0.;
+};
+
+// Commands are applied one by one, so a failure reports its line
+JobResult RunJob(const G4String& macro)
+{
+  JobResult result;
+  std::ifstream in(macro);
+  if (!in) {
+      result.ok = false;
+      result.command = "cannot open " + macro;
+      return result;
+  }
+
+  G4cout << "det01_server: job " << macro << G4endl;
+  G4UImanager* UImanager = G4UImanager::GetUIpointer();
+  auto t0 = std::chrono::steady_clock::now();
+  std::string line;
+  while (std::getline(in, line)) {
+      result.line++;
+      G4String command = Trim(line);
+      if (command.empty() || command[0] == '#') continue;
+      if (UImanager->GetVerboseLevel() > 0) G4cout << command << G4endl;
+      if (UImanager->ApplyCommand(command) != fCommandSucceeded) {
+          result.ok = false;
+          result.command = command;
+          break;
+      }
+  }
+  result.seconds = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - t0).count();
+  return result;
+}
+
+std::string Status(const G4String& macro, const JobResult& result)
+{
+  std::ostringstream status;
+  if (result.ok) status << "OK " << macro << " " << result.seconds;
+  else status << "FAIL " << macro << " " << result.line << ": " << result.command;
+  return status.str();
+}
+
+G4bool WriteLine(int fd, const std::string& text)
+{
+  std::string line = text + "\n";
+  const char* p = line.data();
+  size_t left = line.size();
+  while (left > 0) {
+      ssize_t n = ::write(fd, p, left);
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) return false;
+      p += n;
+      left -= n;
+  }
+  return true;
+}
+
+sockaddr_un SocketAddress(const G4String& path)
+{
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  return address;
+}
+
+// One client at a time; further clients wait in the listen backlog
+G4int ServeSocket(const G4String& path)
+{
+  if (path.size() >= sizeof(sockaddr_un::sun_path)) {
+      G4cerr << "det01_server: socket path too long: " << path << G4endl;
+      return 1;
+  }
+  int server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un address = SocketAddress(path);
+  ::unlink(path.c_str());
+  if (server < 0 || ::bind(server, (sockaddr*)&address, sizeof(address)) != 0
+      || ::listen(server, 16) != 0) {
+      G4cerr << "det01_server: cannot listen on " << path << ": " << std::strerror(errno) << G4endl;
+      if (server >= 0) ::close(server);
+      return 1;
+  }
+  G4cout << "det01_server: listening on " << path << G4endl;
+
+  G4bool quit = false;
+  while (!quit && !stopRequested) {
+      int client = ::accept(server, nullptr, nullptr);
+      if (client < 0) {
+          if (errno == EINTR) continue;
+          G4cerr << "det01_server: accept failed: " << std::strerror(errno) << G4endl;
+          break;
+      }
+
+      std::string buffer;
+      char chunk[4096];
+      G4bool open = true;
+      while (open && !quit && !stopRequested) {
+          ssize_t n = ::read(client, chunk, sizeof(chunk));
+          if (n < 0 && errno == EINTR) continue;
+          if (n <= 0) break;
+          buffer.append(chunk, n);
+
+          size_t eol;
+          while (open && !stopRequested && (eol = buffer.find('\n')) != std::string::npos) {
+              G4String job = Trim(buffer.substr(0, eol));
+              buffer.erase(0, eol + 1);
+              if (job.empty()) continue;
+              if (job == "quit") {
+                  WriteLine(client, "BYE");
+                  quit = true;
+                  break;
+              }
+              // A client that went away loses its remaining jobs, the server goes on
+              open = WriteLine(client, Status(job, RunJob(job)));
+          }
+      }
+      ::close(client);
+  }
+
+  ::close(server);
+  ::unlink(path.c_str());
+  return 0;
+}
+
+G4int ServeSpool(const G4String& dir)
+{
+  namespace fs = std::filesystem;
+  std::error_code error;
+  fs::create_directories(fs::path(dir) / "done", error);
+  fs::create_directories(fs::path(dir) / "failed", error);
+  if (error) {
+      G4cerr << "det01_server: cannot use spool directory " << dir << ": " << error.message() << G4endl;
+      return 1;
+  }
+  G4cout << "det01_server: watching " << dir << G4endl;
+
+  while (!stopRequested) {
+      if (fs::exists(fs::path(dir) / "quit", error)) {
+          fs::remove(fs::path(dir) / "quit", error);
+          break;
+      }
+
+      std::vector<fs::path> jobs;
+      for (const auto& entry : fs::directory_iterator(dir, error)) {
+          if (entry.is_regular_file() && entry.path().extension() == ".mac") jobs.push_back(entry.path());
+      }
+      if (jobs.empty()) {
+          std::this_thread::sleep_for(std::chrono::seconds(1));
+          continue;
+      }
+
+      std::sort(jobs.begin(), jobs.end());
+      for (const auto& job : jobs) {
+          if (stopRequested) break;
+          JobResult result = RunJob(job.string());
+          G4cout << "det01_server: " << Status(job.string(), result) << G4endl;
+          fs::rename(job, fs::path(dir) / (result.ok ? "done" : "failed") / job.filename(), error);
+          if (error) {
+              // Never run the same file twice
+              G4cerr << "det01_server: cannot move " << job << ": " << error.message() << G4endl;
+              return 1;
+          }
+      }
+  }
+  return 0;
+}
+
+G4int Submit(const G4String& path, const std::vector<G4String>& jobs)
+{
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un address = SocketAddress(path);
+  if (fd < 0 || ::connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+      std::cerr << "det01_server: cannot connect to " << path << ": " << std::strerror(errno) << std::endl;
+      if (fd >= 0) ::close(fd);
+      return 1;
+  }
+  for (const auto& job : jobs) WriteLine(fd, job);
+  ::shutdown(fd, SHUT_WR);
+
+  // One answer per job
+  G4int status = 0;
+  std::string buffer;
+  char chunk[4096];
+  ssize_t n;
+  while ((n = ::read(fd, chunk, sizeof(chunk))) > 0 || (n < 0 && errno == EINTR)) {
+      if (n > 0) buffer.append(chunk, n);
+  }
+  ::close(fd);
+
+  std::istringstream answers(buffer);
+  std::string line;
+  while (std::getline(answers, line)) {
+      std::cout << line << std::endl;
+      if (line.compare(0, 4, "FAIL") == 0) status = 2;
+  }
+  return status;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  // Client mode
+  if (argc > 1 && G4String(argv[1]) == "-c") {
+      if (argc < 4) { PrintUsage(); return 1; }
+      return Submit(argv[2], std::vector<G4String>(argv + 3, argv + argc));
+  }
+
+  // Parse command line
+  G4String initMacro, socketPath, spoolDir, tableDir;
+  G4int nThreads = 0;
+  G4long seed = -1;
+  G4RunManagerType runManagerType = G4RunManagerType::Default;
+
+  for (G4int i=1; i<argc; i++) {
+    G4String arg = argv[i];
+    if (arg == "-u" && i+1 < argc) socketPath = argv[++i];
+    else if (arg == "-q" && i+1 < argc) spoolDir = argv[++i];
+    else if (arg == "-p" && i+1 < argc) tableDir = argv[++i];
+    else if (arg == "-t" && i+1 < argc) {
+      G4String value = argv[++i];
+      nThreads = (value == "max") ? G4Threading::G4GetNumberOfCores() : std::atoi(value.c_str());
+    }
+    else if (arg == "-r" && i+1 < argc) {
+      G4String value = argv[++i];
+      if (value == "serial") runManagerType = G4RunManagerType::Serial;
+      else if (value == "mt") runManagerType = G4RunManagerType::MT;
+      else if (value == "tasking") runManagerType = G4RunManagerType::Tasking;
+      else { PrintUsage(); return 1; }
+    }
+    else if (arg == "-s" && i+1 < argc) seed = std::atol(argv[++i]);
+    else if (arg[0] != '-' && initMacro.empty()) initMacro = arg;
+    else { PrintUsage(); return 1; }
+  }
+  if (initMacro.empty() || socketPath.empty() == spoolDir.empty()) {
+    PrintUsage();
+    return 1;
+  }
+
+  // Stop between jobs; a vanished client must not kill the server
+  struct sigaction action;
+  std::memset(&action, 0, sizeof(action));
+  action.sa_handler = RequestStop;
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+  signal(SIGPIPE, SIG_IGN);
+
+  if (seed >= 0) G4Random::setTheSeed(seed);
+
+  // Construct the run manager (once)
+  auto* runManager = G4RunManagerFactory::CreateRunManager(runManagerType);
+  if (nThreads > 0) runManager->SetNumberOfThreads(nThreads);
+
+  runManager->SetUserInitialization(new DET01DetectorConstruction());
+  runManager->SetUserInitialization(new DET01PhysicsList());
+  runManager->SetUserInitialization(new DET01ActionInitialization());
+
+  G4UImanager* UImanager = G4UImanager::GetUIpointer();
+
+  // Stored physics tables, if any
+  namespace fs = std::filesystem;
+  std::error_code error;
+  G4bool retrieve = !tableDir.empty() && fs::is_directory(tableDir.c_str(), error)
+                    && !fs::is_empty(tableDir.c_str(), error);
+  if (retrieve) UImanager->ApplyCommand("/run/particle/retrievePhysicsTable " + tableDir);
+
+  auto t0 = std::chrono::steady_clock::now();
+  JobResult init = RunJob(initMacro);
+  if (!init.ok) {
+    G4cerr << "det01_server: " << Status(initMacro, init) << G4endl;
+    delete runManager;
+    return 1;
+  }
+  if (G4StateManager::GetStateManager()->GetCurrentState() == G4State_PreInit) {
+    UImanager->ApplyCommand("/run/initialize");
+  }
+
+  // Warm-up: builds the physics tables without events
+  UImanager->ApplyCommand("/run/beamOn 0");
+  if (!tableDir.empty() && !retrieve) {
+    fs::create_directories(tableDir.c_str(), error);
+    UImanager->ApplyCommand("/run/particle/storePhysicsTable " + tableDir);
+  }
+  G4double initTime = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - t0).count();
+  G4cout << "det01_server: initialized in " << initTime << " s" << G4endl;
+
+  G4int status = socketPath.empty() ? ServeSpool(spoolDir) : ServeSocket(socketPath);
+
+  // Job termination
+  delete runManager;
+  return status;
+}
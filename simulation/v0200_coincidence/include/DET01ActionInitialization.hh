@@ -0,0 +1,19 @@
+#ifndef DET01ActionInitialization_h
+#define DET01ActionInitialization_h 1
+
+#include "G4VUserActionInitialization.hh"
+
+/// Action initialization: run action on the master; generator, run, event
+/// stacking and stepping actions on every worker.
+
+class DET01ActionInitialization : public G4VUserActionInitialization
+{
+  public:
+    DET01ActionInitialization();
+    virtual ~DET01ActionInitialization();
+
+    virtual void BuildForMaster() const;
+    virtual void Build() const;
+};
+
+#endif
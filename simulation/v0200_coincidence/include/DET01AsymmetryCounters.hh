@@ -0,0 +1,78 @@
+#ifndef DET01AsymmetryCounters_h
+#define DET01AsymmetryCounters_h 1
+
+#include "G4VAccumulable.hh"
+#include "globals.hh"
+
+#include <vector>
+
+#ifdef DET01_USE_MPI
+#include <mpi.h>
+#endif
+
+class G4GenericMessenger;
+class DET01DetectorConstruction;
+class DET01Trigger;
+
+/// Online azimuthal asymmetry of the ring layout (/det01/asymmetry/).
+///
+/// Each thread fills its own instance (GetInstance()) with the events
+/// accepted by the trigger: per detector copyNo, the number and the summed
+/// weight (and weight^2) of events in which it fired (DET01Trigger
+/// threshold). The master merges the instances at end of run and fits the
+/// yields of every ring to
+///   Y(phi) = A + B cos(phi) + C cos(2 phi)
+/// by weighted least squares (variance: summed weight^2), with the errors
+/// from the covariance matrix, chi2/ndf and the ratios B/A, C/A comparable
+/// to /det01/scatter/A, B, C. The summary is printed and written to
+/// /det01/asymmetry/file (default <output name>_asymmetry.txt), so
+/// polarization scans can run with /det01/output/events false.
+
+class DET01AsymmetryCounters : public G4VAccumulable
+{
+  public:
+    DET01AsymmetryCounters(const G4String& name = "AsymmetryCounters");
+    virtual ~DET01AsymmetryCounters();
+
+    static DET01AsymmetryCounters* GetInstance();
+
+    virtual void Merge(const G4VAccumulable& other);
+    virtual void Reset();
+
+    G4bool IsEnabled() const { return fEnabled; }
+
+    // One call per accepted event
+    void Fill(const std::vector<G4double>& edep, const DET01Trigger* trigger, G4double weight);
+
+    // Fit every ring, print and write the summary (master, end of run)
+    void Report(const DET01DetectorConstruction* detector, const G4String& outputName) const;
+
+#ifdef DET01_USE_MPI
+    // Collective: sum all ranks into rank 0 (MPI build)
+    void ReduceOverRanks(MPI_Comm comm);
+#endif
+
+  private:
+    struct Fit {
+      G4bool valid = false;
+      G4int nPoints = 0;
+      G4double par[3] = { 0., 0., 0. };   // A, B, C
+      G4double cov[3][3] = {{0.}};
+      G4double chi2 = 0.;
+    };
+
+    void Resize(size_t nDetectors);
+    Fit FitRing(const std::vector<G4int>& copies, const std::vector<G4double>& phi) const;
+
+    G4GenericMessenger* fMessenger;
+    G4bool fEnabled;
+    G4String fFileName;
+
+    G4long fNEvents;
+    G4double fSumWeight;
+    std::vector<G4long>   fCounts;     // [copyNo]
+    std::vector<G4double> fSumW;       // [copyNo]
+    std::vector<G4double> fSumW2;      // [copyNo]
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef DET01BiasingOperator_h
+#define DET01BiasingOperator_h 1
+
+#include "G4VBiasingOperator.hh"
+#include "globals.hh"
+
+#include <map>
+
+class G4ParticleDefinition;
+class G4BiasingProcessInterface;
+class G4BOptnChangeCrossSection;
+
+/// Interaction biasing of the primary in the target (generic biasing).
+///
+/// Attached to the target logical volume. Until the primary has interacted
+/// once, the cross section of the selected hadronic process ("all" = every
+/// wrapped hadronic process of the particle) is changed through
+/// G4BOptnChangeCrossSection:
+///  - enhance : sigma_biased = factor * sigma
+///  - force   : sigma_biased = max(sigma, -ln(1 - P) / L / N) for each of the
+///              N biased processes, i.e. the primary interacts with
+///              probability P over the target thickness L
+/// The framework corrects the track weights; the weight of the primary at
+/// its interaction, or, if it never interacts, its weight at the end of its
+/// tracking (all non-interaction corrections applied), is kept as the event
+/// weight, GetEventWeight(), of the thread's operator.
+
+class DET01BiasingOperator : public G4VBiasingOperator
+{
+  public:
+    DET01BiasingOperator(const G4String& particleName, const G4String& processName,
+                         G4bool force, G4double factor,
+                         G4double probability, G4double thickness);
+    virtual ~DET01BiasingOperator();
+
+    // Operator of this thread, nullptr if biasing is off
+    static DET01BiasingOperator* GetInstance();
+    G4double GetEventWeight() const { return fEventWeight; }
+
+    virtual void StartRun();
+    virtual void StartTracking(const G4Track* track);
+    virtual void EndTracking();
+
+  private:
+    virtual G4VBiasingOperation* ProposeOccurenceBiasingOperation(
+        const G4Track* track, const G4BiasingProcessInterface* callingProcess);
+    virtual G4VBiasingOperation* ProposeFinalStateBiasingOperation(
+        const G4Track*, const G4BiasingProcessInterface*) { return nullptr; }
+    virtual G4VBiasingOperation* ProposeNonPhysicsBiasingOperation(
+        const G4Track*, const G4BiasingProcessInterface*) { return nullptr; }
+
+    using G4VBiasingOperator::OperationApplied;
+    virtual void OperationApplied(const G4BiasingProcessInterface* callingProcess,
+                                  G4BiasingAppliedCase biasingCase,
+                                  G4VBiasingOperation* occurenceOperationApplied,
+                                  G4double weightForOccurenceInteraction,
+                                  G4VBiasingOperation* finalStateOperationApplied,
+                                  const G4VParticleChange* particleChangeProduced);
+
+    G4double BiasedCrossSection(G4double analogXS) const;
+
+    G4String fParticleName;
+    G4String fProcessName;
+    const G4ParticleDefinition* fParticle;
+    G4bool fForce;
+    G4double fFactor;
+    G4double fProbability;
+    G4double fThickness;
+
+    std::map<const G4BiasingProcessInterface*, G4BOptnChangeCrossSection*> fOperations;
+
+    // Primary of the current event
+    const G4Track* fPrimary;   // while it is tracked
+    G4bool fInteracted;
+    G4double fEventWeight;
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef DET01Checkpoint_h
+#define DET01Checkpoint_h 1
+
+#include "globals.hh"
+
+class G4GenericMessenger;
+
+/// Checkpointed long runs (/det01/checkpoint/, master only).
+///
+/// /det01/checkpoint/beamOn N runs N events as consecutive sub-runs of
+/// /det01/checkpoint/every events. Sub-run k writes <name>_part<k>.root
+/// (name from /analysis/setFileName), so everything up to the last finished
+/// sub-run is on disk. After each sub-run the master engine status and the
+/// event counter are saved to <file>_<k>.rndm / <file>.txt (the .txt is
+/// written to a temporary name and renamed, so a crash leaves the previous
+/// checkpoint valid).
+///
+/// /det01/checkpoint/resume continues from the last checkpoint: the engine
+/// status is restored and the interrupted sub-run is redone. Worker events
+/// are seeded from the master engine only, so the parts are identical to
+/// an uninterrupted run; EventID continues across parts and the parts,
+/// listed in <name>_parts.txt, concatenate with hadd in order.
+
+class DET01Checkpoint
+{
+  public:
+    DET01Checkpoint();
+    ~DET01Checkpoint();
+
+    // Events of the finished sub-runs, added to the EventID column
+    static G4int GetEventOffset() { return fEventOffset; }
+
+  private:
+    void DefineCommands();
+    void BeamOn(G4int nEvents);
+    void Resume();
+    void Run();
+    void Save() const;
+    G4bool Load();
+    G4String PartName(G4int part) const;
+    G4String EngineName(G4int part) const;
+
+    G4GenericMessenger* fMessenger;
+    G4String fFileName;
+    G4int fEventsPerPart;
+
+    // State of the checkpointed run
+    G4String fOutputName;
+    G4int fTotalEvents;
+    G4int fPartsDone;
+    G4String fEngineFile;
+
+    static G4int fEventOffset;
+};
+
+#endif
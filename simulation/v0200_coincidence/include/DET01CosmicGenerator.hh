@@ -0,0 +1,76 @@
+#ifndef DET01CosmicGenerator_h
+#define DET01CosmicGenerator_h 1
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class G4GenericMessenger;
+class G4ParticleDefinition;
+
+/// Acceptance-aware cosmic muon generator.
+///
+/// Muons come from the upper hemisphere down to /det01/cosmic/maxTheta with
+/// intensity I(E, theta) = I0 (gamma - 1) Emin^(gamma-1) E^-gamma cos^n(theta)
+/// (I0: vertical intensity above Emin, n = cosPower; n = 0 is the cos-law
+/// plane source of the GPS setup) and mu+/mu- = chargeRatio. Only
+/// trajectories crossing the detector envelope (scintillator bounding box +
+/// margin, taken from the geometry) are generated: the direction is drawn
+/// from I x projected envelope area, tabulated once in (cos theta, phi), the
+/// entry point uniformly on the faces seen from that direction, and the
+/// energy from the inverse power-law CDF.
+///
+/// GetRate() is the matching rate of muons crossing the envelope,
+///   R = I0 [1 - (Emax/Emin)^(1-gamma)] * Int dOmega cos^n(theta) A_proj,
+/// with the phi integral done analytically per table bin, so every
+/// generated event stands for 1/R of live time.
+
+class DET01CosmicGenerator
+{
+  public:
+    DET01CosmicGenerator();
+    ~DET01CosmicGenerator();
+
+    // Sample one muon crossing the envelope
+    void Sample(G4ParticleDefinition*& particle, G4ThreeVector& position,
+                G4ThreeVector& direction, G4double& kineticEnergy);
+
+    // Rate of muons crossing the envelope, in Geant4 units (divide by 1/s)
+    G4double GetRate();
+
+  private:
+    void DefineCommands();
+    void SetEnergyMin(G4double value) { fEMin = value; fDirty = true; }
+    void SetEnergyMax(G4double value) { fEMax = value; fDirty = true; }
+    void SetIndex(G4double value) { fIndex = value; fDirty = true; }
+    void SetCosPower(G4double value) { fCosPower = value; fDirty = true; }
+    void SetMaxTheta(G4double value) { fMaxTheta = value; fDirty = true; }
+    void SetMargin(G4double value) { fMargin = value; fDirty = true; }
+
+    void Build();
+
+    G4GenericMessenger* fMessenger;
+
+    // Flux model
+    G4double fEMin, fEMax;
+    G4double fIndex;              // gamma of E^-gamma
+    G4double fCosPower;
+    G4double fMaxTheta;
+    G4double fVerticalIntensity;  // above Emin, per m2 s sr
+    G4double fChargeRatio;        // mu+/mu-
+
+    // Envelope (geometry bounding box + margin)
+    G4double fMargin;
+    G4ThreeVector fLo, fHi;
+    G4ThreeVector fGeometryLo, fGeometryHi;
+
+    // Tables
+    G4bool fDirty;
+    G4double fCosMin;
+    std::vector<G4double> fDirectionCdf;   // [iCos * nPhi + iPhi], phi in [0, pi/2]
+    G4double fEnergyA, fEnergyB;           // E^(1-gamma) = A + u B
+    G4double fAcceptance;                  // Int dOmega cos^n(theta) A_proj
+};
+
+#endif
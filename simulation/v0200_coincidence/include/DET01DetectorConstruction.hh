@@ -0,0 +1,171 @@
+#ifndef DET01DetectorConstruction_h
+#define DET01DetectorConstruction_h 1
+
+#include "G4VUserDetectorConstruction.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class G4VPhysicalVolume;
+class G4LogicalVolume;
+class G4GenericMessenger;
+class G4OpticalSurface;
+class DET01ModuleParameterisation;
+
+/// Detector construction: stack of HND-S2 scintillators along Z, each read
+/// out by a PMT (grease + window + photocathode) on its +X face.
+///
+/// Every detector is a "Module" envelope (air) holding the scintillator and
+/// its PMT stack; the modules are one G4PVParameterised volume
+/// (DET01ModuleParameterisation), so navigation only visits the modules
+/// near a track. Being parameterised, they sit alone in an air envelope
+/// "Detectors" (box around the stack, spherical shell around the rings)
+/// placed in the World next to the Target. Detector ID = module copy number, i.e. touchable
+/// depth 1 inside the scintillator or photocathode.
+///
+/// Optical response modes (/det01/optics/mode, set before /run/initialize):
+///  - full     : every scintillation photon is tracked (default)
+///  - fast     : no optical photon is created; DET01OpticalDepositModel
+///               samples PE count and times per charged deposit from
+///               /det01/optics/responseMap
+///  - buildMap : full tracking, photon emission/detection recorded into a
+///               response map written to /det01/optics/responseMap at end of run
+///  - energy   : no optical physics at all; DET01EnergyResponse turns the
+///               quenched scintillator deposits into PE, time and amplitude
+///               with the constants of /det01/optics/responseFile
+///
+/// Reduced yield (full mode): with yieldFraction f < 1 the scintillator is
+/// built with f x SCINTILLATIONYIELD, so G4Scintillation only generates the
+/// photons that are tracked and the tracking cost drops to about f. The PE
+/// of the other (1 - f) are sampled from the deposits with the response map
+/// of /det01/optics/responseMap (DET01OpticalDepositModel), which keeps the
+/// mean and the variance of the full-yield PE count.
+///
+/// PMT hit storage (/det01/pmt/, set before /run/initialize): one record per
+/// PMT (accumulate, default) or one hit per photoelectron, with an optional
+/// arrival-time histogram (timeBins x timeBinWidth); verbose 1 prints the
+/// per-event photon summary.
+///
+/// Target (/det01/target/, set before /run/initialize): optional CH2 slab
+/// ("Target" volume, thickness along z). With /det01/bias/enable the primary
+/// deuteron's hadronic interaction in the target is enhanced or forced by
+/// DET01BiasingOperator and the event weight goes into the ntuple.
+///
+/// Regions: "TargetRegion", "ScintillatorRegion" and the world default
+/// region, with production cuts from /det01/cuts/ (target, scintillator,
+/// world; < 0 keeps the physics list default). Changes in Idle state apply
+/// at the next run.
+///
+/// Layout (/det01/geometry/): cosmic stack along z (default, stackCount x
+/// stackGap) or rings around the +z beam axis (rings, perRing, distance
+/// to the front face, phiOffset; PMT facing outwards, copyNo ring by ring),
+/// with cuboid (scinX/Y/Z) or cylindrical (cylRadius/cylLength) scintillators.
+/// The world is at least 2 m and keeps 20 cm of air around the modules.
+/// Between runs the layout is rebuilt by /run/reinitializeGeometry; materials,
+/// regions, SDs and physics tables are reused, the fast optics model (response
+/// map read again) and the map recorder are rebuilt.
+
+class DET01DetectorConstruction : public G4VUserDetectorConstruction
+{
+  public:
+    DET01DetectorConstruction();
+    virtual ~DET01DetectorConstruction();
+
+    virtual G4VPhysicalVolume* Construct();
+    virtual void ConstructSDandField();
+
+    G4int GetNDetectors() const { return fNDetectors; }
+
+    // Ring layout as built: ring, polar angle and azimuth of every copyNo
+    // (empty for the stack), origin to front face distance and half size
+    // of a front face
+    const std::vector<G4int>& GetDetectorRings() const { return fDetectorRing; }
+    const std::vector<G4double>& GetDetectorTheta() const { return fDetectorTheta; }
+    const std::vector<G4double>& GetDetectorPhi() const { return fDetectorPhi; }
+    G4double GetFaceDistance() const { return fFaceDistance; }
+    G4double GetFaceHalfSize() const { return fFaceHalfSize; }
+
+    // Bounding box of the placed scintillators (false before Construct)
+    G4bool GetScintillatorEnvelope(G4ThreeVector& lo, G4ThreeVector& hi) const;
+
+    const G4String& GetOpticsMode() const { return fOpticsMode; }
+    const G4String& GetResponseMapFile() const { return fResponseMapFile; }
+    const G4String& GetEnergyResponseFile() const { return fEnergyResponseFile; }
+    G4double GetYieldFraction() const { return fYieldFraction; }
+    // Target centre (/det01/target/position, also while no target is placed)
+    const G4ThreeVector& GetTargetPosition() const { return fTargetPosition; }
+
+  private:
+    void DefineMaterials();
+    void DefineCommands();
+    void SetOpticsMode(const G4String& mode);
+    void SetTargetCut(G4double cut);
+    void SetScintillatorCut(G4double cut);
+    void SetWorldCut(G4double cut);
+    void ApplyRegionCut(const G4String& regionName, G4double cut);
+    void SetRingAngles(const G4String& value);
+    void SetRingCounts(const G4String& value);
+    G4int RingCount(size_t ring) const;
+
+    G4LogicalVolume* fPhotocathodeLogical;
+    G4int fNDetectors;
+
+    G4GenericMessenger* fMessenger;
+    G4String fOpticsMode;
+    G4String fResponseMapFile;
+    G4String fEnergyResponseFile;
+    G4double fYieldFraction;    // tracked fraction of the scintillation photons
+
+    // PMT SD storage (/det01/pmt/)
+    G4GenericMessenger* fPmtMessenger;
+    G4bool fPmtAccumulate;
+    G4int fPmtTimeBins;
+    G4double fPmtTimeBinWidth;
+    G4int fPmtVerbose;
+
+    // Target (/det01/target/) and its interaction biasing (/det01/bias/)
+    G4GenericMessenger* fTargetMessenger;
+    G4bool fTargetEnabled;
+    G4double fTargetSize;
+    G4double fTargetThickness;
+    G4ThreeVector fTargetPosition;
+
+    G4GenericMessenger* fBiasMessenger;
+    G4bool fBiasEnabled;
+    G4String fBiasMode;
+    G4String fBiasProcess;
+    G4double fBiasFactor;
+    G4double fBiasProbability;
+
+    // Production cuts per region (/det01/cuts/)
+    G4GenericMessenger* fCutsMessenger;
+    G4double fTargetCut;
+    G4double fScintillatorCut;
+
+    // Current geometry (rebuilt by /run/reinitializeGeometry)
+    G4LogicalVolume* fScintillatorLogical;
+    G4LogicalVolume* fTargetLogical;
+
+    // Layout (/det01/geometry/)
+    G4GenericMessenger* fGeometryMessenger;
+    G4String fLayout;
+    G4String fShape;
+    G4double fScinX, fScinY, fScinZ;
+    G4double fCylRadius, fCylLength;
+    G4int fStackCount;
+    G4double fStackGap;
+    std::vector<G4double> fRingAngles;
+    std::vector<G4int> fRingCounts;
+    G4double fRingDistance;
+    G4double fRingPhiOffset;
+    std::vector<G4int> fDetectorRing;     // [copyNo], ring layout only
+    std::vector<G4double> fDetectorTheta; // [copyNo]
+    std::vector<G4double> fDetectorPhi;   // [copyNo]
+    G4double fFaceDistance, fFaceHalfSize;
+    G4ThreeVector fEnvelopeLo, fEnvelopeHi;
+    DET01ModuleParameterisation* fModuleParameterisation;
+    G4OpticalSurface* fTeflonSurface;   // created once, kept by the surface table across rebuilds
+};
+
+#endif
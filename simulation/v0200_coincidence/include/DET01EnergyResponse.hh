@@ -0,0 +1,52 @@
+#ifndef DET01EnergyResponse_h
+#define DET01EnergyResponse_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+/// Parametrised scintillator + PMT response for the energy-only optics mode.
+///
+/// Converts the Birks-quenched energy of each scintillator into what the
+/// hardware records, using per-detector constants from a text file:
+///   npe       = Poisson(E_vis * pePerMeV)  (pePerMeV 0: no statistics, npe 0,
+///                                           amplitude from E_vis)
+///   amplitude = (npe / pePerMeV) / calibration     [mV, calibration in MeV/mV]
+///   time      = first deposit + offset + N(0, opticalJitter) + N(0, electronicJitter)
+///
+/// File format ('#' starts a comment, times in ns, kB in mm/MeV):
+///   birks <kB>
+///   <det> <pePerMeV> <MeV/mV> <offset> <opticalJitter> <electronicJitter>
+/// Detectors without a line use the constants of the first detector line;
+/// a <det> tag that is not a non-negative integer is a fatal error.
+
+class DET01EnergyResponse
+{
+  public:
+    DET01EnergyResponse();
+    ~DET01EnergyResponse();
+
+    G4bool Read(const G4String& fileName, G4int nDetectors);
+
+    // Birks constant kB (visible = edep / (1 + kB dE/dx))
+    G4double GetBirksConstant() const { return fBirks; }
+    G4double Quench(G4double edep, G4double stepLength) const;
+
+    // Detector response to the visible energy deposited from firstTime on
+    void Apply(G4int det, G4double visibleEnergy, G4double firstTime,
+               G4int& npe, G4double& time, G4double& amplitude) const;
+
+  private:
+    struct Constants {
+      G4double pePerMeV = 0.;
+      G4double mevPerMV = 0.1;
+      G4double offset = 0.;
+      G4double opticalJitter = 0.;
+      G4double electronicJitter = 0.;
+    };
+
+    G4double fBirks;
+    std::vector<Constants> fConstants;   // [det]
+};
+
+#endif
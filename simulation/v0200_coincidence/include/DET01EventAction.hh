@@ -0,0 +1,42 @@
+#ifndef DET01EventAction_h
+#define DET01EventAction_h 1
+
+#include "G4UserEventAction.hh"
+#include "DET01EventData.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class DET01RunAction;
+class DET01ScintSD;
+class DET01PmtDigitizer;
+
+/// Event action: collects the scintillator and PMT hits of each event into
+/// a DET01EventData record and hands it to the run action for the ntuple.
+/// With digitized output the photoelectron times of every PMT go through
+/// DET01PmtDigitizer, with one common window start per event; with
+/// /det01/output/photonTimes they also go to the photon-time sidecar.
+
+class DET01EventAction : public G4UserEventAction
+{
+  public:
+    DET01EventAction(DET01RunAction* runAction);
+    virtual ~DET01EventAction();
+
+    virtual void BeginOfEventAction(const G4Event* event);
+    virtual void EndOfEventAction(const G4Event* event);
+
+  private:
+    DET01RunAction* fRunAction;
+    DET01EventData fEventData;
+
+    G4int fScintHCID;
+    G4int fPmtHCID;
+    G4bool fPmtAccumulate;  // PMT collection holds DET01PmtHit (one per PMT)
+    const DET01ScintSD* fScintSD;
+
+    DET01PmtDigitizer* fDigitizer;
+    std::vector<std::vector<G4double>> fPeTimes;   // [pmt] photoelectron times
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef DET01EventData_h
+#define DET01EventData_h 1
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <vector>
+
+/// Per-event detector summary, filled by DET01EventAction from the hits
+/// collections and written by DET01RunAction::FillNtuple().
+/// All per-detector vectors are indexed by copy number.
+
+struct DET01EventData
+{
+  G4int eventID = 0;
+  G4double truthZ = 0.;
+  G4double weight = 1.;             // primary vertex weight (biased generation)
+  G4int seed[2] = { 0, 0 };         // per-event seeds (DET01EventSeeds), 0 if not seeded
+
+  std::vector<G4double> edep;       // energy deposit per scintillator
+  std::vector<G4int>    pe;         // photoelectrons per PMT
+  std::vector<G4double> time;       // first photon time per PMT, -1 if no PE
+  std::vector<G4double> amplitude;  // pulse height [mV], energy-only optics mode
+  std::vector<G4double> digiAmplitude;  // digitized pulse height [mV]
+  std::vector<G4double> digiTime;       // digitized CFD time, -1 if none
+
+  std::vector<G4bool>        hasPrimary;  // primary deposited in this scintillator
+  std::vector<G4ThreeVector> posIn;       // primary entry point
+  std::vector<G4ThreeVector> posOut;      // primary exit point
+
+  void Clear(G4int nDetectors)
+  {
+    edep.assign(nDetectors, 0.);
+    pe.assign(nDetectors, 0);
+    time.assign(nDetectors, -1.);
+    amplitude.assign(nDetectors, 0.);
+    digiAmplitude.assign(nDetectors, 0.);
+    digiTime.assign(nDetectors, -1.);
+    hasPrimary.assign(nDetectors, false);
+    posIn.assign(nDetectors, G4ThreeVector());
+    posOut.assign(nDetectors, G4ThreeVector());
+  }
+};
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef DET01EventSeeds_h
+#define DET01EventSeeds_h 1
+
+#include "G4VAccumulable.hh"
+#include "globals.hh"
+
+#include <utility>
+#include <vector>
+
+class G4Event;
+class G4GenericMessenger;
+class DET01Trigger;
+struct DET01EventData;
+
+/// Per-event seeds and two-pass selective re-simulation (/det01/seeds/).
+///
+/// With /det01/seeds/perEvent true every event reseeds the engine of its
+/// thread at the start of DET01PrimaryGeneratorAction::GeneratePrimaries(),
+/// from /det01/seeds/base and its EventID only (SplitMix64), so an event can
+/// be regenerated on its own in any run. The seeds go to the Seed0 and Seed1
+/// ntuple columns.
+///
+/// Independent jobs must differ in base or EventID, otherwise they
+/// regenerate the same events: det01 -s <seed> sets the base to the run
+/// seed, det01_mpi to (seed, rank) and /det01/mpi/beamOn numbers the events
+/// of the ranks apart with /det01/seeds/eventOffset; det01_scan.py sets the
+/// base and offset of every job.
+///
+/// Pass 1 (cheap): with /det01/seeds/select <file> (implies perEvent), the
+/// events passing the selection are listed as "eventID seed0 seed1" in
+/// <file>, written by the master at end of run, sorted by EventID:
+///  - edepLow/edepHigh : a scintillator deposit in [low, high] (near threshold)
+///  - coincidence "a-b ..." : both detectors of a pair fired (DET01Trigger)
+///  - crosstalk "a-b ..."   : exactly one detector of a pair fired
+/// (any criterion; none set: the events accepted by the trigger).
+///
+/// Pass 2 (full optics): /det01/seeds/replay <file> loads a list and
+/// /det01/seeds/beamOn runs one event per entry, with the listed EventID and
+/// seeds, so EventID and truth (Truth_Z, entry/exit positions) match pass 1.
+///
+/// The charged-particle stage is bit-identical between the passes when both
+/// use the full optics mode with /det01/physics/isolateOptics true (pass 1
+/// adds /det01/physics/generatePhotons false): the photon generation then
+/// draws from DET01IsolatedOptics's engine, reseeded here from the event
+/// seeds, and the photons are tracked after the charged stage. Without it
+/// pass 2 regenerates only the primaries exactly and a warning is issued.
+
+class DET01EventSeeds : public G4VAccumulable
+{
+  public:
+    DET01EventSeeds(const G4String& name = "EventSeeds");
+    virtual ~DET01EventSeeds();
+
+    static DET01EventSeeds* GetInstance();
+
+    virtual void Merge(const G4VAccumulable& other);
+    virtual void Reset();
+
+    // Seed0/Seed1 columns are written
+    G4bool IsRecording() const { return fPerEvent || !fSelectFile.empty() || !fReplay.empty(); }
+
+    // First action of every event: EventID, seeds and reseeding
+    void BeginEvent(const G4Event* event);
+    G4int GetEventID() const { return fEventID; }
+    G4int GetSeed(G4int i) const { return fSeeds[i]; }
+
+    // One call per event (pass 1 selection)
+    void Select(const DET01EventData& data, const DET01Trigger* trigger, G4bool accepted);
+
+    // Master, end of run: the selected events of pass 1
+    void WriteSelection(const G4String& suffix = "") const;
+
+  private:
+    struct Entry {
+      G4int eventID;
+      G4int seed0;
+      G4int seed1;
+    };
+
+    void LoadReplay(const G4String& fileName);
+    void BeamOn();
+    void ParsePairs();
+    static std::vector<std::pair<G4int, G4int>> ParsePairList(const G4String& list);
+    static void DeriveSeeds(G4int base, G4int eventID, G4int seeds[2]);
+
+    G4GenericMessenger* fMessenger;
+    G4bool fPerEvent;
+    G4int fBase;
+    G4int fEventOffset;
+
+    // Selection
+    G4String fSelectFile;
+    G4double fEdepLow;
+    G4double fEdepHigh;   // <= 0: no deposit window
+    G4String fCoincidence;
+    G4String fCrosstalk;
+    G4String fParsedCoincidence;
+    G4String fParsedCrosstalk;
+    std::vector<std::pair<G4int, G4int>> fCoincidencePairs;
+    std::vector<std::pair<G4int, G4int>> fCrosstalkPairs;
+    std::vector<Entry> fSelected;
+
+    // Replay list (pass 2), indexed by the event number in the run
+    G4String fReplayFile;
+    std::vector<Entry> fReplay;
+
+    // This event
+    G4int fEventID;
+    G4int fSeeds[2];
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef DET01IsolatedOptics_h
+#define DET01IsolatedOptics_h 1
+
+#include "G4WrapperProcess.hh"
+#include "G4ParticleChange.hh"
+#include "globals.hh"
+
+namespace CLHEP { class HepRandomEngine; }
+
+/// Wrapper of the Scintillation and Cerenkov processes, installed by
+/// DET01PhysicsList with /det01/physics/isolateOptics true.
+///
+/// The DoIt of the wrapped process (the photon generation) draws from a
+/// separate per-thread engine, GetEngine(), reseeded at every event by
+/// DET01EventSeeds, so that the random stream of the charged-particle
+/// transport does not depend on how many photons are made. The step limits
+/// (GPIL) are those of the wrapped process. With SetGeneratePhotons(false)
+/// the DoIt is skipped altogether: same transport, no photons — the cheap
+/// first pass of a two-pass run.
+
+class DET01IsolatedOptics : public G4WrapperProcess
+{
+  public:
+    DET01IsolatedOptics();
+    virtual ~DET01IsolatedOptics();
+
+    virtual G4VParticleChange* PostStepDoIt(const G4Track& track, const G4Step& step);
+    virtual G4VParticleChange* AtRestDoIt(const G4Track& track, const G4Step& step);
+
+    // Wrappers installed on this thread (the engine exists)
+    static G4bool IsActive() { return GetEngine() != nullptr; }
+    static CLHEP::HepRandomEngine* GetEngine();
+    static void Reseed(long seed0, long seed1);
+
+    // Shared by all threads, changed between runs only
+    static void SetGeneratePhotons(G4bool generate) { fGeneratePhotons = generate; }
+    static G4bool GetGeneratePhotons() { return fGeneratePhotons; }
+
+  private:
+    G4ParticleChange fNoChange;
+
+    static G4bool fGeneratePhotons;
+};
+
+#endif
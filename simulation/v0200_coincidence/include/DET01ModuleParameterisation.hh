@@ -0,0 +1,37 @@
+#ifndef DET01ModuleParameterisation_h
+#define DET01ModuleParameterisation_h 1
+
+#include "G4VPVParameterisation.hh"
+#include "G4RotationMatrix.hh"
+#include "G4ThreeVector.hh"
+#include "G4Transform3D.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class G4VPhysicalVolume;
+
+/// Placement of the detector module envelopes (scintillator + PMT stack)
+/// as one G4PVParameterised: copy i gets the i-th module-to-world transform
+/// (stack positions or the ring layout, ring by ring), so copy numbers are
+/// the detector IDs. The mother, the "Detectors" air envelope placed in the
+/// World next to the Target (a parameterised volume must be the only
+/// daughter of its mother), then holds a single voxelized daughter instead
+/// of four placements per detector.
+
+class DET01ModuleParameterisation : public G4VPVParameterisation
+{
+  public:
+    DET01ModuleParameterisation(const std::vector<G4Transform3D>& modules);
+    virtual ~DET01ModuleParameterisation();
+
+    virtual void ComputeTransformation(const G4int copyNo, G4VPhysicalVolume* physVol) const;
+
+    G4int GetNModules() const { return fTranslations.size(); }
+
+  private:
+    std::vector<G4ThreeVector> fTranslations;
+    std::vector<G4RotationMatrix> fRotations;   // frame rotations (inverse)
+};
+
+#endif
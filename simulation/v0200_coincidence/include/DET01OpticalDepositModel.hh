@@ -0,0 +1,72 @@
+#ifndef DET01OpticalDepositModel_h
+#define DET01OpticalDepositModel_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+class G4Step;
+class G4Material;
+class DET01OpticalResponseMap;
+class DET01SensitiveDetector;
+
+/// Fast optics (/det01/optics/mode fast): photoelectrons sampled from the
+/// charged-particle deposits, without creating any optical photon.
+///
+/// DET01ScintSD hands every scintillator step to Deposit(). As in
+/// G4Scintillation, the visible energy of the step (G4EmSaturation) times
+/// SCINTILLATIONYIELD gives the mean number of photons, drawn from a
+/// Poisson (mean <= 10) or a Gaussian of width RESOLUTIONSCALE x sqrt(mean).
+/// The PE count of the module's own PMT is binomial in that number, with the
+/// detection efficiency of the response map averaged along the step
+/// (segments of at most half a voxel). Every PE then gets
+///  - an emission point: a segment drawn by its efficiency, uniform within,
+///  - the time of the track at that point plus a scintillation delay
+///    (SCINTILLATIONTIMECONSTANT1; SCINTILLATIONRISETIME1 only with
+///    /process/optical/scintillation/setFiniteRiseTime true, as
+///    G4Scintillation),
+///  - a transit time sampled from the map at the emission point,
+/// and goes to the photocathode SD (AddPhotoelectron()). The cost scales
+/// with the number of PE, not of photons.
+///
+/// In this mode DET01PhysicsList::SetStackPhotons(false) keeps G4Scintillation
+/// and G4Cerenkov from stacking any photon, so the Cerenkov light (about 1%
+/// of the scintillation light in the modules) is left out.
+///
+/// Reduced yield (/det01/optics/yieldFraction f < 1, full mode): the
+/// material yield is f x SCINTILLATIONYIELD and those photons are tracked;
+/// the model runs next to them with yieldScale (1 - f) / f and samples the
+/// PE of the untracked (1 - f) share. Both are drawn from the deposit, so
+/// the sum has the PE statistics of the full yield.
+
+class DET01OpticalDepositModel
+{
+  public:
+    // Takes ownership of the map; yieldScale multiplies the material yield
+    DET01OpticalDepositModel(const DET01OpticalResponseMap* map, DET01SensitiveDetector* pmtSD,
+                             G4double yieldScale = 1.);
+    ~DET01OpticalDepositModel();
+
+    // One scintillator step of module detID with energy deposit
+    void Deposit(const G4Step* step, G4int detID);
+
+  private:
+    void SetMaterial(const G4Material* material);
+    G4double SampleEmissionDelay() const;
+
+    const DET01OpticalResponseMap* fMap;
+    DET01SensitiveDetector* fPmtSD;
+    G4double fSegmentLength;
+    G4double fYieldScale;
+
+    // Scintillation constants of the last material seen
+    const G4Material* fMaterial;
+    G4double fYield;           // photons per unit visible energy, scaled
+    G4double fResolutionScale;
+    G4double fDecayTime;
+    G4double fRiseTime;        // 0: no finite rise time
+
+    std::vector<G4double> fSegmentSum;   // cumulated segment efficiencies (scratch)
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef DET01OpticalFastSimModel_h
+#define DET01OpticalFastSimModel_h 1
+
+#include "G4VFastSimulationModel.hh"
+#include "globals.hh"
+
+class G4Region;
+
+/// Response-map recorder of the buildMap optics mode.
+///
+/// Attached to the "ScintillatorRegion" envelope, it sees every optical
+/// photon on its first step, records its emission point into the
+/// thread-local builder map (DET01OpticalResponseMap::GetBuilder()) and
+/// leaves it to normal tracking; the photocathode SD records the
+/// detections. The model never takes a photon over.
+///
+/// The fast optics mode does not use it: DET01OpticalDepositModel samples
+/// the photoelectrons from the charged deposits and no photon is created.
+
+class DET01OpticalFastSimModel : public G4VFastSimulationModel
+{
+  public:
+    DET01OpticalFastSimModel(const G4String& name, G4Region* envelope);
+    virtual ~DET01OpticalFastSimModel();
+
+    virtual G4bool IsApplicable(const G4ParticleDefinition& particle);
+    virtual G4bool ModelTrigger(const G4FastTrack& fastTrack);
+    virtual void   DoIt(const G4FastTrack& fastTrack, G4FastStep& fastStep);
+};
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef DET01OpticalResponseMap_h
+#define DET01OpticalResponseMap_h 1
+
+#include "G4VAccumulable.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class G4Navigator;
+
+/// Optical response of one scintillator + PMT module, binned on a voxel
+/// grid in the scintillator's local frame.
+///
+/// For every voxel the map holds the number of scintillation photons emitted
+/// there, how many of them reached the module's own photocathode, and the
+/// histogram of their transit time (emission -> photocathode).
+///
+/// The same class is used in two ways:
+///  - building: a thread-local instance (GetBuilder()) is filled during a
+///    full-optics run and merged through G4AccumulableManager;
+///  - sampling: an instance loaded with Read() gives the detection
+///    efficiency and samples a transit time for DET01OpticalDepositModel.
+
+class DET01OpticalResponseMap : public G4VAccumulable
+{
+  public:
+    DET01OpticalResponseMap(const G4String& name = "OpticalResponseMap");
+    virtual ~DET01OpticalResponseMap();
+
+    // Thread-local instance filled in "buildMap" optics mode
+    static DET01OpticalResponseMap* GetBuilder();
+
+    virtual void Merge(const G4VAccumulable& other);
+    virtual void Reset();
+
+    // Grid definition (scintillator local frame)
+    void SetGrid(const G4ThreeVector& lo, const G4ThreeVector& hi,
+                 G4double voxelSize);
+    G4bool HasGrid() const { return fNx > 0; }
+    // Smallest voxel edge
+    G4double GetVoxelSize() const;
+
+    // Building
+    void RecordEmission(const G4ThreeVector& localPos);
+    void RecordDetection(const G4ThreeVector& globalVertex, G4int pmtID,
+                         G4double transitTime);
+
+    // I/O
+    G4bool Write(const G4String& fileName) const;
+    G4bool Read(const G4String& fileName);
+
+    // Sampling (only valid after Read())
+    G4double GetEfficiency(const G4ThreeVector& localPos) const;
+    G4double SampleTransitTime(const G4ThreeVector& localPos) const;
+
+    G4double GetTotalEmitted() const;
+    G4double GetTotalDetected() const;
+
+  private:
+    G4int VoxelIndex(const G4ThreeVector& localPos) const;
+    void  RecordDetectionLocal(const G4ThreeVector& localPos, G4double transitTime);
+    void  BuildSamplingTables();
+
+    G4ThreeVector fLo;
+    G4ThreeVector fHi;
+    G4int fNx, fNy, fNz;
+    G4int fNt;          // transit-time bins
+    G4double fTmax;     // upper edge of the transit-time histogram
+
+    std::vector<G4double> fEmitted;    // [voxel]
+    std::vector<G4double> fDetected;   // [voxel]
+    std::vector<G4double> fTimeCounts; // [voxel*fNt + bin]
+
+    // Sampling tables (filled by Read())
+    std::vector<G4double> fEfficiency; // [voxel]
+    std::vector<G4double> fTimeCDF;    // [(voxel+1)*fNt + bin], row 0 = whole module
+
+    G4Navigator* fNavigator;           // locates photon vertices while building
+};
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef DET01OutputShards_h
+#define DET01OutputShards_h 1
+
+#include "G4VAccumulable.hh"
+#include "globals.hh"
+
+#include <vector>
+
+/// Worker threads that opened their own output file in the current run
+/// (streaming mode). Each worker adds its thread ID when it opens
+/// <name>_t<i>.root; the master merges the IDs at end of run and lists
+/// exactly those files in the shard index. A thread that got no event of
+/// the run (tasking) never adds itself, so a file it left behind in an
+/// earlier run is not listed.
+
+class DET01OutputShards : public G4VAccumulable
+{
+  public:
+    DET01OutputShards(const G4String& name = "OutputShards");
+    virtual ~DET01OutputShards();
+
+    virtual void Merge(const G4VAccumulable& other);
+    virtual void Reset();
+
+    void Add(G4int threadId);
+
+    // Sorted, unique
+    const std::vector<G4int>& GetThreads() const { return fThreads; }
+
+  private:
+    std::vector<G4int> fThreads;
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef DET01PhysicsList_h
+#define DET01PhysicsList_h 1
+
+#include "QGSP_BIC_HP.hh"
+#include "globals.hh"
+
+class G4VPhysicsConstructor;
+class G4GenericMessenger;
+
+/// QGSP_BIC_HP + optical physics + fast-simulation and biasing hooks.
+///
+/// The optical physics can be dropped before /run/initialize
+/// (SetOpticalPhysics(false), used by the energy-only optics mode), so that
+/// no scintillation or Cerenkov photon is ever produced.
+///
+/// Variants (/det01/physics/variant, before /run/initialize):
+///  - reference : plain QGSP_BIC_HP everywhere (default)
+///  - light     : same list, but in the world region the HP neutron models
+///                (below 20 MeV) are replaced by G4HadronElastic, G4BinaryCascade
+///                and G4NeutronRadCapture, so the HP final states only run in
+///                the target and scintillator regions. The models are switched
+///                per material (G4HadronicInteraction::DeActivateFor), for the
+///                materials used only in the world region at /run/initialize.
+///                Validate against reference with det01_mapcheck.
+///
+/// Two-pass runs (/det01/seeds/): /det01/physics/isolateOptics true (before
+/// /run/initialize) wraps Scintillation and Cerenkov in DET01IsolatedOptics
+/// and turns their TrackSecondariesFirst off, so that the charged-particle
+/// stage of an event is the same whether photons are made or not;
+/// /det01/physics/generatePhotons false then gives the photon-free pass.
+
+class DET01PhysicsList : public QGSP_BIC_HP
+{
+  public:
+    DET01PhysicsList();
+    virtual ~DET01PhysicsList();
+
+    virtual void ConstructProcess();
+
+    void SetOpticalPhysics(G4bool enable);
+    // Scintillation and Cerenkov photons stacked (false: fast optics mode)
+    void SetStackPhotons(G4bool stack);
+    G4bool HasOpticalPhysics() const { return fOpticalRegistered; }
+
+    const G4String& GetVariant() const { return fVariant; }
+
+    G4bool IsOpticsIsolated() const { return fIsolateOptics; }
+
+  private:
+    void DefineCommands();
+    void SetIsolateOptics(G4bool isolate);
+    void SetGeneratePhotons(G4bool generate);
+    void IsolateOpticalProcesses();
+    void UseLightNeutronModelsInWorld();
+
+    G4GenericMessenger* fMessenger;
+    G4String fVariant;
+    G4bool fIsolateOptics;
+
+    G4VPhysicsConstructor* fOpticalPhysics;
+    G4bool fOpticalRegistered;
+};
+
+#endif
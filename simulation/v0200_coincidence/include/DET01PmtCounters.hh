@@ -0,0 +1,54 @@
+#ifndef DET01PmtCounters_h
+#define DET01PmtCounters_h 1
+
+#include "G4VAccumulable.hh"
+#include "globals.hh"
+
+#include <vector>
+
+#ifdef DET01_USE_MPI
+#include <mpi.h>
+#endif
+
+/// Run-level photoelectron counters of the PMT SD.
+///
+/// Each thread fills its own instance (GetInstance()) once per event; the
+/// instances are merged through G4AccumulableManager and the master prints
+/// the summary at end of run: photoelectrons per PMT, mean and maximum per
+/// event, and the number of events without any photoelectron.
+
+class DET01PmtCounters : public G4VAccumulable
+{
+  public:
+    DET01PmtCounters(const G4String& name = "PmtCounters");
+    virtual ~DET01PmtCounters();
+
+    static DET01PmtCounters* GetInstance();
+
+    virtual void Merge(const G4VAccumulable& other);
+    virtual void Reset();
+
+    // One call per event with the photoelectrons of every PMT
+    void Fill(const std::vector<G4int>& pePerPmt);
+
+    void Print() const;
+
+#ifdef DET01_USE_MPI
+    // Collective: sum all ranks into rank 0 (MPI build)
+    void ReduceOverRanks(MPI_Comm comm);
+#endif
+
+    G4long GetNEvents() const { return fNEvents; }
+    G4long GetNZeroEvents() const { return fNZeroEvents; }
+
+  private:
+    void Resize(size_t nPmts);
+
+    G4long fNEvents;
+    G4long fNZeroEvents;                // no PE in any PMT
+    std::vector<G4double> fTotalPE;     // [pmt]
+    std::vector<G4int>    fMaxPE;       // [pmt]
+    std::vector<G4long>   fZeroPE;      // [pmt] events with no PE in this PMT
+};
+
+#endif
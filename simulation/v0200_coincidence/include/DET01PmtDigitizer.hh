@@ -0,0 +1,80 @@
+#ifndef DET01PmtDigitizer_h
+#define DET01PmtDigitizer_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+class G4GenericMessenger;
+class DET01PmtResponse;
+
+/// PMT waveform digitizer (/det01/digi/), one per worker.
+///
+/// The commands set a DET01PmtResponse (TTS, single-PE gain spread,
+/// template, noise, CFD; the model det01_replay uses as well), which folds
+/// the photoelectron times of a PMT with the Geant4 engine. The waveform
+/// starts at the event's window start; the CFD time is returned in the
+/// event time frame (ns).
+///
+/// Template: bi-exponential (riseTime, fallTime) or a measured pulse from
+/// /det01/digi/templateFile (one value per line at samplePeriod, any scale;
+/// normalised to peak 1).
+
+class DET01PmtDigitizer
+{
+  public:
+    DET01PmtDigitizer();
+    ~DET01PmtDigitizer();
+
+    // Digitize the photoelectron times of one PMT: amplitude [mV] and CFD
+    // time (< 0: no CFD time)
+    void Digitize(const std::vector<G4double>& peTimes, G4double windowStart,
+                  G4double& amplitude, G4double& time);
+
+    // Window start before the earliest photoelectron of the event
+    G4double GetPreTrigger() const { return fPreTrigger; }
+
+  private:
+    void DefineCommands();
+    void Build();
+    void SetGain(G4double value) { fGain = value; fDirty = true; }
+    void SetGainSpread(G4double value) { fGainSpread = value; fDirty = true; }
+    void SetTTS(G4double value) { fTTS = value; fDirty = true; }
+    void SetNoise(G4double value) { fNoise = value; fDirty = true; }
+    void SetRiseTime(G4double value) { fRiseTime = value; fDirty = true; }
+    void SetFallTime(G4double value) { fFallTime = value; fDirty = true; }
+    void SetTemplateFile(const G4String& value) { fTemplateFile = value; fDirty = true; }
+    void SetSamplePeriod(G4double value) { fSamplePeriod = value; fDirty = true; }
+    void SetNSamples(G4int value) { fNSamples = value; fDirty = true; }
+    void SetCfdFraction(G4double value) { fCfdFraction = value; fDirty = true; }
+    void SetCfdDelay(G4double value) { fCfdDelay = value; fDirty = true; }
+    void SetThreshold(G4double value) { fThreshold = value; fDirty = true; }
+    void SetBaselineTime(G4double value) { fBaselineTime = value; fDirty = true; }
+
+    G4GenericMessenger* fMessenger;
+
+    // Response
+    G4double fGain;           // per PE [mV]
+    G4double fGainSpread;     // relative sigma of the single-PE gain
+    G4double fTTS;            // transit-time spread sigma
+    G4double fNoise;          // rms per sample [mV]
+    G4double fRiseTime, fFallTime;
+    G4String fTemplateFile;
+
+    // Sampling
+    G4double fSamplePeriod;
+    G4int fNSamples;
+    G4double fPreTrigger;
+
+    // CFD
+    G4double fCfdFraction;
+    G4double fCfdDelay;
+    G4double fThreshold;      // [mV]
+    G4double fBaselineTime;
+
+    // Built from the settings
+    G4bool fDirty;
+    DET01PmtResponse* fResponse;
+};
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef DET01PmtHit_h
+#define DET01PmtHit_h 1
+
+#include "G4VHit.hh"
+#include "G4THitsCollection.hh"
+#include "G4Allocator.hh"
+#include "globals.hh"
+
+#include <vector>
+
+/// Per-PMT photoelectron record used in accumulation mode.
+///
+/// The PMT SD keeps one of these per photocathode and event: photoelectron
+/// count, earliest arrival time and, optionally, a binned arrival-time
+/// histogram (times outside its range are counted in the PE count and first
+/// time but not binned) and the list of every photoelectron time (for the
+/// digitizer and the photon-time sidecar).
+
+class DET01PmtHit : public G4VHit
+{
+  public:
+    DET01PmtHit();
+    DET01PmtHit(const DET01PmtHit&);
+    virtual ~DET01PmtHit();
+
+    // operators
+    const DET01PmtHit& operator=(const DET01PmtHit&);
+    G4bool operator==(const DET01PmtHit&) const;
+
+    inline void* operator new(size_t);
+    inline void  operator delete(void*);
+
+    // methods from base class
+    virtual void Draw();
+    virtual void Print();
+
+    // Photoelectron at the given arrival time
+    inline void AddPhotoelectron(G4double time);
+
+    void SetTimeBinning(G4int nBins, G4double binWidth);
+    void SetKeepTimes(G4bool keep) { fKeepTimes = keep; }
+
+    // Set methods
+    void SetDetID(G4int id) { fDetID = id; }
+
+    // Get methods
+    G4int GetDetID() const { return fDetID; }
+    G4int GetNPE() const { return fNPE; }
+    G4double GetFirstTime() const { return fFirstTime; }
+    G4double GetTimeBinWidth() const { return fTimeBinWidth; }
+    const std::vector<G4int>& GetTimeHistogram() const { return fTimeHist; }
+    const std::vector<G4double>& GetTimes() const { return fTimes; }
+
+  private:
+    G4int fDetID;
+    G4int fNPE;
+    G4double fFirstTime;
+    G4double fTimeBinWidth;
+    std::vector<G4int> fTimeHist;
+    G4bool fKeepTimes;
+    std::vector<G4double> fTimes;
+};
+
+typedef G4THitsCollection<DET01PmtHit> DET01PmtHitsCollection;
+
+extern G4ThreadLocal G4Allocator<DET01PmtHit>* DET01PmtHitAllocator;
+
+inline void* DET01PmtHit::operator new(size_t)
+{
+  if(!DET01PmtHitAllocator)
+      DET01PmtHitAllocator = new G4Allocator<DET01PmtHit>;
+  return (void *) DET01PmtHitAllocator->MallocSingle();
+}
+
+inline void DET01PmtHit::operator delete(void *hit)
+{
+  DET01PmtHitAllocator->FreeSingle((DET01PmtHit*) hit);
+}
+
+inline void DET01PmtHit::AddPhotoelectron(G4double time)
+{
+  fNPE++;
+  if (time < fFirstTime) fFirstTime = time;
+  if (fKeepTimes) fTimes.push_back(time);
+
+  if (!fTimeHist.empty() && time >= 0.) {
+      G4double bin = time / fTimeBinWidth;
+      if (bin < fTimeHist.size()) fTimeHist[(size_t)bin]++;
+  }
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef DET01PrimaryGeneratorAction_h
+#define DET01PrimaryGeneratorAction_h 1
+
+#include "G4VUserPrimaryGeneratorAction.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+class G4Event;
+class G4GeneralParticleSource;
+class G4ParticleGun;
+class G4GenericMessenger;
+class DET01ScatteringSampler;
+class DET01CosmicGenerator;
+class DET01RunAction;
+
+/// Primary generator (/det01/gun/mode):
+///  - gps     : G4GeneralParticleSource, configured by /gps/ macros (default)
+///  - scatter : one elastically scattered deuteron per event from
+///              DET01ScatteringSampler, emitted from /det01/gun/vertex around
+///              the +z beam axis; the sampler weight is set on the vertex
+///  - cosmic  : one muon per event from DET01CosmicGenerator (/det01/cosmic/),
+///              only on trajectories crossing the detector envelope; every
+///              event adds 1/rate to the live time of the run summary
+
+class DET01PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
+{
+  public:
+    DET01PrimaryGeneratorAction(DET01RunAction* runAction);
+    virtual ~DET01PrimaryGeneratorAction();
+
+    virtual void GeneratePrimaries(G4Event* anEvent);
+
+  private:
+    void DefineCommands();
+
+    G4GeneralParticleSource* fParticleGun;
+    G4ParticleGun* fScatterGun;
+    DET01ScatteringSampler* fSampler;
+    G4ParticleGun* fCosmicGun;
+    DET01CosmicGenerator* fCosmic;
+    DET01RunAction* fRunAction;
+
+    G4GenericMessenger* fMessenger;
+    G4String fMode;
+    G4ThreeVector fVertex;
+};
+
+#endif
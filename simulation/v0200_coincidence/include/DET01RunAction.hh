@@ -0,0 +1,144 @@
+#ifndef DET01RunAction_h
+#define DET01RunAction_h 1
+
+#include "G4UserRunAction.hh"
+#include "G4Accumulable.hh"
+#include "DET01PhotonTimes.hh"
+#include "DET01OutputShards.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class G4Run;
+class G4GenericMessenger;
+class DET01Trigger;
+class DET01Checkpoint;
+class DET01Telemetry;
+struct DET01EventData;
+
+/// Run action: books the event ntuple, opens/writes the output file and
+/// merges and prints the run-level accumulables.
+///
+/// The ntuple layout follows the detector count of the geometry and the
+/// /det01/output/ commands; it is booked at the first run and rebooked at
+/// the start of a run whose layout differs from the booked one:
+///  - EventID, Edep_Scin<i>, PE_PMT<i>, Time_PMT<i>, Truth_Z, Weight
+///    (Weight: vertex weight x target biasing weight, always double, 1 if unbiased)
+///  - energy-only optics mode: Amp_PMT<i> pulse heights [mV]
+///  - digitized true: DigiAmp_PMT<i> [mV] and DigiTime_PMT<i> (CFD) from
+///    DET01PmtDigitizer (the PMT records then keep every photoelectron time)
+///  - photonTimes true: every event's PMT photoelectron times also go to
+///    the sidecar <name>_photons[_t<i>].bin (DET01PhotonTimes, 1 ps ticks,
+///    all events, before the trigger) for re-digitizing with det01_replay
+///  - precision: double (default, as the fixed layout had) or float for the
+///    real-valued columns; readers take the same flag (det01_mapcheck,
+///    det01_ratecheck, det01_calib --precision)
+///  - streaming true: every worker writes <name>_t<i>.root (bounded memory,
+///    no end-of-run merge), listed in <name>_shards.txt (the files the
+///    workers opened in this run, DET01OutputShards); default is merging
+///    into the master file
+///  - positions true: primary entry/exit points as vector columns holding
+///    only the detectors the primary deposited energy in
+///    (Pos_DetID, Pos_InX/Y/Z, Pos_OutX/Y/Z). Replaces the former fixed
+///    Scin<i>_InX .. Scin<i>_OutZ columns, which are no longer written
+///  - events false: no rows (run-level summaries only, e.g. the
+///    DET01AsymmetryCounters fit of polarization scans)
+///
+/// Only events accepted by the DET01Trigger reach the ntuple; accepted and
+/// rejected events are counted in the run summary, together with the cosmic
+/// live time when the run used the cosmic generator.
+///
+/// Live telemetry (/det01/telemetry/): the master's DET01Telemetry samples
+/// the run to <name>_telemetry.jsonl while it goes.
+///
+/// MPI build (det01_mpi, DET01_USE_MPI): every rank writes <name>_rank<r>.root.
+/// /det01/mpi/beamOn N splits N events over the ranks; once every rank's
+/// run is over (also a rank without events), the counters are summed on
+/// rank 0, which prints the summary and lists the rank files in
+/// <name>_ranks.txt. /mpi/beamOn runs the ranks without that summary.
+
+class DET01RunAction : public G4UserRunAction
+{
+  public:
+    DET01RunAction();
+    virtual ~DET01RunAction();
+
+    virtual void BeginOfRunAction(const G4Run*);
+    virtual void   EndOfRunAction(const G4Run*);
+
+    // Number of detectors of the booked ntuple
+    G4int GetNDetectors() const { return fNDetectors; }
+    // Booked with the digitized pulse columns
+    G4bool IsDigitized() const { return fColDigiAmp >= 0; }
+    // Photon-time sidecar open on this thread
+    G4bool WritesPhotonTimes() const { return fPhotonTimesWriter.IsOpen(); }
+    // times[pmt] are converted to ns and sorted in place
+    void WritePhotonTimes(G4int eventID, std::vector<std::vector<G4double>>& times);
+
+    void FillNtuple(const DET01EventData& data);
+    // Rows per event (/det01/output/events)
+    G4bool WritesEvents() const { return fWriteEvents; }
+
+    const DET01Trigger* GetTrigger() const { return fTrigger; }
+    void CountTrigger(G4bool accepted);
+
+    // Equivalent exposure of the generated events (cosmic generator)
+    void AddLiveTime(G4double time) { fLiveTime += time; }
+
+  private:
+    void DefineCommands();
+    void BookNtuple(G4int nDetectors, G4bool amplitudes);
+    G4String Layout(G4int nDetectors, G4bool amplitudes) const;
+    G4int CreateRealColumn(const G4String& name);
+    void FillRealColumn(G4int column, G4double value);
+    void WriteShardIndex() const;
+    void PrintRunSummary();
+#ifdef DET01_USE_MPI
+    static G4String RankFileName(const G4String& fileName, G4int rank);
+    void BeamOnRanks(G4int nEvents);
+    G4bool ReduceOverRanks();   // true on rank 0
+#endif
+
+    G4GenericMessenger* fMessenger;
+    DET01Checkpoint* fCheckpoint;   // master only
+    DET01Telemetry* fTelemetry;     // master only
+    DET01Trigger* fTrigger;
+    G4Accumulable<G4long> fNAccepted;
+    G4Accumulable<G4long> fNRejected;
+    G4Accumulable<G4double> fLiveTime;
+    DET01OutputShards fShards;
+
+    G4String fNtupleName;
+    G4String fPrecision;
+    G4bool fWritePositions;
+    G4bool fWriteEvents;
+    G4bool fStreaming;
+    G4int fBasketSize;
+    G4bool fPhotonTimes;
+    DET01PhotonTimesWriter fPhotonTimesWriter;   // worker (or sequential) threads
+#ifdef DET01_USE_MPI
+    G4GenericMessenger* fMpiMessenger;   // master only
+    G4String fBaseFileName;     // /analysis/setFileName
+    G4String fRankFileName;     // opened by this rank
+    G4bool fRankRan;            // this rank's last BeamOnRanks() had events
+#endif
+
+    // Booked layout
+    G4bool fBooked;
+    G4String fBookedLayout;   // Layout() at booking
+    G4bool fUseFloat;
+    G4int fNtupleId;
+    G4int fNDetectors;
+    G4int fColEventID, fColEdep, fColPE, fColTime, fColTruthZ, fColWeight;
+    G4int fColAmp;        // -1: no amplitude columns
+    G4int fColSeed;       // -1: no Seed0/Seed1 columns
+    G4bool fDigitized;
+    G4int fColDigiAmp, fColDigiTime;   // -1: not digitized
+
+    // Vector columns (positions block)
+    std::vector<G4int> fPosDetID;
+    std::vector<G4float> fPosInX, fPosInY, fPosInZ;
+    std::vector<G4float> fPosOutX, fPosOutY, fPosOutZ;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef DET01ScatteringSampler_h
+#define DET01ScatteringSampler_h 1
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class G4GenericMessenger;
+
+/// Direct sampler for elastically scattered deuterons (d-p, proton at rest).
+///
+/// The angular distribution is
+///   f(theta, phi) ~ sin(theta) exp(-b |t|) * (A + B cos(phi) + C cos(2 phi))
+/// with theta the lab polar angle w.r.t. the beam axis, |t| the momentum
+/// transfer from two-body kinematics and b the slope in (GeV/c)^-2 (0 =
+/// isotropic in the lab). Both factors are tabulated once as inverse CDFs,
+/// so every event costs exactly three random numbers (region, theta, phi);
+/// the tables are rebuilt only after a /det01/scatter/ command or the
+/// geometry changed them.
+///
+/// With /det01/scatter/acceptance true the sampling is restricted to the
+/// detector faces of the ring layout as seen from the vertex (SetVertex()),
+/// approximated as a theta band times one phi window per face; faces with the
+/// same band (a ring, for a vertex on the beam axis) share one region. The
+/// faces (polar angle and azimuth of every detector, face distance and half
+/// size) are read from DET01DetectorConstruction as built, so the tables
+/// follow /run/reinitializeGeometry and a moved vertex. GetWeight() is the fraction of the full
+/// distribution inside the sampled region, to be stored as the event weight.
+
+class DET01ScatteringSampler
+{
+  public:
+    DET01ScatteringSampler();
+    ~DET01ScatteringSampler();
+
+    // Sample one scattered deuteron: lab angles and kinetic energy
+    void Sample(G4double& theta, G4double& phi, G4double& kineticEnergy);
+
+    // Scattering vertex the acceptance windows are computed from
+    void SetVertex(const G4ThreeVector& vertex);
+
+    // Probability of the sampled region under the full distribution
+    G4double GetWeight();
+
+  private:
+    struct Region {
+      std::vector<G4double> thetaCdf;
+      std::vector<G4double> phiCdf;
+    };
+
+    void DefineCommands();
+    void SetA(G4double value) { fA = value; fDirty = true; }
+    void SetB(G4double value) { fB = value; fDirty = true; }
+    void SetC(G4double value) { fC = value; fDirty = true; }
+    void SetBeamEnergy(G4double value) { fBeamEnergy = value; fDirty = true; }
+    void SetSlope(G4double value) { fSlope = value; fDirty = true; }
+    void SetAcceptance(G4bool value) { fAcceptance = value; fDirty = true; }
+
+    void FollowGeometry();
+    void Build();
+    G4double ScatteredMomentum(G4double theta) const;   // < 0: not allowed
+    static void MakeCdf(std::vector<G4double>& pdf);
+    static G4double SampleCdf(const std::vector<G4double>& cdf,
+                              G4double lo, G4double width, G4double u);
+
+    G4GenericMessenger* fMessenger;
+
+    // Physics parameters
+    G4double fA, fB, fC;
+    G4double fBeamEnergy;        // deuteron kinetic energy
+    G4double fSlope;             // (GeV/c)^-2
+
+    // Acceptance, copied from the detector construction
+    G4bool fAcceptance;
+    std::vector<G4int> fDetectorRing;
+    std::vector<G4double> fDetectorTheta, fDetectorPhi;
+    G4double fDistance;
+    G4double fHalfSize;
+    G4ThreeVector fVertex;
+
+    // Tables
+    G4bool fDirty;
+    G4double fThetaMax;
+    std::vector<Region> fRegions;
+    std::vector<G4double> fRegionCdf;
+    G4double fWeight;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef DET01ScintSD_h
+#define DET01ScintSD_h 1
+
+#include "G4VSensitiveDetector.hh"
+#include "DET01Hit.hh"
+
+#include <vector>
+
+class G4Step;
+class G4HCofThisEvent;
+class DET01EnergyResponse;
+class DET01OpticalDepositModel;
+
+/// Scintillator sensitive detector.
+///
+/// The hits collection holds exactly one DET01Hit per scintillator, created
+/// in Initialize() and indexed by copy number: summed energy deposit, first
+/// deposit time (DET01Hit time) and the primary's entry/exit positions.
+///
+/// In the energy-only optics mode the SD owns a DET01EnergyResponse and also
+/// sums the Birks-quenched (visible) energy per scintillator. In the fast
+/// optics mode it owns a DET01OpticalDepositModel and hands it every step
+/// with a deposit.
+
+class DET01ScintSD : public G4VSensitiveDetector
+{
+  public:
+    DET01ScintSD(const G4String& name,
+                 const G4String& hitsCollectionName,
+                 G4int nDetectors);
+    virtual ~DET01ScintSD();
+
+    // methods from base class
+    virtual void   Initialize(G4HCofThisEvent* hitCollection);
+    virtual G4bool ProcessHits(G4Step* step, G4TouchableHistory* history);
+    virtual void   EndOfEvent(G4HCofThisEvent* hitCollection);
+
+    G4int GetNDetectors() const { return fNDetectors; }
+    void SetNDetectors(G4int nDetectors) { fNDetectors = nDetectors; }
+
+    // Energy-only optics mode (takes ownership)
+    void SetEnergyResponse(DET01EnergyResponse* response);
+    const DET01EnergyResponse* GetEnergyResponse() const { return fResponse; }
+    G4double GetVisibleEnergy(G4int detID) const { return fVisible[detID]; }
+
+    // Fast optics mode (takes ownership, nullptr: off)
+    void SetOpticalModel(DET01OpticalDepositModel* model);
+
+  private:
+    DET01HitsCollection* fHitsCollection;
+    G4int fNDetectors;
+    DET01EnergyResponse* fResponse;
+    DET01OpticalDepositModel* fOpticalModel;
+    std::vector<G4double> fVisible;   // [det] quenched energy, response mode only
+};
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef DET01SensitiveDetector_h
+#define DET01SensitiveDetector_h 1
+
+#include "G4VSensitiveDetector.hh"
+#include "DET01Hit.hh"
+#include "DET01PmtHit.hh"
+
+#include <vector>
+
+class G4Step;
+class G4HCofThisEvent;
+class DET01OpticalResponseMap;
+
+/// Photocathode sensitive detector.
+///
+/// Every optical photon reaching a photocathode is counted as one
+/// photoelectron and killed. DET01OpticalDepositModel (fast optics, and the
+/// untracked share of the reduced-yield mode) feeds the photoelectrons it
+/// samples from the deposits in through AddPhotoelectron().
+///
+/// Storage modes:
+///  - accumulate (default): one DET01PmtHit per PMT (PE count, first time,
+///    optional arrival-time histogram and, with SetKeepTimes(), every
+///    photoelectron time), collection size = nDetectors
+///  - per photon: one DET01Hit per photoelectron
+///
+/// At end of event the PE counts go into DET01PmtCounters; the per-event
+/// console summary is only printed with verbose level > 0.
+
+class DET01SensitiveDetector : public G4VSensitiveDetector
+{
+  public:
+    DET01SensitiveDetector(const G4String& name,
+                           const G4String& hitsCollectionName,
+                           G4int nDetectors);
+    virtual ~DET01SensitiveDetector();
+
+    // methods from base class
+    virtual void   Initialize(G4HCofThisEvent* hitCollection);
+    virtual G4bool ProcessHits(G4Step* step, G4TouchableHistory* history);
+    virtual void   EndOfEvent(G4HCofThisEvent* hitCollection);
+
+    // Photoelectron produced outside ProcessHits (fast optics)
+    void AddPhotoelectron(G4int detID, G4double time);
+
+    // Layout size, reset when the geometry is rebuilt
+    void SetNDetectors(G4int nDetectors) { fNDetectors = nDetectors; }
+
+    // Storage mode, set before the first event
+    void SetAccumulate(G4bool accumulate) { fAccumulate = accumulate; }
+    G4bool GetAccumulate() const { return fAccumulate; }
+    void SetTimeBinning(G4int nBins, G4double binWidth);
+
+    // Accumulate mode: keep every photoelectron time in the records (set by
+    // the run action for the digitizer and the photon-time sidecar)
+    void SetKeepTimes(G4bool keep) { fKeepTimes = keep; }
+
+    // Response-map building: detected photons are recorded into this map
+    void SetResponseMapBuilder(DET01OpticalResponseMap* map) { fMapBuilder = map; }
+
+  private:
+    DET01HitsCollection* fHitsCollection;        // per-photon mode
+    DET01PmtHitsCollection* fPmtHitsCollection;  // accumulate mode
+    G4int fNDetectors;
+    G4bool fAccumulate;
+    G4int fTimeBins;
+    G4double fTimeBinWidth;
+    G4bool fKeepTimes;
+    DET01OpticalResponseMap* fMapBuilder;
+    std::vector<G4int> fEventCounts;
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef DET01StackingAction_h
+#define DET01StackingAction_h 1
+
+#include "G4UserStackingAction.hh"
+#include "DET01Hit.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class G4GenericMessenger;
+class DET01RunAction;
+
+/// Stacking action: optional deferral of optical photons behind the trigger.
+///
+/// With /det01/stack/deferOptical true, optical photons are pushed to the
+/// waiting stack until all other tracks of the event are done. The
+/// scintillator deposits collected so far by DET01ScintSD are then passed to
+/// the run action's DET01Trigger: accepted events get their photons tracked,
+/// rejected events have the whole optical stack dropped.
+///
+/// Isolated optics (/det01/physics/isolateOptics): photons always wait for
+/// the end of the charged stage, so the charged stage does not depend on
+/// them.
+
+class DET01StackingAction : public G4UserStackingAction
+{
+  public:
+    DET01StackingAction(DET01RunAction* runAction);
+    virtual ~DET01StackingAction();
+
+    virtual G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track* track);
+    virtual void NewStage();
+    virtual void PrepareNewEvent();
+
+  private:
+    void DefineCommands();
+
+    DET01RunAction* fRunAction;
+    G4GenericMessenger* fMessenger;
+    G4bool fDeferOptical;
+
+    G4bool fReleased;   // trigger decided, photons are tracked directly
+    G4bool fIsolated;   // DET01IsolatedOptics wrappers on this thread
+    G4int fScintHCID;
+    std::vector<G4double> fEdep;
+};
+
+#endif
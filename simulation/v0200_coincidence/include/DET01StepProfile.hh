@@ -0,0 +1,64 @@
+#ifndef DET01StepProfile_h
+#define DET01StepProfile_h 1
+
+#include "G4VAccumulable.hh"
+#include "globals.hh"
+
+#include <map>
+#include <string>
+#include <tuple>
+
+class G4LogicalVolume;
+class G4ParticleDefinition;
+class G4VProcess;
+class G4GenericMessenger;
+
+/// Step-level CPU attribution (/det01/profile/).
+///
+/// Each thread fills its own instance (GetInstance()) from
+/// DET01SteppingAction: step count, wall and thread CPU time per
+/// (logical volume x particle x step-defining process) bucket. Buckets are
+/// keyed by pointer while filling and by name after merging, since process
+/// objects are thread-local. The master prints the merged buckets sorted by
+/// CPU time at end of run and optionally writes them as CSV.
+
+class DET01StepProfile : public G4VAccumulable
+{
+  public:
+    DET01StepProfile(const G4String& name = "StepProfile");
+    virtual ~DET01StepProfile();
+
+    static DET01StepProfile* GetInstance();
+
+    virtual void Merge(const G4VAccumulable& other);
+    virtual void Reset();
+
+    G4bool IsEnabled() const { return fEnabled; }
+
+    void Fill(const G4LogicalVolume* volume, const G4ParticleDefinition* particle,
+              const G4VProcess* process, G4double wallTime, G4double cpuTime);
+
+    void Print() const;
+
+  private:
+    struct Bucket {
+      G4long steps = 0;
+      G4double wall = 0.;
+      G4double cpu = 0.;
+    };
+    using Key = std::tuple<const G4LogicalVolume*, const G4ParticleDefinition*, const G4VProcess*>;
+    using NameKey = std::tuple<std::string, std::string, std::string>;
+
+    static NameKey Names(const Key& key);
+    std::map<NameKey, Bucket> Merged() const;
+
+    G4GenericMessenger* fMessenger;
+    G4bool fEnabled;
+    G4int fTop;
+    G4String fFileName;
+
+    std::map<Key, Bucket> fBuckets;          // filled by this thread
+    std::map<NameKey, Bucket> fNamedBuckets; // merged from other threads
+};
+
+#endif
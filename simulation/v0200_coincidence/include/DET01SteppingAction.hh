@@ -0,0 +1,31 @@
+#ifndef DET01SteppingAction_h
+#define DET01SteppingAction_h 1
+
+#include "G4UserSteppingAction.hh"
+#include "globals.hh"
+
+class DET01StepProfile;
+
+/// Stepping action: optional step profiling (/det01/profile/enable).
+///
+/// The wall and thread CPU time elapsed since the previous step of the same
+/// event is attributed to the current step's (pre-step logical volume x
+/// particle x step-defining process) bucket of DET01StepProfile. Does
+/// nothing while profiling is off.
+
+class DET01SteppingAction : public G4UserSteppingAction
+{
+  public:
+    DET01SteppingAction();
+    virtual ~DET01SteppingAction();
+
+    virtual void UserSteppingAction(const G4Step* step);
+
+  private:
+    DET01StepProfile* fProfile;
+    G4int fEventID;
+    G4double fLastWall;
+    G4double fLastCpu;
+};
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef DET01Telemetry_h
+#define DET01Telemetry_h 1
+
+#include "globals.hh"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class G4Run;
+class G4GenericMessenger;
+
+/// Live run telemetry (/det01/telemetry/, master only).
+///
+/// With /det01/telemetry/enable true a background thread of the master
+/// samples the run every /det01/telemetry/interval and appends one JSON
+/// object per line to /det01/telemetry/file (default
+/// <output name>_telemetry.jsonl), optionally echoed to the console:
+///   run, time (Unix s), elapsed_s, events / total, events_per_s, eta_s,
+///   accepted, acceptance, photons, photons_per_s, rss_bytes, output_bytes
+///   (the files this run writes: <output name>.root, _t<i>.root,
+///   _photons.bin, _photons_t<i>.bin) and, per event-processing thread
+///   that began the run (also before its first event), events,
+///   events_per_s and idle_s (time since its last event, or since the
+///   start without any, to spot stalls).
+/// The last line of a run has "final": true. Lines of consecutive runs
+/// (e.g. checkpoint sub-runs) go to the same file.
+///
+/// The event threads only bump relaxed atomic counters in their own
+/// cache line (CountEvent() from DET01EventAction, CountPhoton() from
+/// DET01StackingAction), so the overhead is a few ns per event and photon.
+/// They announce themselves with RegisterThread() from
+/// DET01RunAction::BeginOfRunAction, after the master's Start().
+
+class DET01Telemetry
+{
+  public:
+    DET01Telemetry();
+    ~DET01Telemetry();
+
+    // Master: around the run; the output file name sets the defaults
+    void Start(const G4Run* run, const G4String& outputFile);
+    void Stop();
+
+    // Event threads
+    static void RegisterThread();
+    static void CountEvent(G4bool accepted);
+    static void CountPhoton()
+    {
+      if (fActive.load(std::memory_order_relaxed)) Slot().photons.fetch_add(1, std::memory_order_relaxed);
+    }
+
+  private:
+    struct alignas(64) Counters {
+      std::atomic<G4long> events{0};
+      std::atomic<G4long> accepted{0};
+      std::atomic<G4long> photons{0};
+      std::atomic<G4bool> started{false};
+    };
+    static const G4int kMaxSlots = 257;   // master/sequential + 256 workers
+
+    // Slot of the calling thread (master and sequential: slot 0)
+    static Counters& Slot();
+
+    void DefineCommands();
+    void Loop();
+    void Sample(G4bool final);
+    G4long OutputBytes() const;
+    static G4long ResidentBytes();
+
+    G4GenericMessenger* fMessenger;
+    G4bool fEnabled;
+    G4bool fConsole;
+    G4double fInterval;
+    G4String fFileName;
+
+    // Run being sampled
+    G4int fRunID;
+    G4long fTotalEvents;
+    G4String fOutputStem;
+    G4String fTelemetryFile;
+    std::ofstream fOut;
+    std::chrono::steady_clock::time_point fStartTime, fLastTime;
+    std::vector<G4long> fLastEvents;
+    std::vector<G4double> fIdle;
+    G4long fLastPhotons;
+
+    std::thread fReporter;
+    std::mutex fMutex;
+    std::condition_variable fWake;
+    G4bool fStop;
+
+    static std::atomic<G4bool> fActive;
+    static Counters fSlots[kMaxSlots];
+};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef DET01Trigger_h
+#define DET01Trigger_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+class G4GenericMessenger;
+
+/// Software trigger evaluated on the scintillator energy deposits before an
+/// event is written to the ntuple.
+///
+/// A detector fires when its deposit exceeds its threshold (global
+/// /det01/trigger/threshold or per-detector /det01/trigger/detThreshold).
+/// An event is accepted when
+///  - at least `multiplicity` fired detectors belong to the selected rings
+///    (ring of the copyNo in the ring layout,
+///    DET01DetectorConstruction::GetDetectorRings(); all detectors if none
+///    selected or in the stack layout), and
+///  - if coincidence patterns are defined, all detectors of at least one
+///    pattern fired.
+/// The trigger is off (every event accepted) until /det01/trigger/enable true.
+///
+/// Example, 10 MeV pair coincidence (two fired detectors) in ring 0:
+///   /det01/trigger/enable true
+///   /det01/trigger/threshold 10 MeV
+///   /det01/trigger/multiplicity 2
+///   /det01/trigger/rings 0
+
+class DET01Trigger
+{
+  public:
+    DET01Trigger();
+    ~DET01Trigger();
+
+    G4bool IsEnabled() const { return fEnabled; }
+    G4bool Accept(const std::vector<G4double>& edep) const;
+
+    G4double GetThreshold(G4int det) const;
+    // Detector above its threshold
+    G4bool Fired(const std::vector<G4double>& edep, G4int det) const;
+
+  private:
+    void DefineCommands();
+    void SetDetThreshold(const G4String& value);
+    void AddPattern(const G4String& value);
+    void ClearPatterns();
+    void SetRings(const G4String& value);
+
+    G4GenericMessenger* fMessenger;
+
+    G4bool fEnabled;
+    G4double fThreshold;
+    std::vector<G4double> fDetThresholds;        // < 0: use global threshold
+    G4int fMultiplicity;
+    std::vector<std::vector<G4int>> fPatterns;
+    std::vector<G4int> fRings;
+};
+
+#endif
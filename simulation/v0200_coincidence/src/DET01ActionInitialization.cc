@@ -2,6 +2,8 @@
 #include "DET01PrimaryGeneratorAction.hh"
 #include "DET01RunAction.hh"
 #include "DET01EventAction.hh"
+#include "DET01StackingAction.hh"
+#include "DET01SteppingAction.hh"
 
 DET01ActionInitialization::DET01ActionInitialization()
  : G4VUserActionInitialization()
@@ -10,14 +12,20 @@ DET01ActionInitialization::DET01ActionInitialization()
 DET01ActionInitialization::~DET01ActionInitialization()
 {}
 
+// Master: run action only (ntuple merging, accumulables, run summary)
 void DET01ActionInitialization::BuildForMaster() const
 {
   SetUserAction(new DET01RunAction());
 }
 
+// Workers (or the sequential run manager): every thread gets its own
+// GPS instance, run/event/stacking/stepping actions and, via ConstructSDandField, its own SDs
 void DET01ActionInitialization::Build() const
 {
-  SetUserAction(new DET01PrimaryGeneratorAction());
-  SetUserAction(new DET01RunAction());
-  SetUserAction(new DET01EventAction());
+  DET01RunAction* runAction = new DET01RunAction();
+  SetUserAction(runAction);
+  SetUserAction(new DET01PrimaryGeneratorAction(runAction));
+  SetUserAction(new DET01EventAction(runAction));
+  SetUserAction(new DET01StackingAction(runAction));
+  SetUserAction(new DET01SteppingAction());
 }
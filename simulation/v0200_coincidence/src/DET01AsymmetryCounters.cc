@@ -0,0 +1,237 @@
+#include "DET01AsymmetryCounters.hh"
+#include "DET01DetectorConstruction.hh"
+#include "DET01Trigger.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+DET01AsymmetryCounters* DET01AsymmetryCounters::GetInstance()
+{
+  static G4ThreadLocal DET01AsymmetryCounters* instance = nullptr;
+  if (!instance) instance = new DET01AsymmetryCounters();
+  return instance;
+}
+
+DET01AsymmetryCounters::DET01AsymmetryCounters(const G4String& name)
+ : G4VAccumulable(name),
+   fMessenger(nullptr),
+   fEnabled(false),
+   fNEvents(0),
+   fSumWeight(0.)
+{
+  fMessenger = new G4GenericMessenger(this, "/det01/asymmetry/", "Online azimuthal asymmetry");
+
+  fMessenger->DeclareProperty("enable", fEnabled,
+      "Count fired detectors of accepted events and fit A + B cos(phi) + C cos(2 phi) per ring.");
+
+  fMessenger->DeclareProperty("file", fFileName,
+      "Summary file (empty: <output name>_asymmetry.txt).");
+}
+
+DET01AsymmetryCounters::~DET01AsymmetryCounters()
+{
+  delete fMessenger;
+}
+
+void DET01AsymmetryCounters::Resize(size_t nDetectors)
+{
+  if (fCounts.size() >= nDetectors) return;
+  fCounts.resize(nDetectors, 0);
+  fSumW.resize(nDetectors, 0.);
+  fSumW2.resize(nDetectors, 0.);
+}
+
+void DET01AsymmetryCounters::Fill(const std::vector<G4double>& edep, const DET01Trigger* trigger,
+                                  G4double weight)
+{
+  Resize(edep.size());
+  for (size_t i=0; i<edep.size(); i++) {
+      if (!trigger->Fired(edep, i)) continue;
+      fCounts[i]++;
+      fSumW[i] += weight;
+      fSumW2[i] += weight * weight;
+  }
+  fNEvents++;
+  fSumWeight += weight;
+}
+
+void DET01AsymmetryCounters::Merge(const G4VAccumulable& other)
+{
+  const DET01AsymmetryCounters& right = static_cast<const DET01AsymmetryCounters&>(other);
+  Resize(right.fCounts.size());
+
+  for (size_t i=0; i<right.fCounts.size(); i++) {
+      fCounts[i] += right.fCounts[i];
+      fSumW[i] += right.fSumW[i];
+      fSumW2[i] += right.fSumW2[i];
+  }
+  fNEvents += right.fNEvents;
+  fSumWeight += right.fSumWeight;
+}
+
+void DET01AsymmetryCounters::Reset()
+{
+  fNEvents = 0;
+  fSumWeight = 0.;
+  std::fill(fCounts.begin(), fCounts.end(), 0);
+  std::fill(fSumW.begin(), fSumW.end(), 0.);
+  std::fill(fSumW2.begin(), fSumW2.end(), 0.);
+}
+
+DET01AsymmetryCounters::Fit DET01AsymmetryCounters::FitRing(const std::vector<G4int>& copies,
+                                                            const std::vector<G4double>& phi) const
+{
+  // Variance of an empty detector: one event of the mean weight
+  const G4double meanWeight = (fNEvents > 0) ? fSumWeight / fNEvents : 1.;
+
+  Fit fit;
+  fit.nPoints = copies.size();
+  G4double m[3][3] = {{0.}}, v[3] = { 0., 0., 0. };
+  for (auto copyNo : copies) {
+      G4double x[3] = { 1., std::cos(phi[copyNo]), std::cos(2. * phi[copyNo]) };
+      G4double y = (copyNo < (G4int)fSumW.size()) ? fSumW[copyNo] : 0.;
+      G4double var = (copyNo < (G4int)fSumW2.size() && fSumW2[copyNo] > 0.) ? fSumW2[copyNo]
+                                                                            : meanWeight * meanWeight;
+      for (G4int a=0; a<3; a++) {
+          v[a] += x[a] * y / var;
+          for (G4int b=0; b<3; b++) m[a][b] += x[a] * x[b] / var;
+      }
+  }
+
+  // Covariance = M^-1 (adjugate / determinant)
+  G4double det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+               - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+               + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+  G4double scale = std::max({ std::fabs(m[0][0]), std::fabs(m[1][1]), std::fabs(m[2][2]) });
+  if (fit.nPoints < 3 || std::fabs(det) <= 1.e-12 * scale * scale * scale) return fit;
+
+  for (G4int a=0; a<3; a++) {
+      for (G4int b=0; b<3; b++) {
+          G4int a1 = (b + 1) % 3, a2 = (b + 2) % 3;
+          G4int b1 = (a + 1) % 3, b2 = (a + 2) % 3;
+          fit.cov[a][b] = (m[a1][b1] * m[a2][b2] - m[a1][b2] * m[a2][b1]) / det;
+      }
+  }
+  for (G4int a=0; a<3; a++) {
+      for (G4int b=0; b<3; b++) fit.par[a] += fit.cov[a][b] * v[b];
+  }
+
+  for (auto copyNo : copies) {
+      G4double f = fit.par[0] + fit.par[1] * std::cos(phi[copyNo]) + fit.par[2] * std::cos(2. * phi[copyNo]);
+      G4double y = (copyNo < (G4int)fSumW.size()) ? fSumW[copyNo] : 0.;
+      G4double var = (copyNo < (G4int)fSumW2.size() && fSumW2[copyNo] > 0.) ? fSumW2[copyNo]
+                                                                            : meanWeight * meanWeight;
+      fit.chi2 += (y - f) * (y - f) / var;
+  }
+  fit.valid = true;
+  return fit;
+}
+
+void DET01AsymmetryCounters::Report(const DET01DetectorConstruction* detector,
+                                    const G4String& outputName) const
+{
+  if (!fEnabled || fNEvents == 0) return;
+
+  const std::vector<G4int>& rings = detector->GetDetectorRings();
+  const std::vector<G4double>& phi = detector->GetDetectorPhi();
+  if (rings.empty()) {
+      G4Exception("DET01AsymmetryCounters::Report()", "DET01_701", JustWarning,
+                  "Azimuthal asymmetry needs the ring layout (/det01/geometry/layout rings).");
+      return;
+  }
+
+  std::ostringstream out;
+  out << "# DET01 azimuthal asymmetry: Y(phi) = A + B cos(phi) + C cos(2 phi)" << "\n"
+      << "# accepted events " << fNEvents << ", summed weight " << std::setprecision(10) << fSumWeight << "\n"
+      << "# copyNo ring phi_deg counts yield yield_err" << "\n";
+  for (size_t copyNo=0; copyNo<rings.size(); copyNo++) {
+      G4long n = (copyNo < fCounts.size()) ? fCounts[copyNo] : 0;
+      G4double y = (copyNo < fSumW.size()) ? fSumW[copyNo] : 0.;
+      G4double e = (copyNo < fSumW2.size()) ? std::sqrt(fSumW2[copyNo]) : 0.;
+      out << copyNo << " " << rings[copyNo] << " " << std::setprecision(6) << phi[copyNo] / deg
+          << " " << n << " " << std::setprecision(10) << y << " " << e << "\n";
+  }
+
+  out << "# ring n A A_err B B_err C C_err B/A B/A_err C/A C/A_err chi2/ndf" << "\n";
+  G4int nRings = *std::max_element(rings.begin(), rings.end()) + 1;
+  for (G4int r=0; r<nRings; r++) {
+      std::vector<G4int> copies;
+      for (size_t copyNo=0; copyNo<rings.size(); copyNo++) {
+          if (rings[copyNo] == r) copies.push_back(copyNo);
+      }
+      Fit fit = FitRing(copies, phi);
+      out << r << " " << fit.nPoints;
+      if (!fit.valid) {
+          out << " nan nan nan nan nan nan nan nan nan nan nan" << "\n";
+          continue;
+      }
+
+      // Ratios to A, errors propagated with the full covariance
+      const G4double a = fit.par[0];
+      G4double ratio[2], ratioErr[2];
+      for (G4int k=1; k<=2; k++) {
+          ratio[k-1] = fit.par[k] / a;
+          G4double gA = -fit.par[k] / (a * a), gK = 1. / a;
+          ratioErr[k-1] = std::sqrt(std::max(0., gA * gA * fit.cov[0][0] + gK * gK * fit.cov[k][k]
+                                                 + 2. * gA * gK * fit.cov[0][k]));
+      }
+      G4int ndf = fit.nPoints - 3;
+      out << std::setprecision(8);
+      for (G4int k=0; k<3; k++) out << " " << fit.par[k] << " " << std::sqrt(std::max(0., fit.cov[k][k]));
+      out << " " << ratio[0] << " " << ratioErr[0] << " " << ratio[1] << " " << ratioErr[1]
+          << " " << ((ndf > 0) ? fit.chi2 / ndf : 0.) << "\n";
+  }
+
+  G4cout << G4endl
+         << "----------------- Azimuthal Asymmetry -----------------" << G4endl
+         << out.str()
+         << "-------------------------------------------------------" << G4endl;
+
+  G4String fileName = fFileName;
+  if (fileName.empty()) {
+      fileName = outputName;
+      if (G4StrUtil::ends_with(fileName, ".root")) fileName.erase(fileName.size() - 5);
+      fileName += "_asymmetry.txt";
+  }
+  std::ofstream file(fileName);
+  file << out.str();
+  G4cout << " Asymmetry summary written to " << fileName << G4endl;
+}
+
+#ifdef DET01_USE_MPI
+void DET01AsymmetryCounters::ReduceOverRanks(MPI_Comm comm)
+{
+  // Ranks without events may not have sized their vectors yet
+  G4long nDetectors = fCounts.size(), maxDetectors = 0;
+  MPI_Allreduce(&nDetectors, &maxDetectors, 1, MPI_LONG, MPI_MAX, comm);
+  Resize(maxDetectors);
+
+  G4int rank = 0;
+  MPI_Comm_rank(comm, &rank);
+  const G4int n = maxDetectors;
+
+  G4long nEvents = 0;
+  G4double sumWeight = 0.;
+  std::vector<G4long> countSum(n, 0);
+  std::vector<G4double> sumW(n, 0.), sumW2(n, 0.);
+  MPI_Reduce(&fNEvents, &nEvents, 1, MPI_LONG, MPI_SUM, 0, comm);
+  MPI_Reduce(&fSumWeight, &sumWeight, 1, MPI_DOUBLE, MPI_SUM, 0, comm);
+  MPI_Reduce(fCounts.data(), countSum.data(), n, MPI_LONG, MPI_SUM, 0, comm);
+  MPI_Reduce(fSumW.data(), sumW.data(), n, MPI_DOUBLE, MPI_SUM, 0, comm);
+  MPI_Reduce(fSumW2.data(), sumW2.data(), n, MPI_DOUBLE, MPI_SUM, 0, comm);
+
+  if (rank != 0) return;
+  fNEvents = nEvents;
+  fSumWeight = sumWeight;
+  fCounts.swap(countSum);
+  fSumW.swap(sumW);
+  fSumW2.swap(sumW2);
+}
+#endif
@@ -0,0 +1,167 @@
+#include "DET01BiasingOperator.hh"
+
+#include "G4BiasingProcessInterface.hh"
+#include "G4BiasingProcessSharedData.hh"
+#include "G4BOptnChangeCrossSection.hh"
+#include "G4ParticleTable.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4ProcessManager.hh"
+#include "G4VProcess.hh"
+#include "G4Track.hh"
+#include "G4Exception.hh"
+
+#include <cfloat>
+#include <cmath>
+
+namespace {
+  G4ThreadLocal DET01BiasingOperator* gInstance = nullptr;
+}
+
+DET01BiasingOperator* DET01BiasingOperator::GetInstance()
+{
+  return gInstance;
+}
+
+DET01BiasingOperator::DET01BiasingOperator(const G4String& particleName,
+                                           const G4String& processName,
+                                           G4bool force, G4double factor,
+                                           G4double probability, G4double thickness)
+ : G4VBiasingOperator("DET01TargetBiasing"),
+   fParticleName(particleName),
+   fProcessName(processName),
+   fParticle(nullptr),
+   fForce(force),
+   fFactor(factor),
+   fProbability(probability),
+   fThickness(thickness),
+   fPrimary(nullptr),
+   fInteracted(false),
+   fEventWeight(1.)
+{
+  gInstance = this;
+}
+
+DET01BiasingOperator::~DET01BiasingOperator()
+{
+  for (auto& op : fOperations) delete op.second;
+  if (gInstance == this) gInstance = nullptr;
+}
+
+void DET01BiasingOperator::StartRun()
+{
+  // One cross-section change operation per wrapped physics process
+  if (!fOperations.empty()) return;
+
+  fParticle = G4ParticleTable::GetParticleTable()->FindParticle(fParticleName);
+  if (!fParticle) {
+      G4Exception("DET01BiasingOperator::StartRun()", "DET01_201", JustWarning,
+                  ("Unknown particle " + fParticleName + ", biasing disabled.").c_str());
+      return;
+  }
+
+  const G4BiasingProcessSharedData* sharedData =
+      G4BiasingProcessInterface::GetSharedData(fParticle->GetProcessManager());
+  if (!sharedData) {
+      G4Exception("DET01BiasingOperator::StartRun()", "DET01_202", JustWarning,
+                  ("No biasing wrappers for " + fParticleName
+                   + " (G4GenericBiasingPhysics missing), biasing disabled.").c_str());
+      return;
+  }
+
+  // "all" = the wrapped hadronic processes only: biasing hIoni would end the
+  // biasing at the first delta ray
+  for (const auto* wrapper : sharedData->GetPhysicsBiasingProcessInterfaces()) {
+      const G4VProcess* process = wrapper->GetWrappedProcess();
+      const G4String& name = process->GetProcessName();
+      if (fProcessName == "all") {
+          if (process->GetProcessType() != fHadronic) continue;
+      }
+      else if (name != fProcessName) continue;
+      fOperations[wrapper] = new G4BOptnChangeCrossSection("XSchange-" + name);
+  }
+  if (fOperations.empty()) {
+      G4Exception("DET01BiasingOperator::StartRun()", "DET01_203", JustWarning,
+                  ("No process " + fProcessName + " for " + fParticleName + ", biasing disabled.").c_str());
+  }
+}
+
+void DET01BiasingOperator::StartTracking(const G4Track* track)
+{
+  // New event: the primary has not interacted yet
+  if (track->GetTrackID() == 1) {
+      fPrimary = track;
+      fInteracted = false;
+      fEventWeight = 1.;
+  }
+}
+
+void DET01BiasingOperator::EndTracking()
+{
+  // Primary done without interaction: its weight now includes the
+  // non-interaction correction of its last biased step too
+  if (fPrimary && !fInteracted) fEventWeight = fPrimary->GetWeight();
+  fPrimary = nullptr;
+}
+
+G4double DET01BiasingOperator::BiasedCrossSection(G4double analogXS) const
+{
+  if (!fForce) return fFactor * analogXS;
+  if (fThickness <= 0. || fProbability <= 0.) return analogXS;
+
+  // The forced cross section is shared among the biased processes so that
+  // their combined interaction probability over L is (at least) P
+  G4double p = std::min(fProbability, 1. - 1e-9);
+  G4double forcedXS = -std::log(1. - p) / fThickness / fOperations.size();
+  return std::max(analogXS, forcedXS);
+}
+
+G4VBiasingOperation* DET01BiasingOperator::ProposeOccurenceBiasingOperation(
+    const G4Track* track, const G4BiasingProcessInterface* callingProcess)
+{
+  // Only the primary, only until its first interaction
+  if (track->GetParentID() != 0 || track->GetDefinition() != fParticle) return nullptr;
+  if (fInteracted) return nullptr;
+
+  auto it = fOperations.find(callingProcess);
+  if (it == fOperations.end()) return nullptr;
+  G4BOptnChangeCrossSection* operation = it->second;
+
+  G4double analogLength = callingProcess->GetWrappedProcess()->GetCurrentInteractionLength();
+  if (analogLength > DBL_MAX/10.) return nullptr;
+  G4double biasedXS = BiasedCrossSection(1. / analogLength);
+
+  // Same bookkeeping as G4BOptrChangeCrossSection: sample a new interaction
+  // point after an interaction, otherwise update the running one
+  G4VBiasingOperation* previous = callingProcess->GetPreviousOccurenceBiasingOperation();
+  if (previous == nullptr || operation->GetInteractionOccured()) {
+      operation->SetBiasedCrossSection(biasedXS);
+      operation->Sample();
+  }
+  else {
+      operation->UpdateForStep(callingProcess->GetPreviousStepSize());
+      operation->SetBiasedCrossSection(biasedXS);
+      operation->UpdateForStep(0.);
+  }
+
+  return operation;
+}
+
+void DET01BiasingOperator::OperationApplied(const G4BiasingProcessInterface* callingProcess,
+                                            G4BiasingAppliedCase,
+                                            G4VBiasingOperation* occurenceOperationApplied,
+                                            G4double weightForOccurenceInteraction,
+                                            G4VBiasingOperation*,
+                                            const G4VParticleChange*)
+{
+  auto it = fOperations.find(callingProcess);
+  if (it == fOperations.end() || it->second != occurenceOperationApplied) return;
+
+  it->second->SetInteractionOccured();
+
+  // The primary interacted: its products carry this weight
+  const G4Track* track = callingProcess->GetCurrentTrack();
+  if (track && track->GetParentID() == 0) {
+      fInteracted = true;
+      fEventWeight = track->GetWeight() * weightForOccurenceInteraction;
+  }
+}
@@ -0,0 +1,165 @@
+#include "DET01Checkpoint.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4RunManager.hh"
+#include "G4UImanager.hh"
+#include "G4AnalysisManager.hh"
+#include "G4Exception.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+G4int DET01Checkpoint::fEventOffset = 0;
+
+DET01Checkpoint::DET01Checkpoint()
+ : fMessenger(nullptr),
+   fFileName("DET01_Checkpoint"),
+   fEventsPerPart(100000),
+   fTotalEvents(0),
+   fPartsDone(0)
+{
+  DefineCommands();
+}
+
+DET01Checkpoint::~DET01Checkpoint()
+{
+  delete fMessenger;
+}
+
+void DET01Checkpoint::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/det01/checkpoint/", "Checkpointed runs");
+
+  auto& fileCmd = fMessenger->DeclareProperty("file", fFileName,
+      "Checkpoint file name (without extension).");
+  fileCmd.SetToBeBroadcasted(false);
+
+  auto& everyCmd = fMessenger->DeclareProperty("every", fEventsPerPart,
+      "Events per sub-run (checkpoint interval).");
+  everyCmd.SetToBeBroadcasted(false);
+
+  auto& beamOnCmd = fMessenger->DeclareMethod("beamOn", &DET01Checkpoint::BeamOn,
+      "Run N events as checkpointed sub-runs.");
+  beamOnCmd.SetStates(G4State_Idle);
+  beamOnCmd.SetToBeBroadcasted(false);
+
+  auto& resumeCmd = fMessenger->DeclareMethod("resume", &DET01Checkpoint::Resume,
+      "Continue the run of the checkpoint file from its last checkpoint.");
+  resumeCmd.SetStates(G4State_Idle);
+  resumeCmd.SetToBeBroadcasted(false);
+}
+
+G4String DET01Checkpoint::PartName(G4int part) const
+{
+  std::ostringstream name;
+  name << fOutputName << "_part" << std::setw(4) << std::setfill('0') << part;
+  return name.str();
+}
+
+void DET01Checkpoint::BeamOn(G4int nEvents)
+{
+  if (fEventsPerPart <= 0) {
+      G4Exception("DET01Checkpoint::BeamOn()", "DET01_401", JustWarning,
+                  "/det01/checkpoint/every must be > 0, nothing done.");
+      return;
+  }
+
+  fOutputName = G4AnalysisManager::Instance()->GetFileName();
+  if (fOutputName.empty()) fOutputName = "DET01_Cosmic_Result";
+  if (G4StrUtil::ends_with(fOutputName, ".root")) fOutputName.erase(fOutputName.size() - 5);
+  fTotalEvents = nEvents;
+  fPartsDone = 0;
+
+  // Checkpoint 0: a crash in the first sub-run resumes from the start
+  Save();
+  Run();
+}
+
+void DET01Checkpoint::Resume()
+{
+  if (!Load()) {
+      G4Exception("DET01Checkpoint::Resume()", "DET01_402", JustWarning,
+                  ("No valid checkpoint " + fFileName + ".txt, nothing resumed.").c_str());
+      return;
+  }
+  G4Random::restoreEngineStatus(fEngineFile.c_str());
+  G4cout << " Checkpoint: resuming " << fOutputName << " at event "
+         << fPartsDone * fEventsPerPart << " / " << fTotalEvents << G4endl;
+  Run();
+}
+
+void DET01Checkpoint::Run()
+{
+  G4RunManager* runManager = G4RunManager::GetRunManager();
+  G4UImanager* UImanager = G4UImanager::GetUIpointer();
+  const G4int nParts = (fTotalEvents + fEventsPerPart - 1) / fEventsPerPart;
+
+  while (fPartsDone < nParts) {
+      fEventOffset = fPartsDone * fEventsPerPart;
+      G4int n = std::min(fEventsPerPart, fTotalEvents - fEventOffset);
+
+      // Broadcast, so the workers open the same part
+      UImanager->ApplyCommand("/analysis/setFileName " + PartName(fPartsDone));
+      runManager->BeamOn(n);
+
+      fPartsDone++;
+      Save();
+  }
+  fEventOffset = 0;
+
+  // Parts in concatenation order
+  std::ofstream index(fOutputName + "_parts.txt");
+  for (G4int part=0; part<nParts; part++) index << PartName(part) << ".root\n";
+  UImanager->ApplyCommand("/analysis/setFileName " + fOutputName);
+
+  G4cout << " Checkpoint: " << fTotalEvents << " events in " << nParts
+         << " parts, listed in " << fOutputName << "_parts.txt" << G4endl;
+}
+
+void DET01Checkpoint::Save() const
+{
+  // Engine status per checkpoint, the .txt (renamed into place last)
+  // points to it: a crash while saving leaves the previous checkpoint valid
+  G4String engineName = EngineName(fPartsDone);
+  G4Random::saveEngineStatus(engineName.c_str());
+
+  G4String tmpName = fFileName + ".txt.tmp";
+  {
+      std::ofstream out(tmpName);
+      out << "output " << fOutputName << "\n"
+          << "totalEvents " << fTotalEvents << "\n"
+          << "eventsPerPart " << fEventsPerPart << "\n"
+          << "partsDone " << fPartsDone << "\n"
+          << "eventsDone " << std::min(fPartsDone * fEventsPerPart, fTotalEvents) << "\n"
+          << "engine " << engineName << "\n";
+  }
+  std::rename(tmpName.c_str(), (fFileName + ".txt").c_str());
+  if (fPartsDone > 0) std::remove(EngineName(fPartsDone - 1).c_str());
+}
+
+G4String DET01Checkpoint::EngineName(G4int part) const
+{
+  return fFileName + "_" + std::to_string(part) + ".rndm";
+}
+
+G4bool DET01Checkpoint::Load()
+{
+  std::ifstream in(fFileName + ".txt");
+  if (!in) return false;
+
+  G4String key;
+  G4int found = 0;
+  while (in >> key) {
+      if (key == "output") { in >> fOutputName; found++; }
+      else if (key == "totalEvents") { in >> fTotalEvents; found++; }
+      else if (key == "eventsPerPart") { in >> fEventsPerPart; found++; }
+      else if (key == "partsDone") { in >> fPartsDone; found++; }
+      else if (key == "engine") { in >> fEngineFile; found++; }
+      else in.ignore(1024, '\n');
+  }
+  return found == 5 && fEventsPerPart > 0 && !in.bad();
+}
@@ -0,0 +1,178 @@
+#include "DET01CosmicGenerator.hh"
+#include "DET01DetectorConstruction.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4RunManager.hh"
+#include "G4MuonMinus.hh"
+#include "G4MuonPlus.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Exception.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+  const G4int kCosBins = 500;
+  const G4int kPhiBins = 90;      // one quadrant, the envelope is symmetric
+}
+
+DET01CosmicGenerator::DET01CosmicGenerator()
+ : fMessenger(nullptr),
+   fEMin(1.*GeV), fEMax(100.*GeV),
+   fIndex(2.7),
+   fCosPower(0.),
+   fMaxTheta(80.*deg),
+   fVerticalIntensity(70.),
+   fChargeRatio(1.27),
+   fMargin(1.*cm),
+   fDirty(true),
+   fCosMin(0.),
+   fEnergyA(0.), fEnergyB(0.),
+   fAcceptance(0.)
+{
+  DefineCommands();
+}
+
+DET01CosmicGenerator::~DET01CosmicGenerator()
+{
+  delete fMessenger;
+}
+
+void DET01CosmicGenerator::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/det01/cosmic/", "Cosmic muon generator");
+
+  fMessenger->DeclareMethodWithUnit("eMin", "GeV", &DET01CosmicGenerator::SetEnergyMin,
+      "Minimum muon kinetic energy.");
+  fMessenger->DeclareMethodWithUnit("eMax", "GeV", &DET01CosmicGenerator::SetEnergyMax,
+      "Maximum muon kinetic energy.");
+  fMessenger->DeclareMethod("index", &DET01CosmicGenerator::SetIndex,
+      "Spectral index gamma of E^-gamma.");
+  fMessenger->DeclareMethod("cosPower", &DET01CosmicGenerator::SetCosPower,
+      "Zenith dependence cos^n(theta) of the intensity (0: cos-law plane source, 2: sea level).");
+  fMessenger->DeclareMethodWithUnit("maxTheta", "deg", &DET01CosmicGenerator::SetMaxTheta,
+      "Maximum zenith angle.");
+  fMessenger->DeclareMethodWithUnit("margin", "cm", &DET01CosmicGenerator::SetMargin,
+      "Margin added around the scintillator bounding box.");
+
+  fMessenger->DeclareProperty("verticalIntensity", fVerticalIntensity,
+      "Vertical muon intensity above eMin in m^-2 s^-1 sr^-1 (normalisation only).");
+  fMessenger->DeclareProperty("chargeRatio", fChargeRatio,
+      "mu+/mu- ratio.");
+}
+
+void DET01CosmicGenerator::Build()
+{
+  if (fEMin <= 0. || fEMax <= fEMin || fIndex == 1.) {
+      G4Exception("DET01CosmicGenerator::Build()", "DET01_301", FatalException,
+                  "Invalid muon spectrum (need 0 < eMin < eMax, index != 1).");
+  }
+  if (fMaxTheta <= 0. || fMaxTheta > 90.*deg) {
+      G4Exception("DET01CosmicGenerator::Build()", "DET01_302", FatalException,
+                  "maxTheta must be in (0, 90] deg.");
+  }
+
+  fLo = fGeometryLo - G4ThreeVector(fMargin, fMargin, fMargin);
+  fHi = fGeometryHi + G4ThreeVector(fMargin, fMargin, fMargin);
+  const G4ThreeVector half = 0.5 * (fHi - fLo);
+
+  // Energy: inverse CDF of E^-gamma
+  fEnergyA = std::pow(fEMin, 1. - fIndex);
+  fEnergyB = std::pow(fEMax, 1. - fIndex) - fEnergyA;
+
+  // Direction: cos^n(theta) x projected area
+  //   A_proj = 4 (hy hz |ux| + hx hz |uy| + hx hy |uz|)
+  // integrated analytically over each phi bin
+  fCosMin = std::cos(fMaxTheta);
+  const G4double dCos = (1. - fCosMin) / kCosBins;
+  const G4double dPhi = halfpi / kPhiBins;
+
+  fDirectionCdf.assign(kCosBins * kPhiBins, 0.);
+  G4double sum = 0.;
+  for (G4int i=0; i<kCosBins; i++) {
+      G4double c = fCosMin + (i + 0.5) * dCos;
+      G4double sinTheta = std::sqrt(1. - c*c);
+      G4double w = std::pow(c, fCosPower) * dCos * 4.;
+      for (G4int j=0; j<kPhiBins; j++) {
+          G4double p0 = j * dPhi, p1 = p0 + dPhi;
+          G4double area = half.y() * half.z() * sinTheta * (std::sin(p1) - std::sin(p0))
+                        + half.x() * half.z() * sinTheta * (std::cos(p0) - std::cos(p1))
+                        + half.x() * half.y() * c * dPhi;
+          sum += w * area;
+          fDirectionCdf[i * kPhiBins + j] = sum;
+      }
+  }
+  for (auto& x : fDirectionCdf) x /= sum;
+
+  // Four phi quadrants
+  fAcceptance = 4. * sum;
+  fDirty = false;
+}
+
+G4double DET01CosmicGenerator::GetRate()
+{
+  if (fDirty) Build();
+  G4double energyFraction = 1. - std::pow(fEMax / fEMin, 1. - fIndex);
+  return fVerticalIntensity / (m2 * s) * energyFraction * fAcceptance;
+}
+
+void DET01CosmicGenerator::Sample(G4ParticleDefinition*& particle, G4ThreeVector& position,
+                                  G4ThreeVector& direction, G4double& kineticEnergy)
+{
+  // Follow the geometry (/run/reinitializeGeometry)
+  const auto* detector = static_cast<const DET01DetectorConstruction*>(
+      G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  G4ThreeVector lo, hi;
+  if (!detector || !detector->GetScintillatorEnvelope(lo, hi)) {
+      G4Exception("DET01CosmicGenerator::Sample()", "DET01_303", FatalException,
+                  "No scintillator envelope, geometry not constructed.");
+  }
+  if (lo != fGeometryLo || hi != fGeometryHi) {
+      fGeometryLo = lo;
+      fGeometryHi = hi;
+      fDirty = true;
+  }
+  if (fDirty) Build();
+
+  // Direction (downwards)
+  G4double u = G4UniformRand();
+  size_t cell = std::upper_bound(fDirectionCdf.begin(), fDirectionCdf.end(), u) - fDirectionCdf.begin();
+  cell = std::min(cell, fDirectionCdf.size() - 1);
+  G4int iCos = cell / kPhiBins, iPhi = cell % kPhiBins;
+
+  G4double c = fCosMin + (iCos + G4UniformRand()) * (1. - fCosMin) / kCosBins;
+  G4double phi = (iPhi + G4UniformRand()) * halfpi / kPhiBins;
+  G4int quadrant = std::min(G4int(4. * G4UniformRand()), 3);
+  if (quadrant == 1) phi = pi - phi;
+  else if (quadrant == 2) phi = pi + phi;
+  else if (quadrant == 3) phi = twopi - phi;
+
+  G4double sinTheta = std::sqrt(1. - c*c);
+  direction.set(sinTheta * std::cos(phi), sinTheta * std::sin(phi), -c);
+
+  // Entry point: uniform on the faces seen from the direction, weighted by
+  // their projected area
+  const G4ThreeVector size = fHi - fLo;
+  G4double wx = size.y() * size.z() * std::fabs(direction.x());
+  G4double wy = size.x() * size.z() * std::fabs(direction.y());
+  G4double wz = size.x() * size.y() * std::fabs(direction.z());
+  G4double face = G4UniformRand() * (wx + wy + wz);
+
+  position.set(fLo.x() + G4UniformRand() * size.x(),
+               fLo.y() + G4UniformRand() * size.y(),
+               fLo.z() + G4UniformRand() * size.z());
+  if (face < wx) position.setX(direction.x() > 0. ? fLo.x() : fHi.x());
+  else if (face < wx + wy) position.setY(direction.y() > 0. ? fLo.y() : fHi.y());
+  else position.setZ(fHi.z());
+
+  // Start just outside the envelope
+  position -= 1.*mm * direction;
+
+  // Energy and charge
+  kineticEnergy = std::pow(fEnergyA + G4UniformRand() * fEnergyB, 1. / (1. - fIndex));
+  particle = (G4UniformRand() < fChargeRatio / (1. + fChargeRatio))
+           ? static_cast<G4ParticleDefinition*>(G4MuonPlus::Definition())
+           : static_cast<G4ParticleDefinition*>(G4MuonMinus::Definition());
+}
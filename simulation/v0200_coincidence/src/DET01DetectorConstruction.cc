@@ -6,25 +6,297 @@
 
 #include "G4Box.hh"
 #include "G4Tubs.hh"
+#include "G4Sphere.hh"
 #include "G4LogicalVolume.hh"
 #include "G4PVPlacement.hh"
+#include "G4PVParameterised.hh"
+#include "G4VisAttributes.hh"
 #include "G4SystemOfUnits.hh"
 
 #include "G4OpticalSurface.hh"
 #include "G4LogicalBorderSurface.hh"
 #include "G4LogicalSkinSurface.hh"
 #include "G4LogicalVolumeStore.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
 #include "G4SDManager.hh"
+#include "G4GenericMessenger.hh"
+#include "DET01ModuleParameterisation.hh"
 #include "DET01SensitiveDetector.hh"
 #include "DET01ScintSD.hh"
+#include "DET01OpticalFastSimModel.hh"
+#include "DET01OpticalDepositModel.hh"
+#include "DET01OpticalResponseMap.hh"
+#include "DET01BiasingOperator.hh"
+#include "DET01EnergyResponse.hh"
+#include "DET01PhysicsList.hh"
+#include "G4RunManager.hh"
+#include "G4ProductionCuts.hh"
+#include "G4ProductionCutsTable.hh"
+#include "G4GeometryManager.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4SolidStore.hh"
+#include "G4Transform3D.hh"
+#include "G4Point3D.hh"
+#include "G4FastSimulationManager.hh"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <sstream>
+
+namespace {
+  // Response-map recorder of this thread, replaced at every rebuild
+  G4ThreadLocal DET01OpticalFastSimModel* gOpticalModel = nullptr;
+}
 
 DET01DetectorConstruction::DET01DetectorConstruction()
-: G4VUserDetectorConstruction(), fPhotocathodeLogical(nullptr)
+: G4VUserDetectorConstruction(), fPhotocathodeLogical(nullptr), fNDetectors(4),
+  fMessenger(nullptr), fOpticsMode("full"), fResponseMapFile("DET01_ResponseMap.txt"),
+  fEnergyResponseFile("DET01_EnergyResponse.txt"), fYieldFraction(1.),
+  fPmtMessenger(nullptr), fPmtAccumulate(true), fPmtTimeBins(0), fPmtTimeBinWidth(0.5*ns),
+  fPmtVerbose(0),
+  fTargetMessenger(nullptr), fTargetEnabled(false), fTargetSize(5.*cm), fTargetThickness(1.*cm),
+  fTargetPosition(0., 0., -60.*cm),
+  fBiasMessenger(nullptr), fBiasEnabled(false), fBiasMode("force"), fBiasProcess("hadElastic"),
+  fBiasFactor(10.), fBiasProbability(0.5),
+  fCutsMessenger(nullptr), fTargetCut(-1.), fScintillatorCut(-1.),
+  fScintillatorLogical(nullptr), fTargetLogical(nullptr),
+  fGeometryMessenger(nullptr), fLayout("stack"), fShape("cuboid"),
+  fScinX(120.*mm), fScinY(150.*mm), fScinZ(150.*mm),
+  fCylRadius(25.*mm), fCylLength(200.*mm),
+  fStackCount(4), fStackGap(8.5*mm),
+  fRingAngles({22.5*deg, 30.*deg}), fRingCounts({8}),
+  fRingDistance(150.*cm), fRingPhiOffset(0.),
+  fFaceDistance(0.), fFaceHalfSize(0.),
+  fEnvelopeLo(DBL_MAX, DBL_MAX, DBL_MAX), fEnvelopeHi(-DBL_MAX, -DBL_MAX, -DBL_MAX),
+  fModuleParameterisation(nullptr),
+  fTeflonSurface(nullptr)
 {
+  DefineCommands();
 }
 
 DET01DetectorConstruction::~DET01DetectorConstruction()
 {
+  delete fMessenger;
+  delete fPmtMessenger;
+  delete fTargetMessenger;
+  delete fBiasMessenger;
+  delete fCutsMessenger;
+  delete fGeometryMessenger;
+  delete fModuleParameterisation;
+}
+
+void DET01DetectorConstruction::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/det01/optics/", "Optical response control");
+
+  auto& modeCmd = fMessenger->DeclareMethod("mode", &DET01DetectorConstruction::SetOpticsMode,
+      "full: track all photons, fast: no photons, PE sampled from the response map "
+      "per charged deposit, "
+      "buildMap: track all photons and write the response map, "
+      "energy: no optical physics, parametrised PE/time response.");
+  modeCmd.SetCandidates("full fast buildMap energy");
+  modeCmd.SetStates(G4State_PreInit);
+  modeCmd.SetToBeBroadcasted(false);
+
+  auto& mapCmd = fMessenger->DeclareProperty("responseMap", fResponseMapFile,
+      "Response map file (read in fast mode, written in buildMap mode).");
+  mapCmd.SetStates(G4State_PreInit, G4State_Idle);
+  mapCmd.SetToBeBroadcasted(false);
+
+  auto& responseCmd = fMessenger->DeclareProperty("responseFile", fEnergyResponseFile,
+      "Calibration/jitter table of the energy-only mode (see DET01EnergyResponse).");
+  responseCmd.SetStates(G4State_PreInit);
+  responseCmd.SetToBeBroadcasted(false);
+
+  auto& fractionCmd = fMessenger->DeclareProperty("yieldFraction", fYieldFraction,
+      "Reduced yield (full mode): fraction of the scintillation photons that are generated "
+      "and tracked; the PE of the others are sampled from the deposits with "
+      "/det01/optics/responseMap. The mean and variance of the PE count are kept.");
+  fractionCmd.SetRange("yieldFraction > 0. && yieldFraction <= 1.");
+  fractionCmd.SetStates(G4State_PreInit);
+  fractionCmd.SetToBeBroadcasted(false);
+
+  fPmtMessenger = new G4GenericMessenger(this, "/det01/pmt/", "PMT hit storage");
+
+  auto& accCmd = fPmtMessenger->DeclareProperty("accumulate", fPmtAccumulate,
+      "One record per PMT (true) or one hit per photoelectron (false).");
+  accCmd.SetStates(G4State_PreInit);
+  accCmd.SetToBeBroadcasted(false);
+
+  auto& binsCmd = fPmtMessenger->DeclareProperty("timeBins", fPmtTimeBins,
+      "Number of arrival-time histogram bins per PMT (0 = no histogram).");
+  binsCmd.SetStates(G4State_PreInit);
+  binsCmd.SetToBeBroadcasted(false);
+
+  auto& widthCmd = fPmtMessenger->DeclarePropertyWithUnit("timeBinWidth", "ns", fPmtTimeBinWidth,
+      "Arrival-time histogram bin width.");
+  widthCmd.SetStates(G4State_PreInit);
+  widthCmd.SetToBeBroadcasted(false);
+
+  auto& verboseCmd = fPmtMessenger->DeclareProperty("verbose", fPmtVerbose,
+      "1: print the per-event photon summary (off by default).");
+  verboseCmd.SetStates(G4State_PreInit);
+  verboseCmd.SetToBeBroadcasted(false);
+
+  fTargetMessenger = new G4GenericMessenger(this, "/det01/target/", "CH2 target");
+
+  auto& targetCmd = fTargetMessenger->DeclareProperty("enable", fTargetEnabled,
+      "Place the CH2 target slab.");
+  targetCmd.SetStates(G4State_PreInit);
+  targetCmd.SetToBeBroadcasted(false);
+
+  auto& sizeCmd = fTargetMessenger->DeclarePropertyWithUnit("size", "cm", fTargetSize,
+      "Transverse size of the (square) target.");
+  sizeCmd.SetStates(G4State_PreInit);
+  sizeCmd.SetToBeBroadcasted(false);
+
+  auto& thickCmd = fTargetMessenger->DeclarePropertyWithUnit("thickness", "cm", fTargetThickness,
+      "Target thickness along the beam (z) axis.");
+  thickCmd.SetStates(G4State_PreInit);
+  thickCmd.SetToBeBroadcasted(false);
+
+  auto& posCmd = fTargetMessenger->DeclarePropertyWithUnit("position", "cm", fTargetPosition,
+      "Target centre (default upstream of the detector stack).");
+  posCmd.SetStates(G4State_PreInit);
+  posCmd.SetToBeBroadcasted(false);
+
+  fBiasMessenger = new G4GenericMessenger(this, "/det01/bias/", "Interaction biasing in the target");
+
+  auto& biasCmd = fBiasMessenger->DeclareProperty("enable", fBiasEnabled,
+      "Bias the primary deuteron interaction in the target.");
+  biasCmd.SetStates(G4State_PreInit);
+  biasCmd.SetToBeBroadcasted(false);
+
+  auto& biasModeCmd = fBiasMessenger->DeclareProperty("mode", fBiasMode,
+      "force: interact with probability P over the thickness, enhance: scale the cross section.");
+  biasModeCmd.SetCandidates("force enhance");
+  biasModeCmd.SetStates(G4State_PreInit);
+  biasModeCmd.SetToBeBroadcasted(false);
+
+  auto& processCmd = fBiasMessenger->DeclareProperty("process", fBiasProcess,
+      "Biased process of the deuteron (e.g. hadElastic, dInelastic; all: every hadronic process).");
+  processCmd.SetStates(G4State_PreInit);
+  processCmd.SetToBeBroadcasted(false);
+
+  auto& factorCmd = fBiasMessenger->DeclareProperty("factor", fBiasFactor,
+      "Cross-section factor in enhance mode.");
+  factorCmd.SetStates(G4State_PreInit);
+  factorCmd.SetToBeBroadcasted(false);
+
+  auto& probCmd = fBiasMessenger->DeclareProperty("probability", fBiasProbability,
+      "Interaction probability over the target thickness in force mode.");
+  probCmd.SetStates(G4State_PreInit);
+  probCmd.SetToBeBroadcasted(false);
+
+  fCutsMessenger = new G4GenericMessenger(this, "/det01/cuts/", "Production cuts per region");
+
+  auto& targetCutCmd = fCutsMessenger->DeclareMethodWithUnit("target", "mm",
+      &DET01DetectorConstruction::SetTargetCut, "Production cut in TargetRegion (< 0: default).");
+  targetCutCmd.SetStates(G4State_PreInit, G4State_Idle);
+  targetCutCmd.SetToBeBroadcasted(false);
+
+  auto& scinCutCmd = fCutsMessenger->DeclareMethodWithUnit("scintillator", "mm",
+      &DET01DetectorConstruction::SetScintillatorCut, "Production cut in ScintillatorRegion (< 0: default).");
+  scinCutCmd.SetStates(G4State_PreInit, G4State_Idle);
+  scinCutCmd.SetToBeBroadcasted(false);
+
+  auto& worldCutCmd = fCutsMessenger->DeclareMethodWithUnit("world", "mm",
+      &DET01DetectorConstruction::SetWorldCut, "Default production cut (world and unassigned volumes).");
+  worldCutCmd.SetStates(G4State_PreInit, G4State_Idle);
+  worldCutCmd.SetToBeBroadcasted(false);
+
+  // Layout; changes in Idle state take effect after /run/reinitializeGeometry
+  fGeometryMessenger = new G4GenericMessenger(this, "/det01/geometry/", "Detector layout");
+  std::vector<G4GenericMessenger::Command*> geometryCmds;
+
+  geometryCmds.push_back(&fGeometryMessenger->DeclareProperty("layout", fLayout,
+      "stack: cosmic stack along z, rings: rings around the +z beam axis facing the origin.")
+      .SetCandidates("stack rings"));
+  geometryCmds.push_back(&fGeometryMessenger->DeclareProperty("shape", fShape,
+      "Scintillator shape.").SetCandidates("cuboid cylinder"));
+  geometryCmds.push_back(&fGeometryMessenger->DeclarePropertyWithUnit("scinX", "mm", fScinX,
+      "Cuboid size along the PMT axis."));
+  geometryCmds.push_back(&fGeometryMessenger->DeclarePropertyWithUnit("scinY", "mm", fScinY,
+      "Cuboid width."));
+  geometryCmds.push_back(&fGeometryMessenger->DeclarePropertyWithUnit("scinZ", "mm", fScinZ,
+      "Cuboid height (stacking direction)."));
+  geometryCmds.push_back(&fGeometryMessenger->DeclarePropertyWithUnit("cylRadius", "mm", fCylRadius,
+      "Cylinder radius."));
+  geometryCmds.push_back(&fGeometryMessenger->DeclarePropertyWithUnit("cylLength", "mm", fCylLength,
+      "Cylinder length (along the PMT axis)."));
+  geometryCmds.push_back(&fGeometryMessenger->DeclareProperty("stackCount", fStackCount,
+      "Number of detectors in the stack layout."));
+  geometryCmds.push_back(&fGeometryMessenger->DeclarePropertyWithUnit("stackGap", "mm", fStackGap,
+      "Gap between stacked detectors."));
+  geometryCmds.push_back(&fGeometryMessenger->DeclareMethod("rings", &DET01DetectorConstruction::SetRingAngles,
+      "Polar angles of the rings in deg, e.g. \"30 45\"."));
+  geometryCmds.push_back(&fGeometryMessenger->DeclareMethod("perRing", &DET01DetectorConstruction::SetRingCounts,
+      "Detectors per ring, e.g. \"4 4\" (the last value repeats)."));
+  geometryCmds.push_back(&fGeometryMessenger->DeclarePropertyWithUnit("distance", "cm", fRingDistance,
+      "Origin to front face distance in the ring layout."));
+  geometryCmds.push_back(&fGeometryMessenger->DeclarePropertyWithUnit("phiOffset", "deg", fRingPhiOffset,
+      "Azimuth of the first detector of each ring."));
+
+  for (auto cmd : geometryCmds) {
+      cmd->SetStates(G4State_PreInit, G4State_Idle);
+      cmd->SetToBeBroadcasted(false);
+  }
+}
+
+void DET01DetectorConstruction::SetTargetCut(G4double cut)
+{
+  fTargetCut = cut;
+  ApplyRegionCut("TargetRegion", cut);
+}
+
+void DET01DetectorConstruction::SetScintillatorCut(G4double cut)
+{
+  fScintillatorCut = cut;
+  ApplyRegionCut("ScintillatorRegion", cut);
+}
+
+void DET01DetectorConstruction::SetWorldCut(G4double cut)
+{
+  // Same as /run/setCut: the default region follows the physics list
+  auto physicsList = const_cast<G4VUserPhysicsList*>(
+      G4RunManager::GetRunManager()->GetUserPhysicsList());
+  if (physicsList && cut > 0.) physicsList->SetDefaultCutValue(cut);
+}
+
+// Own cuts for a region, or the default ones for cut < 0
+void DET01DetectorConstruction::ApplyRegionCut(const G4String& regionName, G4double cut)
+{
+  G4Region* region = G4RegionStore::GetInstance()->GetRegion(regionName, false);
+  if (!region) return;   // applied in Construct()
+
+  if (cut < 0.) {
+      region->SetProductionCuts(nullptr);
+      return;
+  }
+  // Never modify the default region's cuts, which the kernel shares with
+  // regions that have none of their own
+  G4ProductionCuts* cuts = region->GetProductionCuts();
+  if (!cuts || cuts == G4ProductionCutsTable::GetProductionCutsTable()->GetDefaultProductionCuts()) {
+      cuts = new G4ProductionCuts();
+      region->SetProductionCuts(cuts);
+  }
+  cuts->SetProductionCut(cut);
+}
+
+void DET01DetectorConstruction::SetOpticsMode(const G4String& mode)
+{
+  fOpticsMode = mode;
+
+  // The energy-only mode runs without G4OpticalPhysics, the fast mode
+  // keeps it but no photon is stacked
+  auto physicsList = dynamic_cast<DET01PhysicsList*>(
+      const_cast<G4VUserPhysicsList*>(G4RunManager::GetRunManager()->GetUserPhysicsList()));
+  if (physicsList) {
+      physicsList->SetOpticalPhysics(mode != "energy");
+      physicsList->SetStackPhotons(mode != "fast");
+  }
 }
 
 void DET01DetectorConstruction::DefineMaterials()
@@ -66,7 +338,8 @@ void DET01DetectorConstruction::DefineMaterials()
   mptS2->AddProperty("RINDEX", photonEnergy, rindexS2, numEntries);
   mptS2->AddProperty("ABSLENGTH", photonEnergy, absLengthS2, numEntries);
   mptS2->AddProperty("SCINTILLATIONCOMPONENT1", scintEnergy, scintFast, numEntries);
-  mptS2->AddConstProperty("SCINTILLATIONYIELD", 10000./MeV); 
+  // Reduced yield: only the tracked share is generated (DET01OpticalDepositModel adds the rest)
+  mptS2->AddConstProperty("SCINTILLATIONYIELD", fYieldFraction * 10000./MeV); 
   mptS2->AddConstProperty("RESOLUTIONSCALE", 1.0);
   mptS2->AddConstProperty("SCINTILLATIONTIMECONSTANT1", 2.6*ns); 
   mptS2->AddConstProperty("SCINTILLATIONRISETIME1", 0.7*ns);
@@ -112,11 +385,30 @@ void DET01DetectorConstruction::DefineMaterials()
   mptCathode->AddProperty("RINDEX", photonEnergy, rindexCathode, numEntries);
   mptCathode->AddProperty("ABSLENGTH", photonEnergy, absCathode, numEntries);
   bialkali->SetMaterialPropertiesTable(mptCathode);
+
+  // 6. Target (CH2), built with the others even while the target is off,
+  //    so that it is known to the physics list at /run/initialize
+  nist->FindOrBuildMaterial("G4_POLYETHYLENE");
 }
 
 G4VPhysicalVolume* DET01DetectorConstruction::Construct()
 {
-  DefineMaterials();
+  // Cleanup old geometry (/run/reinitializeGeometry). Materials and the
+  // physics tables built for them are kept.
+  G4Region* scinRegion = G4RegionStore::GetInstance()->GetRegion("ScintillatorRegion", false);
+  G4Region* targetRegion = G4RegionStore::GetInstance()->GetRegion("TargetRegion", false);
+  if (scinRegion && fScintillatorLogical) scinRegion->RemoveRootLogicalVolume(fScintillatorLogical);
+  if (targetRegion && fTargetLogical) targetRegion->RemoveRootLogicalVolume(fTargetLogical);
+  fScintillatorLogical = nullptr;
+  fTargetLogical = nullptr;
+
+  G4GeometryManager::GetInstance()->OpenGeometry();
+  G4PhysicalVolumeStore::GetInstance()->Clean();
+  G4LogicalVolumeStore::GetInstance()->Clean();
+  G4SolidStore::GetInstance()->Clean();
+  G4LogicalBorderSurface::CleanSurfaceTable();
+
+  if (!G4Material::GetMaterial("HND-S2", false)) DefineMaterials();
 
   // Get Materials
   G4Material* air = G4Material::GetMaterial("G4_AIR");
@@ -125,23 +417,65 @@ G4VPhysicalVolume* DET01DetectorConstruction::Construct()
   G4Material* grease = G4Material::GetMaterial("OpticalGrease");
   G4Material* cathodeMat = G4Material::GetMaterial("Bialkali");
 
+  // Detector count of the layout
+  G4bool rings = (fLayout == "rings");
+  fDetectorRing.clear();
+  fDetectorTheta.clear();
+  fDetectorPhi.clear();
+  fFaceDistance = fFaceHalfSize = 0.;
+  if (rings) {
+      fNDetectors = 0;
+      for (size_t r=0; r<fRingAngles.size(); r++) fNDetectors += RingCount(r);
+  }
+  else {
+      fNDetectors = fStackCount;
+  }
+
   // --- Volumes ---
 
-  // 1. World
+  // Scintillator (module frame: PMT on the +axis face)
+  // Cuboid: 120 mm (X, Thickness relative to PMT) x 150 mm (Y, Width) x 150 mm (Z)
+  // Cylinder: axis along local Z, PMT on the +Z end
+  G4bool cylinder = (fShape == "cylinder");
+  G4VSolid* solidScin = nullptr;
+  G4double depth, stackPitch;    // extent along the PMT axis / along the stack
+  if (cylinder) {
+      solidScin = new G4Tubs("Scintillator", 0., fCylRadius, fCylLength/2, 0., 360.*deg);
+      depth = fCylLength;
+      stackPitch = 2.*fCylRadius;
+  }
+  else {
+      solidScin = new G4Box("Scintillator", fScinX/2, fScinY/2, fScinZ/2);
+      depth = fScinX;
+      stackPitch = fScinZ;
+  }
+  G4ThreeVector pmtAxis = cylinder ? G4ThreeVector(0, 0, 1) : G4ThreeVector(1, 0, 0);
+
+  // 1. World: at least 2 m, grown to the modules once they are placed
   G4double worldSize = 2.0*m;
   G4Box* solidWorld = new G4Box("World", worldSize/2, worldSize/2, worldSize/2);
   G4LogicalVolume* logicWorld = new G4LogicalVolume(solidWorld, air, "World");
   G4VPhysicalVolume* physWorld = new G4PVPlacement(0, G4ThreeVector(), logicWorld, "World", 0, false, 0, true);
 
-  // Detector Dimensions
-  // 120 mm (X, Thickness relative to PMT) x 150 mm (Y, Width) x 150 mm (Z, Beam Axis Thickness)
-  G4double scinX = 120.0*mm;
-  G4double scinY = 150.0*mm;
-  G4double scinZ = 150.0*mm;
-  
+  // Target (CH2 slab, beam along z)
+  if (fTargetEnabled) {
+      G4Material* ch2 = G4Material::GetMaterial("G4_POLYETHYLENE");
+      G4Box* solidTarget = new G4Box("Target", fTargetSize/2, fTargetSize/2, fTargetThickness/2);
+      fTargetLogical = new G4LogicalVolume(solidTarget, ch2, "Target");
+      new G4PVPlacement(0, fTargetPosition, fTargetLogical, "Target", logicWorld, false, 0, true);
+
+      if (!targetRegion) targetRegion = new G4Region("TargetRegion");
+      targetRegion->AddRootLogicalVolume(fTargetLogical);
+      ApplyRegionCut("TargetRegion", fTargetCut);
+  }
+
   // Logical Volumes (Shared)
-  G4Box* solidScin = new G4Box("Scintillator", scinX/2, scinY/2, scinZ/2);
-  G4LogicalVolume* logicScin = new G4LogicalVolume(solidScin, scinMat, "Scintillator");
+  fScintillatorLogical = new G4LogicalVolume(solidScin, scinMat, "Scintillator");
+
+  // Envelope for the optical fast simulation
+  if (!scinRegion) scinRegion = new G4Region("ScintillatorRegion");
+  scinRegion->AddRootLogicalVolume(fScintillatorLogical);
+  ApplyRegionCut("ScintillatorRegion", fScintillatorCut);
 
   G4double pmtDiam = 51.0*mm;
   G4double pmtRad = pmtDiam/2.0;
@@ -158,51 +492,192 @@ G4VPhysicalVolume* DET01DetectorConstruction::Construct()
   G4Tubs* solidCathode = new G4Tubs("Photocathode", 0., cathodeRad, cathodeThick/2, 0., 360.*deg);
   fPhotocathodeLogical = new G4LogicalVolume(solidCathode, cathodeMat, "Photocathode");
 
-  // Wrapping Surface
-  G4OpticalSurface* opTeflon = new G4OpticalSurface("TeflonSurface");
-  opTeflon->SetType(dielectric_LUT);
-  opTeflon->SetModel(unified);
-  opTeflon->SetFinish(groundteflonair);
-
-  // Stacking Loop (Along Z-Axis)
-  G4int nDetectors = 4;
-  G4double gap = 8.5*mm;
-  G4double stackHeight = nDetectors * scinZ + (nDetectors - 1) * gap;
-  G4double startZ = -stackHeight/2 + scinZ/2;
-
-  G4RotationMatrix* rot = new G4RotationMatrix();
-  rot->rotateY(90.*deg); 
-
-  for(G4int i=0; i<nDetectors; i++) {
-      G4double posZ = startZ + i * (scinZ + gap);
-      G4ThreeVector pos(0, 0, posZ);
-      
-      // ID Swapping: i=0 is Bottom, i=1 is Top.
-      // We want Top=0, Bottom=1.
-      // So ID = nDetectors - 1 - i;
-      G4int copyNo = nDetectors - 1 - i;
-
-      // Scintillator
-      G4VPhysicalVolume* physScin = new G4PVPlacement(0, pos, logicScin, "Scintillator", logicWorld, false, copyNo, true);
-      
-      // Apply Wrapping to this specific instance boundary
-      new G4LogicalBorderSurface("ScinTeflonWrapper", physScin, physWorld, opTeflon);
-
-      // Attach PMT Assembly (Relative to Scintillator center)
-      // PMT is on +X face. Global X = +scinX/2. Global Y = 0. Global Z = posZ.
-      G4double pmtAxisPos = scinX/2;
-      
-      // Grease
-      G4ThreeVector greasePos(pmtAxisPos + greaseThick/2, 0, posZ);
-      new G4PVPlacement(rot, greasePos, logicGrease, "Grease", logicWorld, false, copyNo, true);
-      
-      // Window
-      G4ThreeVector winPos(pmtAxisPos + greaseThick + winThick/2, 0, posZ);
-      new G4PVPlacement(rot, winPos, logicWindow, "PMTWindow", logicWorld, false, copyNo, true);
-      
-      // Cathode
-      G4ThreeVector cathodePos(pmtAxisPos + greaseThick + winThick + cathodeThick/2, 0, posZ);
-      new G4PVPlacement(rot, cathodePos, fPhotocathodeLogical, "Photocathode", logicWorld, false, copyNo, true);
+  // Wrapping Surface (one instance for all rebuilds: the global surface
+  // table keeps every G4OpticalSurface ever created)
+  if (!fTeflonSurface) {
+      fTeflonSurface = new G4OpticalSurface("TeflonSurface");
+      fTeflonSurface->SetType(dielectric_LUT);
+      fTeflonSurface->SetModel(unified);
+      fTeflonSurface->SetFinish(groundteflonair);
+  }
+  G4OpticalSurface* opTeflon = fTeflonSurface;
+
+  // PMT tubes (axis local Z) turned onto the module's PMT axis
+  G4RotationMatrix pmtRot;
+  if (!cylinder) pmtRot.rotateY(90.*deg);
+
+  // Module envelope: scintillator + grease/window/cathode on +axis, in air.
+  // Symmetric along the PMT axis so the scintillator sits at the origin of
+  // the module frame (the frame of the optical response maps).
+  const G4double pmtStack = greaseThick + winThick + cathodeThick;
+  G4double margin = 0.1*mm;
+  if (!rings) {
+      // Neighbouring modules of the stack are one pitch apart (the PMT may
+      // be wider than the scintillator)
+      G4double halfPitch = (stackPitch + fStackGap)/2;
+      G4double halfWidth = cylinder ? std::max(fCylRadius, pmtRad) : std::max(fScinZ/2, pmtRad);
+      margin = std::min(margin, halfPitch - halfWidth);
+      if (margin < 0.) {
+          G4Exception("DET01DetectorConstruction::Construct()", "DET01_004", FatalException,
+                      "/det01/geometry/stackGap too small: the PMTs of neighbouring modules overlap.");
+      }
+  }
+  G4VSolid* solidModule = nullptr;
+  if (cylinder) {
+      solidModule = new G4Tubs("Module", 0., std::max(fCylRadius, pmtRad) + margin,
+                               fCylLength/2 + pmtStack + margin, 0., 360.*deg);
+  }
+  else {
+      solidModule = new G4Box("Module", fScinX/2 + pmtStack + margin,
+                              std::max(fScinY/2, pmtRad) + margin, std::max(fScinZ/2, pmtRad) + margin);
+  }
+  G4LogicalVolume* logicModule = new G4LogicalVolume(solidModule, air, "Module");
+  logicModule->SetVisAttributes(G4VisAttributes::GetInvisible());
+
+  G4VPhysicalVolume* physScin = new G4PVPlacement(nullptr, G4ThreeVector(), fScintillatorLogical,
+                                                  "Scintillator", logicModule, false, 0, true);
+  G4double pmtAxisPos = depth/2;
+  G4double offsets[3] = { pmtAxisPos + greaseThick/2,
+                          pmtAxisPos + greaseThick + winThick/2,
+                          pmtAxisPos + greaseThick + winThick + cathodeThick/2 };
+  G4LogicalVolume* volumes[3] = { logicGrease, logicWindow, fPhotocathodeLogical };
+  const char* names[3] = { "Grease", "PMTWindow", "Photocathode" };
+  for (G4int j=0; j<3; j++) {
+      new G4PVPlacement(G4Transform3D(pmtRot, offsets[j] * pmtAxis), volumes[j], names[j],
+                        logicModule, false, 0, true);
+  }
+
+  // Module-to-world transforms, index = copyNo
+  std::vector<G4Transform3D> modules(fNDetectors);
+  G4ThreeVector scinLo, scinHi;
+  solidScin->BoundingLimits(scinLo, scinHi);
+  fEnvelopeLo.set(DBL_MAX, DBL_MAX, DBL_MAX);
+  fEnvelopeHi.set(-DBL_MAX, -DBL_MAX, -DBL_MAX);
+  G4ThreeVector moduleLo, moduleHi;
+  solidModule->BoundingLimits(moduleLo, moduleHi);
+  G4ThreeVector modulesLo(DBL_MAX, DBL_MAX, DBL_MAX), modulesHi(-DBL_MAX, -DBL_MAX, -DBL_MAX);
+  G4double modulesRMax = 0.;
+
+  auto placeModule = [&](const G4Transform3D& module, G4int copyNo) {
+      modules[copyNo] = module;
+
+      // Extent of all modules (their own envelope)
+      for (G4int corner=0; corner<8; corner++) {
+          G4Point3D p((corner & 1) ? moduleHi.x() : moduleLo.x(),
+                      (corner & 2) ? moduleHi.y() : moduleLo.y(),
+                      (corner & 4) ? moduleHi.z() : moduleLo.z());
+          p = module * p;
+          modulesLo.set(std::min(modulesLo.x(), p.x()), std::min(modulesLo.y(), p.y()),
+                        std::min(modulesLo.z(), p.z()));
+          modulesHi.set(std::max(modulesHi.x(), p.x()), std::max(modulesHi.y(), p.y()),
+                        std::max(modulesHi.z(), p.z()));
+          modulesRMax = std::max(modulesRMax, G4ThreeVector(p.x(), p.y(), p.z()).mag());
+      }
+
+      // Bounding box of all scintillators (cosmic generator envelope)
+      for (G4int corner=0; corner<8; corner++) {
+          G4Point3D p((corner & 1) ? scinHi.x() : scinLo.x(),
+                      (corner & 2) ? scinHi.y() : scinLo.y(),
+                      (corner & 4) ? scinHi.z() : scinLo.z());
+          p = module * p;
+          fEnvelopeLo.set(std::min(fEnvelopeLo.x(), p.x()), std::min(fEnvelopeLo.y(), p.y()),
+                          std::min(fEnvelopeLo.z(), p.z()));
+          fEnvelopeHi.set(std::max(fEnvelopeHi.x(), p.x()), std::max(fEnvelopeHi.y(), p.y()),
+                          std::max(fEnvelopeHi.z(), p.z()));
+      }
+  };
+
+  if (!rings) {
+      // Stacking Loop (Along Z-Axis), cylinders lie with their axis along X
+      G4double stackHeight = fNDetectors * stackPitch + (fNDetectors - 1) * fStackGap;
+      G4double startZ = -stackHeight/2 + stackPitch/2;
+
+      G4RotationMatrix moduleRot;
+      if (cylinder) moduleRot.rotateY(90.*deg);
+
+      for(G4int i=0; i<fNDetectors; i++) {
+          G4double posZ = startZ + i * (stackPitch + fStackGap);
+
+          // ID Swapping: i=0 is Bottom, i=1 is Top.
+          // We want Top=0, Bottom=1.
+          // So ID = nDetectors - 1 - i;
+          G4int copyNo = fNDetectors - 1 - i;
+
+          // PMT is on +X face
+          placeModule(G4Transform3D(moduleRot, G4ThreeVector(0, 0, posZ)), copyNo);
+      }
+  }
+  else {
+      // Rings around the beam (+z) axis: front face at fRingDistance from the
+      // origin, PMT facing outwards. copyNo runs over ring 0 first.
+      G4int copyNo = 0;
+      for (size_t r=0; r<fRingAngles.size(); r++) {
+          G4double theta = fRingAngles[r];
+          G4int n = RingCount(r);
+          for (G4int k=0; k<n; k++) {
+              G4double phi = fRingPhiOffset + k * 360.*deg / n;
+              G4ThreeVector radial(std::sin(theta)*std::cos(phi), std::sin(theta)*std::sin(phi), std::cos(theta));
+              G4ThreeVector phiHat(-std::sin(phi), std::cos(phi), 0.);
+
+              // PMT axis of the module -> radial direction
+              G4RotationMatrix moduleRot = cylinder
+                  ? G4RotationMatrix(phiHat.cross(radial), phiHat, radial)
+                  : G4RotationMatrix(radial, phiHat, radial.cross(phiHat));
+              G4ThreeVector centre = (fRingDistance + depth/2) * radial;
+
+              placeModule(G4Transform3D(moduleRot, centre), copyNo++);
+              fDetectorRing.push_back(r);
+              fDetectorTheta.push_back(theta);
+              fDetectorPhi.push_back(phi);
+          }
+      }
+
+      // The PMT axis points away from the origin: the front face is the
+      // disc of a cylinder or the Y x Z face of a cuboid
+      fFaceDistance = fRingDistance;
+      fFaceHalfSize = cylinder ? fCylRadius : 0.5 * std::max(fScinY, fScinZ);
+  }
+
+  // 20 cm of air around the outermost module corner (rings, tall stacks)
+  G4double worldHalf = std::max(worldSize/2, modulesRMax + 20.*cm);
+  solidWorld->SetXHalfLength(worldHalf);
+  solidWorld->SetYHalfLength(worldHalf);
+  solidWorld->SetZHalfLength(worldHalf);
+
+  // All modules as one parameterised volume: the navigator voxelizes the
+  // copies by their extents, so a step only sees the modules near it. The
+  // module copy number (touchable depth 1) is the detector ID.
+  delete fModuleParameterisation;
+  fModuleParameterisation = nullptr;
+  if (fNDetectors > 0) {
+      // A parameterised volume must be the only daughter of its mother: the
+      // modules get an air envelope of their own next to the Target, a box
+      // around the stack or a spherical shell around the rings (the target
+      // sits in the hole of the shell)
+      const G4double tolerance = 0.1*mm;
+      G4VSolid* solidDetectors = nullptr;
+      G4ThreeVector detectorsCentre;
+      if (rings) {
+          G4double rMin = std::max(0., fRingDistance - pmtStack - margin - tolerance);
+          solidDetectors = new G4Sphere("Detectors", rMin, modulesRMax + tolerance,
+                                        0., 360.*deg, 0., 180.*deg);
+      }
+      else {
+          detectorsCentre = 0.5 * (modulesLo + modulesHi);
+          G4ThreeVector half = 0.5 * (modulesHi - modulesLo) + G4ThreeVector(tolerance, tolerance, tolerance);
+          solidDetectors = new G4Box("Detectors", half.x(), half.y(), half.z());
+          for (auto& module : modules) module = G4Translate3D(-detectorsCentre) * module;
+      }
+      G4LogicalVolume* logicDetectors = new G4LogicalVolume(solidDetectors, air, "Detectors");
+      logicDetectors->SetVisAttributes(G4VisAttributes::GetInvisible());
+      new G4PVPlacement(nullptr, detectorsCentre, logicDetectors, "Detectors", logicWorld, false, 0, true);
+
+      fModuleParameterisation = new DET01ModuleParameterisation(modules);
+      G4VPhysicalVolume* physModule = new G4PVParameterised("Module", logicModule, logicDetectors, kUndefined,
+                                                            fNDetectors, fModuleParameterisation, true);
+
+      // Wrapping on the scintillator-air boundary of every module
+      new G4LogicalBorderSurface("ScinTeflonWrapper", physScin, physModule, opTeflon);
   }
 
   return physWorld;
@@ -210,22 +685,125 @@ G4VPhysicalVolume* DET01DetectorConstruction::Construct()
 
 void DET01DetectorConstruction::ConstructSDandField()
 {
-  // 1. Photocathode SD (Counts Photons)
-  if (fPhotocathodeLogical) {
+  // SDs survive /run/reinitializeGeometry: reuse them with the new layout
+  G4SDManager* sdManager = G4SDManager::GetSDMpointer();
+
+  // 1. Photocathode SD (Counts Photons), not needed without optical physics
+  DET01SensitiveDetector* cathodeSD = nullptr;
+  if (fYieldFraction < 1. && fOpticsMode != "full") {
+      G4Exception("DET01DetectorConstruction::ConstructSDandField()", "DET01_003", FatalException,
+                  "/det01/optics/yieldFraction < 1 needs /det01/optics/mode full.");
+  }
+  if (fPhotocathodeLogical && fOpticsMode != "energy") {
       G4String sdName = "PmtSD";
-      DET01SensitiveDetector* cathodeSD = new DET01SensitiveDetector(sdName, "HitsCollection");
-      G4SDManager::GetSDMpointer()->AddNewDetector(cathodeSD);
+      cathodeSD = static_cast<DET01SensitiveDetector*>(sdManager->FindSensitiveDetector(sdName, false));
+      if (!cathodeSD) {
+          cathodeSD = new DET01SensitiveDetector(sdName, "HitsCollection", fNDetectors);
+          cathodeSD->SetAccumulate(fPmtAccumulate);
+          cathodeSD->SetTimeBinning(fPmtTimeBins, fPmtTimeBinWidth);
+          cathodeSD->SetVerboseLevel(fPmtVerbose);
+          sdManager->AddNewDetector(cathodeSD);
+      }
+      cathodeSD->SetNDetectors(fNDetectors);
       SetSensitiveDetector(fPhotocathodeLogical, cathodeSD);
   }
 
   // 2. Scintillator SD (Measures Energy Deposition)
-  // We need to find the logical volume by name because we didn't store it in a member variable
-  // Or simpler: We know the name is "Scintillator"
-  G4LogicalVolume* scinLV = G4LogicalVolumeStore::GetInstance()->GetVolume("Scintillator");
+  G4LogicalVolume* scinLV = fScintillatorLogical;
   if (scinLV) {
       G4String scinSDName = "ScintSD";
-      DET01ScintSD* scinSD = new DET01ScintSD(scinSDName, "ScintHitsCollection");
-      G4SDManager::GetSDMpointer()->AddNewDetector(scinSD);
+      DET01ScintSD* scinSD = static_cast<DET01ScintSD*>(sdManager->FindSensitiveDetector(scinSDName, false));
+      if (!scinSD) {
+          scinSD = new DET01ScintSD(scinSDName, "ScintHitsCollection", fNDetectors);
+          sdManager->AddNewDetector(scinSD);
+      }
+      scinSD->SetNDetectors(fNDetectors);
+      if (fOpticsMode == "energy") {
+          // Each thread keeps its own copy of the response tables
+          DET01EnergyResponse* response = new DET01EnergyResponse();
+          if (!response->Read(fEnergyResponseFile, fNDetectors)) {
+              G4Exception("DET01DetectorConstruction::ConstructSDandField()", "DET01_002",
+                          FatalException, ("Cannot read energy response " + fEnergyResponseFile).c_str());
+          }
+          scinSD->SetEnergyResponse(response);
+      }
+      const G4bool reduced = fOpticsMode == "full" && fYieldFraction < 1.;
+      if ((fOpticsMode == "fast" || reduced) && cathodeSD) {
+          // Each thread keeps its own read-only copy of the map
+          DET01OpticalResponseMap* map = new DET01OpticalResponseMap();
+          if (!map->Read(fResponseMapFile)) {
+              G4Exception("DET01DetectorConstruction::ConstructSDandField()", "DET01_001",
+                          FatalException, ("Cannot read optical response map " + fResponseMapFile).c_str());
+          }
+          // Reduced yield: the untracked (1 - f) of the full yield, on top of the f tracked
+          G4double scale = reduced ? (1. - fYieldFraction) / fYieldFraction : 1.;
+          scinSD->SetOpticalModel(new DET01OpticalDepositModel(map, cathodeSD, scale));
+      }
+      else {
+          scinSD->SetOpticalModel(nullptr);
+      }
       SetSensitiveDetector(scinLV, scinSD);
   }
+
+  // 3. Interaction biasing of the primary in the target (one operator per thread)
+  if (fBiasEnabled && fTargetLogical) {
+      auto biasing = DET01BiasingOperator::GetInstance();
+      if (!biasing) {
+          biasing = new DET01BiasingOperator("deuteron", fBiasProcess, fBiasMode == "force",
+                                             fBiasFactor, fBiasProbability, fTargetThickness);
+      }
+      biasing->AttachTo(fTargetLogical);
+  }
+
+  // 4. Response-map recorder (buildMap mode). The model of the previous
+  //    geometry goes: the mode or PMT SD may have changed
+  G4Region* scinRegion = G4RegionStore::GetInstance()->GetRegion("ScintillatorRegion");
+  G4FastSimulationManager* fastSimManager = scinRegion ? scinRegion->GetFastSimulationManager() : nullptr;
+  if (fastSimManager && gOpticalModel) {
+      // Inactivating first makes the manager rebuild its per-particle model list
+      fastSimManager->InActivateFastSimulationModel(gOpticalModel->GetName());
+      fastSimManager->RemoveFastSimulationModel(gOpticalModel);
+  }
+  delete gOpticalModel;
+  gOpticalModel = nullptr;
+  if (!scinRegion || !scinLV || !cathodeSD || fOpticsMode != "buildMap") return;
+
+  // Grid covers the scintillator bounding box
+  G4ThreeVector lo, hi;
+  scinLV->GetSolid()->BoundingLimits(lo, hi);
+  DET01OpticalResponseMap* builder = DET01OpticalResponseMap::GetBuilder();
+  builder->SetGrid(lo, hi, 15.*mm);
+  cathodeSD->SetResponseMapBuilder(builder);
+
+  gOpticalModel = new DET01OpticalFastSimModel("OpticalMapRecorder", scinRegion);
+}
+
+G4bool DET01DetectorConstruction::GetScintillatorEnvelope(G4ThreeVector& lo, G4ThreeVector& hi) const
+{
+  if (fNDetectors <= 0 || fEnvelopeLo.x() > fEnvelopeHi.x()) return false;
+  lo = fEnvelopeLo;
+  hi = fEnvelopeHi;
+  return true;
+}
+
+G4int DET01DetectorConstruction::RingCount(size_t ring) const
+{
+  if (fRingCounts.empty()) return 0;
+  return (ring < fRingCounts.size()) ? fRingCounts[ring] : fRingCounts.back();
+}
+
+void DET01DetectorConstruction::SetRingAngles(const G4String& value)
+{
+  fRingAngles.clear();
+  std::istringstream is(value);
+  G4double angle;
+  while (is >> angle) fRingAngles.push_back(angle*deg);
+}
+
+void DET01DetectorConstruction::SetRingCounts(const G4String& value)
+{
+  fRingCounts.clear();
+  std::istringstream is(value);
+  G4int count;
+  while (is >> count) fRingCounts.push_back(count);
 }
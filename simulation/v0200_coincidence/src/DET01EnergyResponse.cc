@@ -0,0 +1,112 @@
+#include "DET01EnergyResponse.hh"
+
+#include "G4SystemOfUnits.hh"
+#include "G4Poisson.hh"
+#include "G4Exception.hh"
+#include "G4ios.hh"
+#include "Randomize.hh"
+
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+DET01EnergyResponse::DET01EnergyResponse()
+ : fBirks(0.)
+{}
+
+DET01EnergyResponse::~DET01EnergyResponse()
+{}
+
+G4bool DET01EnergyResponse::Read(const G4String& fileName, G4int nDetectors)
+{
+  std::ifstream in(fileName);
+  if (!in) return false;
+
+  std::vector<G4bool> found(nDetectors, false);
+  fConstants.assign(nDetectors, Constants());
+  Constants first;
+  G4bool haveFirst = false;
+
+  std::string line;
+  while (std::getline(in, line)) {
+      line = line.substr(0, line.find('#'));
+      std::istringstream is(line);
+      std::string tag;
+      if (!(is >> tag)) continue;
+
+      if (tag == "birks") {
+          G4double kB = 0.;
+          is >> kB;
+          fBirks = kB * mm/MeV;
+          continue;
+      }
+
+      // Detector tag: a plain integer; anything else (a typo) must not turn
+      // into the constants of detector 0
+      char* end = nullptr;
+      errno = 0;
+      long det = std::strtol(tag.c_str(), &end, 10);
+      if (end == tag.c_str() || *end != '\0' || errno == ERANGE || det < 0) {
+          G4Exception("DET01EnergyResponse::Read()", "DET01_1101", FatalException,
+                      ("Bad detector tag \"" + tag + "\" in " + fileName + ": " + line).c_str());
+          return false;
+      }
+
+      Constants c;
+      if (!(is >> c.pePerMeV >> c.mevPerMV >> c.offset >> c.opticalJitter >> c.electronicJitter)) {
+          G4cerr << "DET01EnergyResponse: bad line in " << fileName << ": " << line << G4endl;
+          return false;
+      }
+      c.pePerMeV /= MeV;
+      c.mevPerMV *= MeV;   // per mV, amplitudes are plain numbers in mV
+      c.offset *= ns;
+      c.opticalJitter *= ns;
+      c.electronicJitter *= ns;
+
+      if (!haveFirst) { first = c; haveFirst = true; }
+      if (det >= 0 && det < nDetectors) {
+          fConstants[det] = c;
+          found[det] = true;
+      }
+  }
+  if (!haveFirst) return false;
+
+  for (G4int i=0; i<nDetectors; i++) {
+      if (found[i]) continue;
+      G4cout << "DET01EnergyResponse: no constants for detector " << i
+             << " in " << fileName << ", using the first entry" << G4endl;
+      fConstants[i] = first;
+  }
+  return true;
+}
+
+G4double DET01EnergyResponse::Quench(G4double edep, G4double stepLength) const
+{
+  if (fBirks <= 0. || stepLength <= 0.) return edep;
+  return edep / (1. + fBirks * edep / stepLength);
+}
+
+void DET01EnergyResponse::Apply(G4int det, G4double visibleEnergy, G4double firstTime,
+                                G4int& npe, G4double& time, G4double& amplitude) const
+{
+  npe = 0;
+  time = -1.;
+  amplitude = 0.;
+  if (det < 0 || det >= (G4int)fConstants.size() || visibleEnergy <= 0.) return;
+
+  const Constants& c = fConstants[det];
+
+  // Photoelectron statistics (none if no light yield is given)
+  G4double measured = visibleEnergy;
+  if (c.pePerMeV > 0.) {
+      npe = G4Poisson(visibleEnergy * c.pePerMeV);
+      if (npe == 0) return;
+      measured = npe / c.pePerMeV;
+  }
+
+  amplitude = measured / c.mevPerMV;
+  time = firstTime + c.offset
+       + G4RandGauss::shoot(0., c.opticalJitter)
+       + G4RandGauss::shoot(0., c.electronicJitter);
+}
@@ -1,34 +1,56 @@
 #include "DET01EventAction.hh"
+#include "DET01RunAction.hh"
+#include "DET01EventSeeds.hh"
+#include "DET01Telemetry.hh"
+#include "DET01Trigger.hh"
+#include "DET01BiasingOperator.hh"
 #include "DET01Hit.hh"
+#include "DET01PmtHit.hh"
+#include "DET01SensitiveDetector.hh"
+#include "DET01ScintSD.hh"
+#include "DET01EnergyResponse.hh"
+#include "DET01PmtCounters.hh"
+#include "DET01AsymmetryCounters.hh"
+#include "DET01PmtDigitizer.hh"
 #include "G4Event.hh"
 #include "G4RunManager.hh"
 #include "G4Run.hh"
 #include "G4SDManager.hh"
-#include "G4AnalysisManager.hh"
 #include "G4SystemOfUnits.hh"
 #include <iomanip>
 
-DET01EventAction::DET01EventAction()
+DET01EventAction::DET01EventAction(DET01RunAction* runAction)
 : G4UserEventAction(),
+  fRunAction(runAction),
   fScintHCID(-1),
-  fPmtHCID(-1)
+  fPmtHCID(-1),
+  fPmtAccumulate(false),
+  fScintSD(nullptr),
+  fDigitizer(new DET01PmtDigitizer())
 {} 
 
 DET01EventAction::~DET01EventAction()
-{}
+{
+  delete fDigitizer;
+}
 
 void DET01EventAction::BeginOfEventAction(const G4Event*)
 {}
 
 void DET01EventAction::EndOfEventAction(const G4Event* event)
 {
-  // Get Analysis Manager
-  auto analysisManager = G4AnalysisManager::Instance();
-
   // Get Hits Collections IDs (only once)
+  // Each worker owns its event action and SDs, so the cached IDs are per thread
   if (fScintHCID == -1) {
       fScintHCID = G4SDManager::GetSDMpointer()->GetCollectionID("ScintSD/ScintHitsCollection");
       fPmtHCID   = G4SDManager::GetSDMpointer()->GetCollectionID("PmtSD/HitsCollection");
+
+      auto pmtSD = static_cast<DET01SensitiveDetector*>(
+          G4SDManager::GetSDMpointer()->FindSensitiveDetector("PmtSD", false));
+      fPmtAccumulate = pmtSD && pmtSD->GetAccumulate();
+
+      fScintSD = static_cast<const DET01ScintSD*>(
+          G4SDManager::GetSDMpointer()->FindSensitiveDetector("ScintSD", false));
   }
 
   // Get Hits Collections
@@ -41,94 +63,126 @@ void DET01EventAction::EndOfEventAction(const G4Event* event)
   }
     
   DET01HitsCollection* pmtHC = nullptr;
+  DET01PmtHitsCollection* pmtRecords = nullptr;
   if (fPmtHCID != -1) {
-      pmtHC = static_cast<DET01HitsCollection*>(hce->GetHC(fPmtHCID));
+      if (fPmtAccumulate) pmtRecords = static_cast<DET01PmtHitsCollection*>(hce->GetHC(fPmtHCID));
+      else pmtHC = static_cast<DET01HitsCollection*>(hce->GetHC(fPmtHCID));
   }
 
-  // Variables to store data
-  G4double edep0 = 0., edep1 = 0., edep2 = 0., edep3 = 0.;
-  G4int pe0 = 0, pe1 = 0, pe2 = 0, pe3 = 0;
-  G4double time0 = 99999.*ns, time1 = 99999.*ns, time2 = 99999.*ns, time3 = 99999.*ns;
-  
-  // Position Data (Default 0,0,0)
-  G4ThreeVector posIn[4];
-  G4ThreeVector posOut[4];
+  // Per-detector data, indexed by copy number
+  const G4int nDet = fRunAction->GetNDetectors();
+  DET01EventData& data = fEventData;
+  data.Clear(nDet);
+
+  // Energy-only optics mode: PE, time and amplitude from the response tables
+  const DET01EnergyResponse* response = fScintSD ? fScintSD->GetEnergyResponse() : nullptr;
 
   // Process Scintillator Hits (Energy + Position)
   if (scintHC) {
       for (size_t i=0; i<scintHC->entries(); i++) {
           DET01Hit* hit = (*scintHC)[i];
           G4int id = hit->GetDetID();
-          
-          if (id >= 0 && id < 4) {
-              if (id == 0) edep0 += hit->GetEdep();
-              if (id == 1) edep1 += hit->GetEdep();
-              if (id == 2) edep2 += hit->GetEdep();
-              if (id == 3) edep3 += hit->GetEdep();
-              
-              if (hit->GetHasPrimary()) {
-                  posIn[id] = hit->GetPosIn();
-                  posOut[id] = hit->GetPosOut();
-              }
+          if (id < 0 || id >= nDet) continue;
+
+          data.edep[id] += hit->GetEdep();
+          if (response && hit->GetEdep() > 0.) {
+              response->Apply(id, fScintSD->GetVisibleEnergy(id), hit->GetTime(),
+                              data.pe[id], data.time[id], data.amplitude[id]);
+          }
+          if (hit->GetHasPrimary()) {
+              data.hasPrimary[id] = true;
+              data.posIn[id] = hit->GetPosIn();
+              data.posOut[id] = hit->GetPosOut();
           }
       }
   }
 
-  // Process PMT Hits (Photons)
+  // Photoelectron times for the digitizer and the photon-time sidecar
+  const G4bool digitize = fRunAction->IsDigitized() && (pmtRecords || pmtHC);
+  const G4bool sidecar = fRunAction->WritesPhotonTimes() && (pmtRecords || pmtHC);
+  const G4bool collectTimes = digitize || sidecar;
+  if (collectTimes) {
+      fPeTimes.resize(nDet);
+      for (auto& times : fPeTimes) times.clear();
+  }
+
+  // Process PMT records (one per PMT, accumulate mode)
+  if (pmtRecords) {
+      for (size_t i=0; i<pmtRecords->entries(); i++) {
+          DET01PmtHit* record = (*pmtRecords)[i];
+          G4int id = record->GetDetID();
+          if (id < 0 || id >= nDet || record->GetNPE() == 0) continue;
+
+          data.pe[id] = record->GetNPE();
+          data.time[id] = record->GetFirstTime();
+
+          // Every photoelectron time (the run action has the records keep them)
+          if (collectTimes) fPeTimes[id] = record->GetTimes();
+      }
+  }
+
+  // Process PMT Hits (Photons, per-photon mode)
   if (pmtHC) {
       for (size_t i=0; i<pmtHC->entries(); i++) {
           DET01Hit* hit = (*pmtHC)[i];
           G4int id = hit->GetDetID();
+          if (id < 0 || id >= nDet) continue;
+
           G4double t = hit->GetTime();
-          
-          if (id == 0) { pe0++; if (t < time0) time0 = t; }
-          if (id == 1) { pe1++; if (t < time1) time1 = t; }
-          if (id == 2) { pe2++; if (t < time2) time2 = t; }
-          if (id == 3) { pe3++; if (t < time3) time3 = t; }
+          if (data.pe[id] == 0 || t < data.time[id]) data.time[id] = t;
+          data.pe[id]++;
+          if (collectTimes) fPeTimes[id].push_back(t);
+      }
+  }
+
+  // No PMT SD in energy-only mode: run counters are filled here
+  if (response) DET01PmtCounters::GetInstance()->Fill(data.pe);
+
+  // Digitized pulses, common window for all PMTs of the event
+  if (digitize) {
+      G4double first = -1.;
+      for (G4int id=0; id<nDet; id++) {
+          if (data.pe[id] > 0 && (first < 0. || data.time[id] < first)) first = data.time[id];
+      }
+      if (first >= 0.) {
+          G4double windowStart = first - fDigitizer->GetPreTrigger();
+          for (G4int id=0; id<nDet; id++) {
+              if (fPeTimes[id].empty()) continue;
+              fDigitizer->Digitize(fPeTimes[id], windowStart, data.digiAmplitude[id], data.digiTime[id]);
+          }
       }
   }
-  
-  // Fix time if no hits
-  if (pe0 == 0) time0 = -1.0;
-  if (pe1 == 0) time1 = -1.0;
-  if (pe2 == 0) time2 = -1.0;
-  if (pe3 == 0) time3 = -1.0;
-
-  // Get Truth Z
-  G4double truthZ = event->GetPrimaryVertex(0)->GetPosition().z();
-
-  // Fill Ntuple
-  analysisManager->FillNtupleIColumn(0, event->GetEventID());
-  
-  analysisManager->FillNtupleDColumn(1, edep0);
-  analysisManager->FillNtupleDColumn(2, edep1);
-  analysisManager->FillNtupleDColumn(3, edep2);
-  analysisManager->FillNtupleDColumn(4, edep3);
-  
-  analysisManager->FillNtupleIColumn(5, pe0);
-  analysisManager->FillNtupleIColumn(6, pe1);
-  analysisManager->FillNtupleIColumn(7, pe2);
-  analysisManager->FillNtupleIColumn(8, pe3);
-  
-  analysisManager->FillNtupleDColumn(9, time0);
-  analysisManager->FillNtupleDColumn(10, time1);
-  analysisManager->FillNtupleDColumn(11, time2);
-  analysisManager->FillNtupleDColumn(12, time3);
-  
-  // Fill Positions (13-36)
-  int col = 13;
-  for(int i=0; i<4; i++) {
-      analysisManager->FillNtupleDColumn(col++, posIn[i].x());
-      analysisManager->FillNtupleDColumn(col++, posIn[i].y());
-      analysisManager->FillNtupleDColumn(col++, posIn[i].z());
-      analysisManager->FillNtupleDColumn(col++, posOut[i].x());
-      analysisManager->FillNtupleDColumn(col++, posOut[i].y());
-      analysisManager->FillNtupleDColumn(col++, posOut[i].z());
+
+  // Get Truth Z (EventID and seeds: listed ones when replaying)
+  auto seeds = DET01EventSeeds::GetInstance();
+  data.eventID = seeds->GetEventID();
+  data.seed[0] = seeds->GetSeed(0);
+  data.seed[1] = seeds->GetSeed(1);
+  data.truthZ = event->GetPrimaryVertex(0)->GetPosition().z();
+  data.weight = event->GetPrimaryVertex(0)->GetWeight();
+  if (auto biasing = DET01BiasingOperator::GetInstance()) data.weight *= biasing->GetEventWeight();
+
+  // Sidecar: every event with photoelectrons, whatever the trigger decides
+  // (det01_replay applies its own); after the digitizer, as the times are
+  // converted and reordered
+  if (sidecar) {
+      G4bool any = false;
+      for (const auto& times : fPeTimes) any = any || !times.empty();
+      if (any) fRunAction->WritePhotonTimes(data.eventID, fPeTimes);
   }
-  
-  analysisManager->FillNtupleDColumn(37, truthZ);
-  
-  analysisManager->AddNtupleRow();
+
+  // Trigger, then Fill Ntuple (rejected events are only counted)
+  G4bool accepted = fRunAction->GetTrigger()->Accept(data.edep);
+  fRunAction->CountTrigger(accepted);
+  DET01Telemetry::CountEvent(accepted);
+  if (accepted && fRunAction->WritesEvents()) fRunAction->FillNtuple(data);
+
+  // Two-pass runs: events to regenerate with full optics
+  seeds->Select(data, fRunAction->GetTrigger(), accepted);
+
+  // Per-detector yields for the azimuthal asymmetry
+  auto asymmetry = DET01AsymmetryCounters::GetInstance();
+  if (accepted && asymmetry->IsEnabled()) asymmetry->Fill(data.edep, fRunAction->GetTrigger(), data.weight);
 
   // Progress Reporting (Custom "X / Y" format)
   G4int eventID = event->GetEventID();
@@ -0,0 +1,279 @@
+#include "DET01EventSeeds.hh"
+#include "DET01EventData.hh"
+#include "DET01Trigger.hh"
+#include "DET01Checkpoint.hh"
+#include "DET01IsolatedOptics.hh"
+
+#include "G4Event.hh"
+#include "G4RunManager.hh"
+#include "G4GenericMessenger.hh"
+#include "G4Exception.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+  std::uint64_t SplitMix64(std::uint64_t& state)
+  {
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  // Seeds fit the Int ntuple columns: 1 .. 2^31 - 1
+  G4int NextSeed(std::uint64_t& state)
+  {
+    return 1 + (G4int)(SplitMix64(state) % 0x7ffffffeULL);
+  }
+}
+
+DET01EventSeeds* DET01EventSeeds::GetInstance()
+{
+  static G4ThreadLocal DET01EventSeeds* instance = nullptr;
+  if (!instance) instance = new DET01EventSeeds();
+  return instance;
+}
+
+DET01EventSeeds::DET01EventSeeds(const G4String& name)
+ : G4VAccumulable(name),
+   fMessenger(nullptr),
+   fPerEvent(false),
+   fBase(1),
+   fEventOffset(0),
+   fEdepLow(0.),
+   fEdepHigh(0.),
+   fEventID(0),
+   fSeeds{ 0, 0 }
+{
+  fMessenger = new G4GenericMessenger(this, "/det01/seeds/", "Per-event seeds and two-pass runs");
+
+  fMessenger->DeclareProperty("perEvent", fPerEvent,
+      "Reseed every event from /det01/seeds/base and its EventID (Seed0/Seed1 columns).");
+
+  fMessenger->DeclareProperty("base", fBase,
+      "Base seed of the per-event seeds (det01 -s, det01_mpi and det01_scan.py set it).");
+
+  fMessenger->DeclareProperty("eventOffset", fEventOffset,
+      "Added to the EventIDs of the next runs, so that the events of MPI ranks and "
+      "scan jobs are numbered (and seeded) apart.");
+
+  fMessenger->DeclareProperty("select", fSelectFile,
+      "Pass 1: list the selected events (eventID seed0 seed1) in this file (empty: off).");
+
+  fMessenger->DeclarePropertyWithUnit("edepLow", "MeV", fEdepLow,
+      "Select events with a scintillator deposit in [edepLow, edepHigh].");
+
+  fMessenger->DeclarePropertyWithUnit("edepHigh", "MeV", fEdepHigh,
+      "Upper end of the deposit window (<= 0: no window).");
+
+  fMessenger->DeclareProperty("coincidence", fCoincidence,
+      "Select events in which both detectors of a pair fired, e.g. \"0-1 2-3\".");
+
+  fMessenger->DeclareProperty("crosstalk", fCrosstalk,
+      "Select events in which exactly one detector of a pair fired, e.g. \"0-1 1-2\".");
+
+  fMessenger->DeclareMethod("replay", &DET01EventSeeds::LoadReplay,
+      "Pass 2: regenerate the events of this list (empty: off), run with /det01/seeds/beamOn.");
+
+  auto& beamOnCmd = fMessenger->DeclareMethod("beamOn", &DET01EventSeeds::BeamOn,
+      "Run one event per entry of the replay list.");
+  beamOnCmd.SetStates(G4State_Idle);
+  beamOnCmd.SetToBeBroadcasted(false);
+}
+
+DET01EventSeeds::~DET01EventSeeds()
+{
+  delete fMessenger;
+}
+
+void DET01EventSeeds::DeriveSeeds(G4int base, G4int eventID, G4int seeds[2])
+{
+  std::uint64_t state = ((std::uint64_t)(std::uint32_t)base << 32) | (std::uint32_t)eventID;
+  seeds[0] = NextSeed(state);
+  seeds[1] = NextSeed(state);
+}
+
+void DET01EventSeeds::BeginEvent(const G4Event* event)
+{
+  const G4int index = event->GetEventID();
+
+  if (!fReplay.empty()) {
+      if (index >= (G4int)fReplay.size()) {
+          std::ostringstream message;
+          message << "Event " << index << " beyond the " << fReplay.size()
+                  << " entries of the replay list " << fReplayFile << ".";
+          G4Exception("DET01EventSeeds::BeginEvent()", "DET01_802", FatalException,
+                      message.str().c_str());
+          return;
+      }
+      fEventID = fReplay[index].eventID;
+      fSeeds[0] = fReplay[index].seed0;
+      fSeeds[1] = fReplay[index].seed1;
+  }
+  else {
+      fEventID = fEventOffset + DET01Checkpoint::GetEventOffset() + index;
+      if (IsRecording()) {
+          DeriveSeeds(fBase, fEventID, fSeeds);
+      }
+      else {
+          // Not seeded: the optical engine still follows the event's stream
+          fSeeds[0] = fSeeds[1] = 0;
+          if (DET01IsolatedOptics::IsActive()) {
+              DET01IsolatedOptics::Reseed(1 + (long)(G4UniformRand() * 2147483646.),
+                                          1 + (long)(G4UniformRand() * 2147483646.));
+          }
+          return;
+      }
+  }
+
+  long seeds[2] = { fSeeds[0], fSeeds[1] };
+  G4Random::setTheSeeds(seeds, 2);
+
+  // Optical engine: its own stream of the same event
+  if (DET01IsolatedOptics::IsActive()) {
+      std::uint64_t state = ((std::uint64_t)(std::uint32_t)fSeeds[0] << 32) | (std::uint32_t)fSeeds[1];
+      state ^= 0x6f70746963616cULL;
+      long seed0 = NextSeed(state);
+      DET01IsolatedOptics::Reseed(seed0, NextSeed(state));
+  }
+  else if (!fReplay.empty()) {
+      static G4ThreadLocal G4bool warned = false;
+      if (!warned) {
+          G4Exception("DET01EventSeeds::BeginEvent()", "DET01_803", JustWarning,
+                      "Replay without /det01/physics/isolateOptics: only the primaries are "
+                      "regenerated exactly, the charged stage may differ from pass 1.");
+          warned = true;
+      }
+  }
+}
+
+std::vector<std::pair<G4int, G4int>> DET01EventSeeds::ParsePairList(const G4String& list)
+{
+  std::vector<std::pair<G4int, G4int>> pairs;
+  std::istringstream in(list);
+  std::string token;
+  while (in >> token) {
+      size_t dash = token.find('-');
+      std::istringstream a(token.substr(0, dash)), b(dash == std::string::npos ? "" : token.substr(dash + 1));
+      std::pair<G4int, G4int> pair;
+      if (!(a >> pair.first) || !(b >> pair.second) || pair.first < 0 || pair.second < 0) {
+          G4Exception("DET01EventSeeds::ParsePairList()", "DET01_804", JustWarning,
+                      ("Ignoring detector pair \"" + token + "\" (expected a-b).").c_str());
+          continue;
+      }
+      pairs.push_back(pair);
+  }
+  return pairs;
+}
+
+void DET01EventSeeds::ParsePairs()
+{
+  if (fCoincidence != fParsedCoincidence) {
+      fCoincidencePairs = ParsePairList(fCoincidence);
+      fParsedCoincidence = fCoincidence;
+  }
+  if (fCrosstalk != fParsedCrosstalk) {
+      fCrosstalkPairs = ParsePairList(fCrosstalk);
+      fParsedCrosstalk = fCrosstalk;
+  }
+}
+
+void DET01EventSeeds::Select(const DET01EventData& data, const DET01Trigger* trigger, G4bool accepted)
+{
+  if (fSelectFile.empty()) return;
+  ParsePairs();
+
+  G4bool criteria = false, selected = false;
+
+  // Near-threshold deposits
+  if (fEdepHigh > 0.) {
+      criteria = true;
+      for (auto edep : data.edep) selected = selected || (edep >= fEdepLow && edep <= fEdepHigh);
+  }
+
+  // Detector pairs, DET01Trigger thresholds (out-of-range detectors never fire)
+  auto fired = [&](G4int det) { return trigger->Fired(data.edep, det); };
+  for (const auto& pair : fCoincidencePairs) {
+      criteria = true;
+      selected = selected || (fired(pair.first) && fired(pair.second));
+  }
+  for (const auto& pair : fCrosstalkPairs) {
+      criteria = true;
+      selected = selected || (fired(pair.first) != fired(pair.second));
+  }
+
+  if (!criteria) selected = accepted;
+  if (selected) fSelected.push_back({ data.eventID, fSeeds[0], fSeeds[1] });
+}
+
+void DET01EventSeeds::Merge(const G4VAccumulable& other)
+{
+  const DET01EventSeeds& right = static_cast<const DET01EventSeeds&>(other);
+  fSelected.insert(fSelected.end(), right.fSelected.begin(), right.fSelected.end());
+}
+
+void DET01EventSeeds::Reset()
+{
+  fSelected.clear();
+}
+
+void DET01EventSeeds::WriteSelection(const G4String& suffix) const
+{
+  if (fSelectFile.empty()) return;
+
+  // <file>[.txt] -> <file><suffix>.txt (MPI ranks)
+  G4String fileName = fSelectFile;
+  if (!suffix.empty()) {
+      if (G4StrUtil::ends_with(fileName, ".txt")) fileName.erase(fileName.size() - 4);
+      fileName += suffix + ".txt";
+  }
+
+  std::vector<Entry> entries(fSelected);
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) { return a.eventID < b.eventID; });
+
+  std::ofstream file(fileName);
+  file << "# DET01 selected events: eventID seed0 seed1 (/det01/seeds/replay)" << "\n";
+  for (const auto& entry : entries) {
+      file << entry.eventID << " " << entry.seed0 << " " << entry.seed1 << "\n";
+  }
+  G4cout << " Seeds: " << entries.size() << " selected event(s) listed in " << fileName << G4endl;
+}
+
+void DET01EventSeeds::LoadReplay(const G4String& fileName)
+{
+  fReplayFile = fileName;
+  fReplay.clear();
+  if (fileName.empty()) return;
+
+  std::ifstream file(fileName);
+  if (!file) {
+      G4Exception("DET01EventSeeds::LoadReplay()", "DET01_801", FatalException,
+                  ("Cannot read replay list " + fileName).c_str());
+      return;
+  }
+
+  std::string line;
+  while (std::getline(file, line)) {
+      if (line.empty() || line[0] == '#') continue;
+      std::istringstream in(line);
+      Entry entry;
+      if (in >> entry.eventID >> entry.seed0 >> entry.seed1) fReplay.push_back(entry);
+  }
+}
+
+void DET01EventSeeds::BeamOn()
+{
+  if (fReplay.empty()) {
+      G4Exception("DET01EventSeeds::BeamOn()", "DET01_805", JustWarning,
+                  "No replay list loaded (/det01/seeds/replay), nothing done.");
+      return;
+  }
+  G4cout << " Seeds: replaying " << fReplay.size() << " event(s) of " << fReplayFile << G4endl;
+  G4RunManager::GetRunManager()->BeamOn(fReplay.size());
+}
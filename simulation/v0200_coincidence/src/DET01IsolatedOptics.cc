@@ -0,0 +1,66 @@
+#include "DET01IsolatedOptics.hh"
+
+#include "G4Track.hh"
+#include "G4Step.hh"
+#include "Randomize.hh"
+#include "CLHEP/Random/MixMaxRng.h"
+
+G4bool DET01IsolatedOptics::fGeneratePhotons = true;
+
+namespace
+{
+  // Created with the first wrapper of the thread, lives as long as the thread
+  G4ThreadLocal CLHEP::HepRandomEngine* opticalEngine = nullptr;
+
+  // Runs the wrapped DoIt on the optical engine
+  class EngineSwap
+  {
+    public:
+      EngineSwap() : fMain(G4Random::getTheEngine()) { G4Random::setTheEngine(opticalEngine); }
+      ~EngineSwap() { G4Random::setTheEngine(fMain); }
+
+    private:
+      CLHEP::HepRandomEngine* fMain;
+  };
+}
+
+DET01IsolatedOptics::DET01IsolatedOptics()
+ : G4WrapperProcess("")   // the name is the wrapped process's (RegisterProcess)
+{
+  if (!opticalEngine) opticalEngine = new CLHEP::MixMaxRng();
+}
+
+DET01IsolatedOptics::~DET01IsolatedOptics()
+{}
+
+CLHEP::HepRandomEngine* DET01IsolatedOptics::GetEngine()
+{
+  return opticalEngine;
+}
+
+void DET01IsolatedOptics::Reseed(long seed0, long seed1)
+{
+  if (!opticalEngine) return;
+  long seeds[2] = { seed0, seed1 };
+  opticalEngine->setSeeds(seeds, 2);
+}
+
+G4VParticleChange* DET01IsolatedOptics::PostStepDoIt(const G4Track& track, const G4Step& step)
+{
+  if (!fGeneratePhotons) {
+      fNoChange.Initialize(track);
+      return &fNoChange;
+  }
+  EngineSwap swap;
+  return G4WrapperProcess::PostStepDoIt(track, step);
+}
+
+G4VParticleChange* DET01IsolatedOptics::AtRestDoIt(const G4Track& track, const G4Step& step)
+{
+  if (!fGeneratePhotons) {
+      fNoChange.Initialize(track);
+      return &fNoChange;
+  }
+  EngineSwap swap;
+  return G4WrapperProcess::AtRestDoIt(track, step);
+}
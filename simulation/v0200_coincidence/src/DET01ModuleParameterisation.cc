@@ -0,0 +1,24 @@
+#include "DET01ModuleParameterisation.hh"
+
+#include "G4VPhysicalVolume.hh"
+
+DET01ModuleParameterisation::DET01ModuleParameterisation(const std::vector<G4Transform3D>& modules)
+ : G4VPVParameterisation()
+{
+  // G4PVPlacement convention: the volume stores the inverse (frame) rotation
+  for (const auto& module : modules) {
+      fTranslations.push_back(module.getTranslation());
+      fRotations.push_back(module.getRotation().inverse());
+  }
+}
+
+DET01ModuleParameterisation::~DET01ModuleParameterisation()
+{}
+
+void DET01ModuleParameterisation::ComputeTransformation(const G4int copyNo,
+                                                        G4VPhysicalVolume* physVol) const
+{
+  physVol->SetTranslation(fTranslations[copyNo]);
+  // The rotation object is owned here and const for the whole run
+  physVol->SetRotation(const_cast<G4RotationMatrix*>(&fRotations[copyNo]));
+}
@@ -0,0 +1,122 @@
+#include "DET01OpticalDepositModel.hh"
+#include "DET01OpticalResponseMap.hh"
+#include "DET01SensitiveDetector.hh"
+
+#include "G4Step.hh"
+#include "G4Material.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4OpticalParameters.hh"
+#include "G4LossTableManager.hh"
+#include "G4EmSaturation.hh"
+#include "G4VTouchable.hh"
+#include "G4NavigationHistory.hh"
+#include "G4AffineTransform.hh"
+#include "G4Poisson.hh"
+#include "Randomize.hh"
+#include "CLHEP/Random/RandBinomial.h"
+
+#include <algorithm>
+#include <cmath>
+
+DET01OpticalDepositModel::DET01OpticalDepositModel(const DET01OpticalResponseMap* map,
+                                                   DET01SensitiveDetector* pmtSD,
+                                                   G4double yieldScale)
+ : fMap(map),
+   fPmtSD(pmtSD),
+   fSegmentLength(0.5 * map->GetVoxelSize()),
+   fYieldScale(yieldScale),
+   fMaterial(nullptr),
+   fYield(0.),
+   fResolutionScale(1.),
+   fDecayTime(0.),
+   fRiseTime(0.)
+{}
+
+DET01OpticalDepositModel::~DET01OpticalDepositModel()
+{
+  delete fMap;
+}
+
+void DET01OpticalDepositModel::SetMaterial(const G4Material* material)
+{
+  fMaterial = material;
+  fYield = fDecayTime = fRiseTime = 0.;
+  fResolutionScale = 1.;
+
+  G4MaterialPropertiesTable* mpt = material->GetMaterialPropertiesTable();
+  if (!mpt) return;
+  auto constant = [mpt](const G4String& key, G4double value) {
+    return mpt->ConstPropertyExists(key) ? mpt->GetConstProperty(key) : value;
+  };
+  fYield = fYieldScale * constant("SCINTILLATIONYIELD", 0.);
+  fResolutionScale = constant("RESOLUTIONSCALE", 1.);
+  fDecayTime = constant("SCINTILLATIONTIMECONSTANT1", 0.);
+  if (G4OpticalParameters::Instance()->GetScintFiniteRiseTime()) {
+      fRiseTime = constant("SCINTILLATIONRISETIME1", 0.);
+  }
+}
+
+// Emission delay of one photon (G4Scintillation::sample_time)
+G4double DET01OpticalDepositModel::SampleEmissionDelay() const
+{
+  if (fDecayTime <= 0.) return 0.;
+  if (fRiseTime <= 0.) return -fDecayTime * std::log(G4UniformRand());
+
+  const G4double d = (fRiseTime + fDecayTime) / fDecayTime;
+  while (true) {
+      G4double t = -fDecayTime * std::log(1. - G4UniformRand());
+      G4double g = d * std::exp(-t / fDecayTime) / fDecayTime;
+      G4double f = std::exp(-t / fDecayTime) * (1. - std::exp(-t / fRiseTime))
+                 / fDecayTime / fDecayTime * (fRiseTime + fDecayTime);
+      if (G4UniformRand() * g <= f) return t;
+  }
+}
+
+void DET01OpticalDepositModel::Deposit(const G4Step* step, G4int detID)
+{
+  const G4StepPoint* pre = step->GetPreStepPoint();
+  const G4StepPoint* post = step->GetPostStepPoint();
+  if (pre->GetMaterial() != fMaterial) SetMaterial(pre->GetMaterial());
+  if (fYield <= 0.) return;
+
+  // Photons the step would emit (G4Scintillation)
+  const G4double visible = G4LossTableManager::Instance()->EmSaturation()->VisibleEnergyDepositionAtAStep(step);
+  const G4double meanPhotons = fYield * visible;
+  G4long nPhotons = 0;
+  if (meanPhotons > 10.) {
+      nPhotons = G4long(G4RandGauss::shoot(meanPhotons, fResolutionScale * std::sqrt(meanPhotons)) + 0.5);
+  }
+  else {
+      nPhotons = G4Poisson(meanPhotons);
+  }
+  if (nPhotons <= 0) return;
+
+  // Detection efficiency along the step, in the scintillator's frame
+  const G4AffineTransform& toLocal = pre->GetTouchable()->GetHistory()->GetTopTransform();
+  const G4ThreeVector start = toLocal.TransformPoint(pre->GetPosition());
+  const G4ThreeVector delta = toLocal.TransformPoint(post->GetPosition()) - start;
+  const G4int nSegments = (fSegmentLength > 0.)
+                        ? std::max(1, (G4int)std::ceil(delta.mag() / fSegmentLength)) : 1;
+
+  fSegmentSum.resize(nSegments);
+  G4double sum = 0.;
+  for (G4int i=0; i<nSegments; i++) {
+      sum += fMap->GetEfficiency(start + ((i + 0.5) / nSegments) * delta);
+      fSegmentSum[i] = sum;
+  }
+  if (sum <= 0.) return;
+
+  const G4long nPE = (G4long)CLHEP::RandBinomial::shoot(nPhotons, std::min(sum / nSegments, 1.));
+
+  const G4double preTime = pre->GetGlobalTime();
+  const G4double stepTime = post->GetGlobalTime() - preTime;
+  for (G4long pe=0; pe<nPE; pe++) {
+      G4int segment = std::upper_bound(fSegmentSum.begin(), fSegmentSum.end(), G4UniformRand() * sum)
+                    - fSegmentSum.begin();
+      segment = std::min(segment, nSegments - 1);
+      const G4double u = (segment + G4UniformRand()) / nSegments;
+      const G4double time = preTime + u * stepTime + SampleEmissionDelay()
+                          + fMap->SampleTransitTime(start + u * delta);
+      fPmtSD->AddPhotoelectron(detID, time);
+  }
+}
@@ -0,0 +1,33 @@
+#include "DET01OpticalFastSimModel.hh"
+#include "DET01OpticalResponseMap.hh"
+
+#include "G4FastTrack.hh"
+#include "G4FastStep.hh"
+#include "G4Track.hh"
+#include "G4OpticalPhoton.hh"
+
+DET01OpticalFastSimModel::DET01OpticalFastSimModel(const G4String& name, G4Region* envelope)
+ : G4VFastSimulationModel(name, envelope)
+{}
+
+DET01OpticalFastSimModel::~DET01OpticalFastSimModel()
+{}
+
+G4bool DET01OpticalFastSimModel::IsApplicable(const G4ParticleDefinition& particle)
+{
+  return &particle == G4OpticalPhoton::OpticalPhotonDefinition();
+}
+
+G4bool DET01OpticalFastSimModel::ModelTrigger(const G4FastTrack& fastTrack)
+{
+  // Only the first step, i.e. the emission point.
+  // Photons re-entering the scintillator are left alone.
+  if (fastTrack.GetPrimaryTrack()->GetCurrentStepNumber() == 1) {
+      DET01OpticalResponseMap::GetBuilder()->RecordEmission(fastTrack.GetPrimaryTrackLocalPosition());
+  }
+  return false;
+}
+
+// Never called: the trigger always declines
+void DET01OpticalFastSimModel::DoIt(const G4FastTrack&, G4FastStep&)
+{}
@@ -0,0 +1,283 @@
+#include "DET01OpticalResponseMap.hh"
+
+#include "G4Navigator.hh"
+#include "G4TransportationManager.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4TouchableHistory.hh"
+#include "G4LogicalVolume.hh"
+#include "G4AffineTransform.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <memory>
+
+namespace {
+  // Default transit-time histogram: 0.2 ns bins up to 20 ns
+  // (later photons go into the last bin)
+  const G4int    kTimeBins = 100;
+  const G4double kTimeMax  = 20.*ns;
+}
+
+DET01OpticalResponseMap* DET01OpticalResponseMap::GetBuilder()
+{
+  static G4ThreadLocal DET01OpticalResponseMap* instance = nullptr;
+  if (!instance) instance = new DET01OpticalResponseMap();
+  return instance;
+}
+
+DET01OpticalResponseMap::DET01OpticalResponseMap(const G4String& name)
+ : G4VAccumulable(name),
+   fNx(0), fNy(0), fNz(0),
+   fNt(kTimeBins),
+   fTmax(kTimeMax),
+   fNavigator(nullptr)
+{}
+
+DET01OpticalResponseMap::~DET01OpticalResponseMap()
+{
+  delete fNavigator;
+}
+
+void DET01OpticalResponseMap::SetGrid(const G4ThreeVector& lo, const G4ThreeVector& hi,
+                                      G4double voxelSize)
+{
+  fLo = lo;
+  fHi = hi;
+  fNx = std::max(1, (G4int)std::ceil((hi.x() - lo.x()) / voxelSize));
+  fNy = std::max(1, (G4int)std::ceil((hi.y() - lo.y()) / voxelSize));
+  fNz = std::max(1, (G4int)std::ceil((hi.z() - lo.z()) / voxelSize));
+
+  G4int nVoxels = fNx * fNy * fNz;
+  fEmitted.assign(nVoxels, 0.);
+  fDetected.assign(nVoxels, 0.);
+  fTimeCounts.assign(nVoxels * fNt, 0.);
+}
+
+G4double DET01OpticalResponseMap::GetVoxelSize() const
+{
+  if (!HasGrid()) return 0.;
+  return std::min({ (fHi.x() - fLo.x()) / fNx, (fHi.y() - fLo.y()) / fNy, (fHi.z() - fLo.z()) / fNz });
+}
+
+void DET01OpticalResponseMap::Merge(const G4VAccumulable& other)
+{
+  const DET01OpticalResponseMap& right = static_cast<const DET01OpticalResponseMap&>(other);
+  if (!right.HasGrid()) return;
+
+  if (!HasGrid()) {
+      fLo = right.fLo; fHi = right.fHi;
+      fNx = right.fNx; fNy = right.fNy; fNz = right.fNz;
+      fNt = right.fNt; fTmax = right.fTmax;
+      fEmitted.assign(right.fEmitted.size(), 0.);
+      fDetected.assign(right.fDetected.size(), 0.);
+      fTimeCounts.assign(right.fTimeCounts.size(), 0.);
+  }
+
+  for (size_t i=0; i<fEmitted.size(); i++) {
+      fEmitted[i]  += right.fEmitted[i];
+      fDetected[i] += right.fDetected[i];
+  }
+  for (size_t i=0; i<fTimeCounts.size(); i++) {
+      fTimeCounts[i] += right.fTimeCounts[i];
+  }
+}
+
+void DET01OpticalResponseMap::Reset()
+{
+  // Keep the grid, clear the counts
+  std::fill(fEmitted.begin(), fEmitted.end(), 0.);
+  std::fill(fDetected.begin(), fDetected.end(), 0.);
+  std::fill(fTimeCounts.begin(), fTimeCounts.end(), 0.);
+}
+
+G4int DET01OpticalResponseMap::VoxelIndex(const G4ThreeVector& p) const
+{
+  G4int ix = (G4int)((p.x() - fLo.x()) / (fHi.x() - fLo.x()) * fNx);
+  G4int iy = (G4int)((p.y() - fLo.y()) / (fHi.y() - fLo.y()) * fNy);
+  G4int iz = (G4int)((p.z() - fLo.z()) / (fHi.z() - fLo.z()) * fNz);
+
+  // Points on the surface belong to the outermost voxel
+  ix = std::min(std::max(ix, 0), fNx - 1);
+  iy = std::min(std::max(iy, 0), fNy - 1);
+  iz = std::min(std::max(iz, 0), fNz - 1);
+
+  return (ix * fNy + iy) * fNz + iz;
+}
+
+void DET01OpticalResponseMap::RecordEmission(const G4ThreeVector& localPos)
+{
+  if (!HasGrid()) return;
+  fEmitted[VoxelIndex(localPos)] += 1.;
+}
+
+void DET01OpticalResponseMap::RecordDetection(const G4ThreeVector& globalVertex, G4int pmtID,
+                                              G4double transitTime)
+{
+  if (!HasGrid()) return;
+
+  // Find the scintillator the photon was emitted in.
+  // A private navigator is used so the tracking navigator state is untouched.
+  // It follows the current world: /run/reinitializeGeometry deletes the old one
+  G4VPhysicalVolume* world = G4TransportationManager::GetTransportationManager()
+                             ->GetNavigatorForTracking()->GetWorldVolume();
+  if (!fNavigator) fNavigator = new G4Navigator();
+  if (fNavigator->GetWorldVolume() != world) fNavigator->SetWorldVolume(world);
+
+  G4VPhysicalVolume* pv = fNavigator->LocateGlobalPointAndSetup(globalVertex, nullptr, false, true);
+  if (!pv || pv->GetLogicalVolume()->GetName() != "Scintillator") return;
+
+  // Only the module's own PMT is parametrised (module copy number, depth 1)
+  std::unique_ptr<G4TouchableHistory> touchable(fNavigator->CreateTouchableHistory());
+  if (touchable->GetReplicaNumber(1) != pmtID) return;
+
+  G4ThreeVector localPos = fNavigator->GetGlobalToLocalTransform().TransformPoint(globalVertex);
+  RecordDetectionLocal(localPos, transitTime);
+}
+
+void DET01OpticalResponseMap::RecordDetectionLocal(const G4ThreeVector& localPos, G4double transitTime)
+{
+  G4int voxel = VoxelIndex(localPos);
+  G4int bin = std::min((G4int)(transitTime / fTmax * fNt), fNt - 1);
+  if (bin < 0) bin = 0;
+
+  fDetected[voxel] += 1.;
+  fTimeCounts[voxel * fNt + bin] += 1.;
+}
+
+G4double DET01OpticalResponseMap::GetTotalEmitted() const
+{
+  G4double sum = 0.;
+  for (auto n : fEmitted) sum += n;
+  return sum;
+}
+
+G4double DET01OpticalResponseMap::GetTotalDetected() const
+{
+  G4double sum = 0.;
+  for (auto n : fDetected) sum += n;
+  return sum;
+}
+
+G4bool DET01OpticalResponseMap::Write(const G4String& fileName) const
+{
+  std::ofstream out(fileName);
+  if (!out) {
+      G4cerr << "DET01OpticalResponseMap: cannot open " << fileName << " for writing" << G4endl;
+      return false;
+  }
+
+  // Header (lengths in mm, times in ns)
+  out << "# DET01 optical response map\n";
+  out << "grid " << fNx << " " << fNy << " " << fNz << "\n";
+  out << "lo " << fLo.x()/mm << " " << fLo.y()/mm << " " << fLo.z()/mm << "\n";
+  out << "hi " << fHi.x()/mm << " " << fHi.y()/mm << " " << fHi.z()/mm << "\n";
+  out << "time " << fNt << " " << fTmax/ns << "\n";
+
+  // One line per voxel: emitted detected t0 ... t(nt-1)
+  for (size_t v=0; v<fEmitted.size(); v++) {
+      out << fEmitted[v] << " " << fDetected[v];
+      for (G4int b=0; b<fNt; b++) out << " " << fTimeCounts[v * fNt + b];
+      out << "\n";
+  }
+
+  G4cout << "DET01OpticalResponseMap: wrote " << fileName
+         << " (" << GetTotalEmitted() << " photons emitted, "
+         << GetTotalDetected() << " detected)" << G4endl;
+  return true;
+}
+
+G4bool DET01OpticalResponseMap::Read(const G4String& fileName)
+{
+  std::ifstream in(fileName);
+  if (!in) {
+      G4cerr << "DET01OpticalResponseMap: cannot open " << fileName << G4endl;
+      return false;
+  }
+
+  std::string line;
+  std::getline(in, line); // comment
+
+  std::string key;
+  G4double x, y, z, tmax;
+  in >> key >> fNx >> fNy >> fNz;
+  in >> key >> x >> y >> z; fLo.set(x*mm, y*mm, z*mm);
+  in >> key >> x >> y >> z; fHi.set(x*mm, y*mm, z*mm);
+  in >> key >> fNt >> tmax; fTmax = tmax*ns;
+  if (!in || fNx <= 0 || fNy <= 0 || fNz <= 0 || fNt <= 0) {
+      G4cerr << "DET01OpticalResponseMap: bad header in " << fileName << G4endl;
+      fNx = fNy = fNz = 0;
+      return false;
+  }
+
+  G4int nVoxels = fNx * fNy * fNz;
+  fEmitted.assign(nVoxels, 0.);
+  fDetected.assign(nVoxels, 0.);
+  fTimeCounts.assign(nVoxels * fNt, 0.);
+  for (G4int v=0; v<nVoxels; v++) {
+      in >> fEmitted[v] >> fDetected[v];
+      for (G4int b=0; b<fNt; b++) in >> fTimeCounts[v * fNt + b];
+  }
+  if (!in) {
+      G4cerr << "DET01OpticalResponseMap: truncated map " << fileName << G4endl;
+      fNx = fNy = fNz = 0;
+      return false;
+  }
+
+  BuildSamplingTables();
+  return true;
+}
+
+void DET01OpticalResponseMap::BuildSamplingTables()
+{
+  G4int nVoxels = fNx * fNy * fNz;
+  fEfficiency.assign(nVoxels, 0.);
+  fTimeCDF.assign((nVoxels + 1) * fNt, 0.);
+
+  // Row 0: whole-module average, used for voxels without detected photons
+  G4double totalEmitted = GetTotalEmitted();
+  G4double totalDetected = GetTotalDetected();
+  G4double meanEfficiency = (totalEmitted > 0.) ? totalDetected / totalEmitted : 0.;
+
+  for (G4int v=0; v<nVoxels; v++) {
+      for (G4int b=0; b<fNt; b++) fTimeCDF[b] += fTimeCounts[v * fNt + b];
+  }
+
+  for (G4int v=0; v<nVoxels; v++) {
+      fEfficiency[v] = (fEmitted[v] > 0.) ? fDetected[v] / fEmitted[v] : meanEfficiency;
+
+      const G4double* src = (fDetected[v] > 0.) ? &fTimeCounts[v * fNt] : &fTimeCDF[0];
+      std::copy(src, src + fNt, fTimeCDF.begin() + (v + 1) * fNt);
+  }
+
+  // Turn every row into a normalised cumulative distribution
+  for (G4int row=0; row<=nVoxels; row++) {
+      G4double* cdf = &fTimeCDF[row * fNt];
+      for (G4int b=1; b<fNt; b++) cdf[b] += cdf[b-1];
+      G4double norm = cdf[fNt-1];
+      for (G4int b=0; b<fNt; b++) cdf[b] = (norm > 0.) ? cdf[b] / norm : G4double(b + 1) / fNt;
+  }
+}
+
+G4double DET01OpticalResponseMap::GetEfficiency(const G4ThreeVector& localPos) const
+{
+  if (fEfficiency.empty()) return 0.;
+  return fEfficiency[VoxelIndex(localPos)];
+}
+
+G4double DET01OpticalResponseMap::SampleTransitTime(const G4ThreeVector& localPos) const
+{
+  if (fTimeCDF.empty()) return 0.;
+
+  const G4double* cdf = &fTimeCDF[(VoxelIndex(localPos) + 1) * fNt];
+  G4double u = G4UniformRand();
+  G4int bin = std::upper_bound(cdf, cdf + fNt, u) - cdf;
+  if (bin >= fNt) bin = fNt - 1;
+
+  // Uniform within the bin
+  G4double binWidth = fTmax / fNt;
+  return (bin + G4UniformRand()) * binWidth;
+}
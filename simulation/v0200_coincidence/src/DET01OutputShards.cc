@@ -0,0 +1,27 @@
+#include "DET01OutputShards.hh"
+
+#include <algorithm>
+
+DET01OutputShards::DET01OutputShards(const G4String& name)
+ : G4VAccumulable(name)
+{}
+
+DET01OutputShards::~DET01OutputShards()
+{}
+
+void DET01OutputShards::Add(G4int threadId)
+{
+  auto it = std::lower_bound(fThreads.begin(), fThreads.end(), threadId);
+  if (it == fThreads.end() || *it != threadId) fThreads.insert(it, threadId);
+}
+
+void DET01OutputShards::Merge(const G4VAccumulable& other)
+{
+  const DET01OutputShards& right = static_cast<const DET01OutputShards&>(other);
+  for (auto threadId : right.fThreads) Add(threadId);
+}
+
+void DET01OutputShards::Reset()
+{
+  fThreads.clear();
+}
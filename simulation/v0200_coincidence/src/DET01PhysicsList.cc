@@ -1,15 +1,202 @@
 #include "DET01PhysicsList.hh"
+#include "DET01IsolatedOptics.hh"
 
 #include "QGSP_BIC_HP.hh"
 #include "G4OpticalPhysics.hh"
+#include "G4FastSimulationPhysics.hh"
+#include "G4GenericBiasingPhysics.hh"
+#include "G4GenericMessenger.hh"
+#include "G4OpticalParameters.hh"
+#include "G4ProcessManager.hh"
+#include "G4HadronicProcess.hh"
+#include "G4HadronicProcessType.hh"
+#include "G4HadronElastic.hh"
+#include "G4BinaryCascade.hh"
+#include "G4NeutronRadCapture.hh"
+#include "G4Neutron.hh"
+#include "G4Material.hh"
+#include "G4LogicalVolume.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4Exception.hh"
 
-DET01PhysicsList::DET01PhysicsList() : QGSP_BIC_HP()
+#include <set>
+#include <vector>
+
+DET01PhysicsList::DET01PhysicsList()
+ : QGSP_BIC_HP(),
+   fMessenger(nullptr),
+   fVariant("reference"),
+   fIsolateOptics(false),
+   fOpticalPhysics(nullptr),
+   fOpticalRegistered(false)
 {
   // 2. G4OpticalPhysics for scintillation and Cherenkov
-  G4OpticalPhysics* opticalPhysics = new G4OpticalPhysics();
-  RegisterPhysics(opticalPhysics);
+  fOpticalPhysics = new G4OpticalPhysics();
+  RegisterPhysics(fOpticalPhysics);
+  fOpticalRegistered = true;
+
+  // 3. Fast simulation hook for the response-map recorder (DET01OpticalFastSimModel)
+  G4FastSimulationPhysics* fastSimulationPhysics = new G4FastSimulationPhysics();
+  fastSimulationPhysics->ActivateFastSimulation("opticalphoton");
+  RegisterPhysics(fastSimulationPhysics);
+
+  // 4. Generic biasing wrappers for the deuteron (DET01BiasingOperator on the
+  //    target). Without an operator attached the wrappers act as analog.
+  G4GenericBiasingPhysics* biasingPhysics = new G4GenericBiasingPhysics();
+  biasingPhysics->Bias("deuteron");
+  RegisterPhysics(biasingPhysics);
+
+  DefineCommands();
+}
+
+void DET01PhysicsList::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/det01/physics/", "Physics list variant");
+
+  auto& variantCmd = fMessenger->DeclareProperty("variant", fVariant,
+      "reference: QGSP_BIC_HP everywhere, light: non-HP low-energy neutron models in the world region.");
+  variantCmd.SetCandidates("reference light");
+  variantCmd.SetStates(G4State_PreInit);
+  variantCmd.SetToBeBroadcasted(false);
+
+  auto& isolateCmd = fMessenger->DeclareMethod("isolateOptics", &DET01PhysicsList::SetIsolateOptics,
+      "Photon generation on its own random engine, charged stage first (two-pass runs, /det01/seeds/).");
+  isolateCmd.SetStates(G4State_PreInit);
+  isolateCmd.SetToBeBroadcasted(false);
+
+  auto& photonsCmd = fMessenger->DeclareMethod("generatePhotons", &DET01PhysicsList::SetGeneratePhotons,
+      "With isolateOptics: false skips the photon generation (same charged transport, no light).");
+  photonsCmd.SetStates(G4State_PreInit, G4State_Idle);
+  photonsCmd.SetToBeBroadcasted(false);
+}
+
+void DET01PhysicsList::SetIsolateOptics(G4bool isolate)
+{
+  fIsolateOptics = isolate;
+
+  // Photons must not be tracked in the middle of the charged stage
+  // (DET01StackingAction also holds them until the stage is done)
+  if (isolate) {
+      G4OpticalParameters::Instance()->SetScintTrackSecondariesFirst(false);
+      G4OpticalParameters::Instance()->SetCerenkovTrackSecondariesFirst(false);
+  }
+}
+
+void DET01PhysicsList::SetStackPhotons(G4bool stack)
+{
+  G4OpticalParameters::Instance()->SetScintStackPhotons(stack);
+  G4OpticalParameters::Instance()->SetCerenkovStackPhotons(stack);
+}
+
+void DET01PhysicsList::SetGeneratePhotons(G4bool generate)
+{
+  DET01IsolatedOptics::SetGeneratePhotons(generate);
+}
+
+void DET01PhysicsList::ConstructProcess()
+{
+  QGSP_BIC_HP::ConstructProcess();
+  if (fVariant == "light") UseLightNeutronModelsInWorld();
+  if (fIsolateOptics && fOpticalRegistered) IsolateOpticalProcesses();
+}
+
+// Called on every thread: the wrappers (and the optical engine) are per thread
+void DET01PhysicsList::IsolateOpticalProcesses()
+{
+  auto particleIterator = GetParticleIterator();
+  particleIterator->reset();
+  while ((*particleIterator)()) {
+      G4ProcessManager* processManager = particleIterator->value()->GetProcessManager();
+      if (!processManager) continue;
+
+      std::vector<G4VProcess*> optical;
+      G4ProcessVector* processes = processManager->GetProcessList();
+      for (size_t i=0; i<processes->size(); i++) {
+          const G4String& name = (*processes)[i]->GetProcessName();
+          if (name == "Scintillation" || name == "Cerenkov") optical.push_back((*processes)[i]);
+      }
+
+      // Same name and orderings, so the wrapper takes the process's place
+      for (auto process : optical) {
+          G4int ordAtRest = processManager->GetProcessOrdering(process, idxAtRest);
+          G4int ordAlongStep = processManager->GetProcessOrdering(process, idxAlongStep);
+          G4int ordPostStep = processManager->GetProcessOrdering(process, idxPostStep);
+          processManager->RemoveProcess(process);
+
+          auto wrapper = new DET01IsolatedOptics();
+          wrapper->RegisterProcess(process);
+          processManager->AddProcess(wrapper, ordAtRest, ordAlongStep, ordPostStep);
+      }
+  }
+}
+
+// Called on every thread (the models are per thread), after the geometry is
+// built: the volumes have their regions and all materials exist
+void DET01PhysicsList::UseLightNeutronModelsInWorld()
+{
+  // Materials of the world region only; those also used in the target or
+  // scintillator regions stay on HP
+  const G4Region* worldRegion = G4RegionStore::GetInstance()->GetRegion("DefaultRegionForTheWorld", false);
+  std::set<const G4Material*> world, other;
+  for (auto volume : *G4LogicalVolumeStore::GetInstance()) {
+      if (!volume->GetMaterial()) continue;
+      if (volume->GetRegion() == worldRegion) world.insert(volume->GetMaterial());
+      else other.insert(volume->GetMaterial());
+  }
+  for (auto material : other) world.erase(material);
+  if (world.empty()) {
+      G4Exception("DET01PhysicsList::UseLightNeutronModelsInWorld()", "DET01_1001", JustWarning,
+                  "No material of the world region only, light variant not applied.");
+      return;
+  }
+
+  G4ProcessVector* processes = G4Neutron::Definition()->GetProcessManager()->GetProcessList();
+  for (size_t i=0; i<processes->size(); i++) {
+      auto process = dynamic_cast<G4HadronicProcess*>((*processes)[i]);
+      if (!process) continue;
+
+      G4HadronicInteraction* hpModel = nullptr;
+      for (auto model : process->GetHadronicInteractionList()) {
+          if (G4StrUtil::contains(model->GetModelName(), "HP")) hpModel = model;
+      }
+      if (!hpModel) continue;
+
+      // Same energy range as the HP model (fission: none in these materials)
+      G4HadronicInteraction* lightModel = nullptr;
+      switch (process->GetProcessSubType()) {
+        case fHadronElastic:   lightModel = new G4HadronElastic(); break;
+        case fHadronInelastic: lightModel = new G4BinaryCascade(); break;
+        case fCapture:         lightModel = new G4NeutronRadCapture(); break;
+        default: break;
+      }
+      if (!lightModel) continue;
+      lightModel->SetMinEnergy(hpModel->GetMinEnergy());
+      lightModel->SetMaxEnergy(hpModel->GetMaxEnergy());
+
+      // A blocked model has an empty energy range for the material
+      for (auto material : *G4Material::GetMaterialTable()) {
+          if (world.count(material)) hpModel->DeActivateFor(material);
+          else lightModel->DeActivateFor(material);
+      }
+      process->RegisterMe(lightModel);
+  }
 }
 
 DET01PhysicsList::~DET01PhysicsList()
 {
+  // Owned by the list only while registered
+  if (!fOpticalRegistered) delete fOpticalPhysics;
+  delete fMessenger;
+}
+
+// PreInit only: the constructor table is fixed at /run/initialize
+void DET01PhysicsList::SetOpticalPhysics(G4bool enable)
+{
+  if (enable == fOpticalRegistered) return;
+
+  if (enable) RegisterPhysics(fOpticalPhysics);
+  else RemovePhysics(fOpticalPhysics);
+  fOpticalRegistered = enable;
 }
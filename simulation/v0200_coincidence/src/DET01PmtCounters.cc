@@ -0,0 +1,125 @@
+#include "DET01PmtCounters.hh"
+
+#include "G4ios.hh"
+
+#include <algorithm>
+#include <iomanip>
+
+DET01PmtCounters* DET01PmtCounters::GetInstance()
+{
+  static G4ThreadLocal DET01PmtCounters* instance = nullptr;
+  if (!instance) instance = new DET01PmtCounters();
+  return instance;
+}
+
+DET01PmtCounters::DET01PmtCounters(const G4String& name)
+ : G4VAccumulable(name),
+   fNEvents(0),
+   fNZeroEvents(0)
+{}
+
+DET01PmtCounters::~DET01PmtCounters()
+{}
+
+void DET01PmtCounters::Resize(size_t nPmts)
+{
+  // The layout (and so the PMT count) only changes between runs
+  if (fTotalPE.size() == nPmts) return;
+  fTotalPE.assign(nPmts, 0.);
+  fMaxPE.assign(nPmts, 0);
+  fZeroPE.assign(nPmts, 0);
+}
+
+void DET01PmtCounters::Fill(const std::vector<G4int>& pePerPmt)
+{
+  Resize(pePerPmt.size());
+
+  G4bool anyPE = false;
+  for (size_t i=0; i<pePerPmt.size(); i++) {
+      G4int pe = pePerPmt[i];
+      fTotalPE[i] += pe;
+      if (pe > fMaxPE[i]) fMaxPE[i] = pe;
+      if (pe == 0) fZeroPE[i]++;
+      else anyPE = true;
+  }
+
+  fNEvents++;
+  if (!anyPE) fNZeroEvents++;
+}
+
+void DET01PmtCounters::Merge(const G4VAccumulable& other)
+{
+  const DET01PmtCounters& right = static_cast<const DET01PmtCounters&>(other);
+  if (right.fNEvents == 0) return;   // idle worker: nothing sized, nothing to add
+  Resize(right.fTotalPE.size());
+
+  for (size_t i=0; i<right.fTotalPE.size(); i++) {
+      fTotalPE[i] += right.fTotalPE[i];
+      fMaxPE[i] = std::max(fMaxPE[i], right.fMaxPE[i]);
+      fZeroPE[i] += right.fZeroPE[i];
+  }
+  fNEvents += right.fNEvents;
+  fNZeroEvents += right.fNZeroEvents;
+}
+
+void DET01PmtCounters::Reset()
+{
+  fNEvents = 0;
+  fNZeroEvents = 0;
+  // Sized again by the first event of the run: a previous, larger layout
+  // leaves no rows behind
+  fTotalPE.clear();
+  fMaxPE.clear();
+  fZeroPE.clear();
+}
+
+void DET01PmtCounters::Print() const
+{
+  if (fNEvents == 0) return;
+
+  std::streamsize prec = G4cout.precision();
+  G4cout << G4endl
+         << "--------------------- PMT Summary ---------------------" << G4endl
+         << " Events: " << fNEvents
+         << ", without any PE: " << fNZeroEvents << G4endl;
+  for (size_t i=0; i<fTotalPE.size(); i++) {
+      G4cout << " DET_" << i
+             << ": total " << std::setprecision(10) << fTotalPE[i]
+             << " PE, mean " << std::setprecision(4) << fTotalPE[i] / fNEvents
+             << " /event, max " << fMaxPE[i]
+             << ", zero-PE events " << fZeroPE[i] << G4endl;
+  }
+  G4cout << "-------------------------------------------------------" << G4endl;
+  G4cout.precision(prec);
+}
+
+#ifdef DET01_USE_MPI
+void DET01PmtCounters::ReduceOverRanks(MPI_Comm comm)
+{
+  // Ranks without events may not have sized their vectors yet
+  G4long nPmts = fTotalPE.size(), maxPmts = 0;
+  MPI_Allreduce(&nPmts, &maxPmts, 1, MPI_LONG, MPI_MAX, comm);
+  Resize(maxPmts);
+
+  G4int rank = 0;
+  MPI_Comm_rank(comm, &rank);
+  const G4int n = maxPmts;
+
+  std::vector<G4long> scalars = { fNEvents, fNZeroEvents };
+  std::vector<G4long> scalarSum(2, 0);
+  std::vector<G4double> totalSum(n, 0.);
+  std::vector<G4int> maxAll(n, 0);
+  std::vector<G4long> zeroSum(n, 0);
+  MPI_Reduce(scalars.data(), scalarSum.data(), 2, MPI_LONG, MPI_SUM, 0, comm);
+  MPI_Reduce(fTotalPE.data(), totalSum.data(), n, MPI_DOUBLE, MPI_SUM, 0, comm);
+  MPI_Reduce(fMaxPE.data(), maxAll.data(), n, MPI_INT, MPI_MAX, 0, comm);
+  MPI_Reduce(fZeroPE.data(), zeroSum.data(), n, MPI_LONG, MPI_SUM, 0, comm);
+
+  if (rank != 0) return;
+  fNEvents = scalarSum[0];
+  fNZeroEvents = scalarSum[1];
+  fTotalPE.swap(totalSum);
+  fMaxPE.swap(maxAll);
+  fZeroPE.swap(zeroSum);
+}
+#endif
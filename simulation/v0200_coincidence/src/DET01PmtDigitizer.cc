@@ -0,0 +1,110 @@
+#include "DET01PmtDigitizer.hh"
+#include "DET01PmtResponse.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Exception.hh"
+#include "Randomize.hh"
+
+DET01PmtDigitizer::DET01PmtDigitizer()
+ : fMessenger(nullptr),
+   fGain(4.),
+   fGainSpread(0.4),
+   fTTS(0.35*ns),
+   fNoise(0.5),
+   fRiseTime(1.0*ns), fFallTime(3.5*ns),
+   fSamplePeriod(0.2*ns),
+   fNSamples(1024),
+   fPreTrigger(20.*ns),
+   fCfdFraction(0.3),
+   fCfdDelay(1.0*ns),
+   fThreshold(5.),
+   fBaselineTime(10.*ns),
+   fDirty(true),
+   fResponse(nullptr)
+{
+  DefineCommands();
+}
+
+DET01PmtDigitizer::~DET01PmtDigitizer()
+{
+  delete fMessenger;
+  delete fResponse;
+}
+
+void DET01PmtDigitizer::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/det01/digi/", "PMT waveform digitizer");
+
+  // The response rebuilds at the next event
+  fMessenger->DeclareMethod("gain", &DET01PmtDigitizer::SetGain,
+      "Mean single-PE amplitude [mV].");
+  fMessenger->DeclareMethod("gainSpread", &DET01PmtDigitizer::SetGainSpread,
+      "Relative sigma of the single-PE amplitude.");
+  fMessenger->DeclareMethodWithUnit("tts", "ns", &DET01PmtDigitizer::SetTTS,
+      "Transit-time spread (sigma).");
+  fMessenger->DeclareMethod("noise", &DET01PmtDigitizer::SetNoise,
+      "White noise per sample, rms [mV].");
+  fMessenger->DeclareMethodWithUnit("riseTime", "ns", &DET01PmtDigitizer::SetRiseTime,
+      "Rise constant of the bi-exponential single-PE template.");
+  fMessenger->DeclareMethodWithUnit("fallTime", "ns", &DET01PmtDigitizer::SetFallTime,
+      "Fall constant of the bi-exponential single-PE template.");
+  fMessenger->DeclareMethod("templateFile", &DET01PmtDigitizer::SetTemplateFile,
+      "Measured single-PE template (one sample per line at samplePeriod); empty: bi-exponential.");
+  fMessenger->DeclareMethodWithUnit("samplePeriod", "ns", &DET01PmtDigitizer::SetSamplePeriod,
+      "Digitizer sample period.");
+  fMessenger->DeclareMethod("samples", &DET01PmtDigitizer::SetNSamples,
+      "Samples per waveform.");
+  fMessenger->DeclareMethod("cfdFraction", &DET01PmtDigitizer::SetCfdFraction,
+      "CFD fraction.");
+  fMessenger->DeclareMethodWithUnit("cfdDelay", "ns", &DET01PmtDigitizer::SetCfdDelay,
+      "CFD delay.");
+  fMessenger->DeclareMethod("threshold", &DET01PmtDigitizer::SetThreshold,
+      "CFD arming threshold above baseline [mV].");
+  fMessenger->DeclareMethodWithUnit("baselineTime", "ns", &DET01PmtDigitizer::SetBaselineTime,
+      "Leading part of the waveform used for the baseline.");
+
+  fMessenger->DeclarePropertyWithUnit("preTrigger", "ns", fPreTrigger,
+      "Window start before the earliest photoelectron of the event.");
+}
+
+void DET01PmtDigitizer::Build()
+{
+  // Response model in ns (amplitudes are in mV throughout)
+  DET01PmtResponse::Settings settings;
+  settings.gain = fGain;
+  settings.gainSpread = fGainSpread;
+  settings.tts = fTTS / ns;
+  settings.noise = fNoise;
+  settings.riseTime = fRiseTime / ns;
+  settings.fallTime = fFallTime / ns;
+  settings.templateFile = fTemplateFile;
+  settings.samplePeriod = fSamplePeriod / ns;
+  settings.samples = fNSamples;
+  settings.preTrigger = fPreTrigger / ns;
+  settings.cfdFraction = fCfdFraction;
+  settings.cfdDelay = fCfdDelay / ns;
+  settings.threshold = fThreshold;
+  settings.baselineTime = fBaselineTime / ns;
+
+  std::vector<float> pulseTemplate = DET01PmtResponse::BuildTemplate(settings);
+  if (pulseTemplate.empty()) {
+      G4Exception("DET01PmtDigitizer::Build()", "DET01_501", FatalException,
+                  ("Cannot read single-PE template " + fTemplateFile).c_str());
+  }
+
+  delete fResponse;
+  fResponse = new DET01PmtResponse(settings, pulseTemplate);
+  fDirty = false;
+}
+
+void DET01PmtDigitizer::Digitize(const std::vector<G4double>& peTimes, G4double windowStart,
+                                 G4double& amplitude, G4double& time)
+{
+  if (fDirty) Build();
+
+  auto gauss = []() { return G4RandGauss::shoot(); };
+  DET01Waveform::Pulse pulse = fResponse->Digitize(peTimes.data(), peTimes.size(), windowStart / ns, gauss);
+  amplitude = pulse.amplitude;
+  time = (pulse.time >= 0.f) ? pulse.time * ns : -1.;
+}
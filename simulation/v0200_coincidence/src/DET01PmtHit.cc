@@ -0,0 +1,59 @@
+#include "DET01PmtHit.hh"
+#include "G4SystemOfUnits.hh"
+
+G4ThreadLocal G4Allocator<DET01PmtHit>* DET01PmtHitAllocator = 0;
+
+DET01PmtHit::DET01PmtHit()
+ : G4VHit(),
+   fDetID(-1),
+   fNPE(0),
+   fFirstTime(DBL_MAX),
+   fTimeBinWidth(0.),
+   fKeepTimes(false)
+{}
+
+DET01PmtHit::DET01PmtHit(const DET01PmtHit& right)
+ : G4VHit()
+{
+  fDetID = right.fDetID;
+  fNPE = right.fNPE;
+  fFirstTime = right.fFirstTime;
+  fTimeBinWidth = right.fTimeBinWidth;
+  fTimeHist = right.fTimeHist;
+  fKeepTimes = right.fKeepTimes;
+  fTimes = right.fTimes;
+}
+
+DET01PmtHit::~DET01PmtHit() {}
+
+const DET01PmtHit& DET01PmtHit::operator=(const DET01PmtHit& right)
+{
+  fDetID = right.fDetID;
+  fNPE = right.fNPE;
+  fFirstTime = right.fFirstTime;
+  fTimeBinWidth = right.fTimeBinWidth;
+  fTimeHist = right.fTimeHist;
+  fKeepTimes = right.fKeepTimes;
+  fTimes = right.fTimes;
+
+  return *this;
+}
+
+G4bool DET01PmtHit::operator==(const DET01PmtHit& right) const
+{
+  return (this==&right) ? true : false;
+}
+
+void DET01PmtHit::SetTimeBinning(G4int nBins, G4double binWidth)
+{
+  fTimeBinWidth = binWidth;
+  fTimeHist.assign(nBins > 0 ? nBins : 0, 0);
+}
+
+void DET01PmtHit::Draw() {}
+
+void DET01PmtHit::Print()
+{
+  G4cout << "  PMT " << fDetID << ": " << fNPE << " PE, first at "
+         << ((fNPE > 0) ? fFirstTime/ns : -1.) << " ns" << G4endl;
+}
@@ -1,24 +1,102 @@
 #include "DET01PrimaryGeneratorAction.hh"
+#include "DET01ScatteringSampler.hh"
+#include "DET01CosmicGenerator.hh"
+#include "DET01RunAction.hh"
+#include "DET01EventSeeds.hh"
 
 #include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
 #include "G4GeneralParticleSource.hh"
+#include "G4ParticleGun.hh"
 #include "G4ParticleTable.hh"
 #include "G4ParticleDefinition.hh"
+#include "G4Deuteron.hh"
+#include "G4GenericMessenger.hh"
 #include "G4SystemOfUnits.hh"
 
-DET01PrimaryGeneratorAction::DET01PrimaryGeneratorAction()
+#include <cmath>
+
+DET01PrimaryGeneratorAction::DET01PrimaryGeneratorAction(DET01RunAction* runAction)
  : G4VUserPrimaryGeneratorAction(),
-   fParticleGun(0)
+   fParticleGun(0),
+   fScatterGun(0),
+   fSampler(0),
+   fCosmicGun(0),
+   fCosmic(0),
+   fRunAction(runAction),
+   fMessenger(0),
+   fMode("gps")
 {
   fParticleGun = new G4GeneralParticleSource();
+
+  fScatterGun = new G4ParticleGun(1);
+  fScatterGun->SetParticleDefinition(G4Deuteron::Definition());
+  fSampler = new DET01ScatteringSampler();
+
+  fCosmicGun = new G4ParticleGun(1);
+  fCosmic = new DET01CosmicGenerator();
+
+  DefineCommands();
 }
 
 DET01PrimaryGeneratorAction::~DET01PrimaryGeneratorAction()
 {
+  delete fMessenger;
+  delete fCosmic;
+  delete fCosmicGun;
+  delete fSampler;
+  delete fScatterGun;
   delete fParticleGun;
 }
 
+void DET01PrimaryGeneratorAction::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/det01/gun/", "Primary generator");
+
+  fMessenger->DeclareProperty("mode", fMode,
+      "gps: /gps/ source, scatter: d-p elastic deuterons (/det01/scatter/), cosmic: muons (/det01/cosmic/).")
+      .SetCandidates("gps scatter cosmic");
+
+  fMessenger->DeclarePropertyWithUnit("vertex", "cm", fVertex,
+      "Scattering vertex (target position) in scatter mode.");
+}
+
 void DET01PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
 {
-  fParticleGun->GeneratePrimaryVertex(anEvent);
+  // Per-event seeds / replayed event (/det01/seeds/), before any random number
+  DET01EventSeeds::GetInstance()->BeginEvent(anEvent);
+
+  if (fMode == "cosmic") {
+      G4ParticleDefinition* particle;
+      G4ThreeVector position, direction;
+      G4double kineticEnergy;
+      fCosmic->Sample(particle, position, direction, kineticEnergy);
+
+      fCosmicGun->SetParticleDefinition(particle);
+      fCosmicGun->SetParticlePosition(position);
+      fCosmicGun->SetParticleMomentumDirection(direction);
+      fCosmicGun->SetParticleEnergy(kineticEnergy);
+      fCosmicGun->GeneratePrimaryVertex(anEvent);
+
+      fRunAction->AddLiveTime(1. / fCosmic->GetRate());
+      return;
+  }
+
+  if (fMode != "scatter") {
+      fParticleGun->GeneratePrimaryVertex(anEvent);
+      return;
+  }
+
+  G4double theta, phi, kineticEnergy;
+  fSampler->SetVertex(fVertex);
+  fSampler->Sample(theta, phi, kineticEnergy);
+
+  fScatterGun->SetParticlePosition(fVertex);
+  fScatterGun->SetParticleMomentumDirection(
+      G4ThreeVector(std::sin(theta)*std::cos(phi), std::sin(theta)*std::sin(phi), std::cos(theta)));
+  fScatterGun->SetParticleEnergy(kineticEnergy);
+  fScatterGun->GeneratePrimaryVertex(anEvent);
+
+  // Acceptance-restricted sampling: weight = fraction of the full distribution
+  anEvent->GetPrimaryVertex(0)->SetWeight(fSampler->GetWeight());
 }
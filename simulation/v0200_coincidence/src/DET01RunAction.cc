@@ -2,73 +2,308 @@
 #include "G4Run.hh"
 #include "G4RunManager.hh"
 #include "G4AnalysisManager.hh"
+#include "G4AccumulableManager.hh"
+#include "G4GenericMessenger.hh"
+#include "G4UImanager.hh"
+#include "G4Threading.hh"
 #include "G4SystemOfUnits.hh"
+#include "G4UnitsTable.hh"
+#include "G4SDManager.hh"
+#include "DET01DetectorConstruction.hh"
+#include "DET01EventData.hh"
+#include "DET01OpticalResponseMap.hh"
+#include "DET01PmtCounters.hh"
+#include "DET01AsymmetryCounters.hh"
+#include "DET01StepProfile.hh"
+#include "DET01Trigger.hh"
+#include "DET01Checkpoint.hh"
+#include "DET01EventSeeds.hh"
+#include "DET01Telemetry.hh"
+#include "DET01SensitiveDetector.hh"
+
+#include <algorithm>
+#include <fstream>
+
+#ifdef DET01_USE_MPI
+#include "G4MPImanager.hh"
+#include <mpi.h>
+#endif
 
 DET01RunAction::DET01RunAction()
- : G4UserRunAction()
+ : G4UserRunAction(),
+   fMessenger(nullptr),
+   fCheckpoint(nullptr),
+   fTelemetry(nullptr),
+   fTrigger(new DET01Trigger()),
+   fNAccepted("NTriggerAccepted", 0),
+   fNRejected("NTriggerRejected", 0),
+   fLiveTime("CosmicLiveTime", 0.),
+   fShards("OutputShards"),
+   fNtupleName("CosmicData"),
+   fPrecision("double"),
+   fWritePositions(false),
+   fWriteEvents(true),
+   fStreaming(false),
+   fBasketSize(32000),
+   fPhotonTimes(false),
+#ifdef DET01_USE_MPI
+   fMpiMessenger(nullptr),
+   fRankRan(false),
+#endif
+   fBooked(false),
+   fUseFloat(false),
+   fNtupleId(0),
+   fNDetectors(0),
+   fColEventID(0), fColEdep(0), fColPE(0), fColTime(0), fColTruthZ(0), fColWeight(0),
+   fColAmp(-1),
+   fColSeed(-1),
+   fDigitized(false),
+   fColDigiAmp(-1), fColDigiTime(-1)
 {
   // Get analysis manager
   auto analysisManager = G4AnalysisManager::Instance();
   analysisManager->SetDefaultFileType("root"); 
   analysisManager->SetVerboseLevel(1);
-  analysisManager->SetNtupleMerging(true);
-
-  // Creating Ntuple
-  analysisManager->CreateNtuple("CosmicData", "Cosmic Ray Events");
-  analysisManager->CreateNtupleIColumn("EventID");      // ID 0
-  analysisManager->CreateNtupleDColumn("Edep_Scin0");   // ID 1
-  analysisManager->CreateNtupleDColumn("Edep_Scin1");   // ID 2
-  analysisManager->CreateNtupleDColumn("Edep_Scin2");   // ID 3
-  analysisManager->CreateNtupleDColumn("Edep_Scin3");   // ID 4
-  analysisManager->CreateNtupleIColumn("PE_PMT0");      // ID 5
-  analysisManager->CreateNtupleIColumn("PE_PMT1");      // ID 6
-  analysisManager->CreateNtupleIColumn("PE_PMT2");      // ID 7
-  analysisManager->CreateNtupleIColumn("PE_PMT3");      // ID 8
-  analysisManager->CreateNtupleDColumn("Time_PMT0");    // ID 9
-  analysisManager->CreateNtupleDColumn("Time_PMT1");    // ID 10
-  analysisManager->CreateNtupleDColumn("Time_PMT2");    // ID 11
-  analysisManager->CreateNtupleDColumn("Time_PMT3");    // ID 12
-
-  // Position Data (Primary Muon)
-  // Scin0
-  analysisManager->CreateNtupleDColumn("Scin0_InX");    // ID 13
-  analysisManager->CreateNtupleDColumn("Scin0_InY");    // ID 14
-  analysisManager->CreateNtupleDColumn("Scin0_InZ");    // ID 15
-  analysisManager->CreateNtupleDColumn("Scin0_OutX");   // ID 16
-  analysisManager->CreateNtupleDColumn("Scin0_OutY");   // ID 17
-  analysisManager->CreateNtupleDColumn("Scin0_OutZ");   // ID 18
-  // Scin1
-  analysisManager->CreateNtupleDColumn("Scin1_InX");    // ID 19
-  analysisManager->CreateNtupleDColumn("Scin1_InY");    // ID 20
-  analysisManager->CreateNtupleDColumn("Scin1_InZ");    // ID 21
-  analysisManager->CreateNtupleDColumn("Scin1_OutX");   // ID 22
-  analysisManager->CreateNtupleDColumn("Scin1_OutY");   // ID 23
-  analysisManager->CreateNtupleDColumn("Scin1_OutZ");   // ID 24
-  // Scin2
-  analysisManager->CreateNtupleDColumn("Scin2_InX");    // ID 25
-  analysisManager->CreateNtupleDColumn("Scin2_InY");    // ID 26
-  analysisManager->CreateNtupleDColumn("Scin2_InZ");    // ID 27
-  analysisManager->CreateNtupleDColumn("Scin2_OutX");   // ID 28
-  analysisManager->CreateNtupleDColumn("Scin2_OutY");   // ID 29
-  analysisManager->CreateNtupleDColumn("Scin2_OutZ");   // ID 30
-  // Scin3
-  analysisManager->CreateNtupleDColumn("Scin3_InX");    // ID 31
-  analysisManager->CreateNtupleDColumn("Scin3_InY");    // ID 32
-  analysisManager->CreateNtupleDColumn("Scin3_InZ");    // ID 33
-  analysisManager->CreateNtupleDColumn("Scin3_OutX");   // ID 34
-  analysisManager->CreateNtupleDColumn("Scin3_OutY");   // ID 35
-  analysisManager->CreateNtupleDColumn("Scin3_OutZ");   // ID 36
-
-  analysisManager->CreateNtupleDColumn("Truth_Z");      // ID 37
-  analysisManager->FinishNtuple();
+
+  // Run-level accumulables
+  auto accumulableManager = G4AccumulableManager::Instance();
+  accumulableManager->RegisterAccumulable(fNAccepted);
+  accumulableManager->RegisterAccumulable(fNRejected);
+  accumulableManager->RegisterAccumulable(fLiveTime);
+  accumulableManager->RegisterAccumulable(fShards);
+  accumulableManager->RegisterAccumulable(DET01PmtCounters::GetInstance());
+  accumulableManager->RegisterAccumulable(DET01AsymmetryCounters::GetInstance());
+  accumulableManager->RegisterAccumulable(DET01StepProfile::GetInstance());
+  accumulableManager->RegisterAccumulable(DET01EventSeeds::GetInstance());
+  // Optical response map (only filled in buildMap optics mode)
+  accumulableManager->RegisterAccumulable(DET01OpticalResponseMap::GetBuilder());
+
+  DefineCommands();
+
+  // Checkpointed runs and the telemetry reporter live on the master thread only
+  if (G4Threading::IsMasterThread()) {
+      fCheckpoint = new DET01Checkpoint();
+      fTelemetry = new DET01Telemetry();
+#ifdef DET01_USE_MPI
+      fMpiMessenger = new G4GenericMessenger(this, "/det01/mpi/", "Runs over the MPI ranks");
+      auto& beamOnCmd = fMpiMessenger->DeclareMethod("beamOn", &DET01RunAction::BeamOnRanks,
+          "Split the events over the ranks, then sum the run counters on rank 0.");
+      beamOnCmd.SetStates(G4State_Idle);
+      beamOnCmd.SetToBeBroadcasted(false);
+#endif
+  }
 }
 
 DET01RunAction::~DET01RunAction()
 {
+  delete fMessenger;
+#ifdef DET01_USE_MPI
+  delete fMpiMessenger;
+#endif
+  delete fCheckpoint;
+  delete fTelemetry;
+  delete fTrigger;
+}
+
+void DET01RunAction::CountTrigger(G4bool accepted)
+{
+  if (accepted) fNAccepted += 1;
+  else fNRejected += 1;
+}
+
+void DET01RunAction::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/det01/output/", "Event ntuple layout");
+
+  fMessenger->DeclareProperty("ntupleName", fNtupleName,
+      "Name of the event ntuple (layout changes rebook it at the next run).");
+
+  fMessenger->DeclareProperty("precision", fPrecision,
+      "Storage type of the real-valued columns.").SetCandidates("float double");
+
+  fMessenger->DeclareProperty("positions", fWritePositions,
+      "Write the primary entry/exit positions (Pos_ vector columns, hit detectors only).");
+
+  fMessenger->DeclareProperty("events", fWriteEvents,
+      "Write a row per accepted event (false: run-level summaries only, empty ntuple).");
+
+  fMessenger->DeclareProperty("digitized", fDigitized,
+      "Digitize the PMT waveforms (/det01/digi/) and write DigiAmp/DigiTime columns.");
+
+  fMessenger->DeclareProperty("photonTimes", fPhotonTimes,
+      "Write the PMT photoelectron times of every event to <name>_photons.bin (det01_replay).");
+
+  fMessenger->DeclareProperty("streaming", fStreaming,
+      "Each worker writes its own shard file instead of merging into the master.");
+
+  fMessenger->DeclareProperty("basketSize", fBasketSize,
+      "Ntuple basket size in bytes (memory per column and thread before a flush).");
+}
+
+G4int DET01RunAction::CreateRealColumn(const G4String& name)
+{
+  auto analysisManager = G4AnalysisManager::Instance();
+  return fUseFloat ? analysisManager->CreateNtupleFColumn(fNtupleId, name)
+                   : analysisManager->CreateNtupleDColumn(fNtupleId, name);
+}
+
+void DET01RunAction::FillRealColumn(G4int column, G4double value)
+{
+  auto analysisManager = G4AnalysisManager::Instance();
+  if (fUseFloat) analysisManager->FillNtupleFColumn(fNtupleId, column, value);
+  else analysisManager->FillNtupleDColumn(fNtupleId, column, value);
+}
+
+// Everything the booked columns and storage depend on
+G4String DET01RunAction::Layout(G4int nDetectors, G4bool amplitudes) const
+{
+  return fNtupleName + " " + std::to_string(nDetectors) + " " + fPrecision
+       + " amp" + std::to_string(amplitudes) + " pos" + std::to_string(fWritePositions)
+       + " digi" + std::to_string(fDigitized)
+       + " seeds" + std::to_string(DET01EventSeeds::GetInstance()->IsRecording())
+       + " stream" + std::to_string(fStreaming) + " basket" + std::to_string(fBasketSize);
 }
 
-void DET01RunAction::BeginOfRunAction(const G4Run*)
+void DET01RunAction::BookNtuple(G4int nDetectors, G4bool amplitudes)
 {
+  auto analysisManager = G4AnalysisManager::Instance();
+
+  fNDetectors = nDetectors;
+  fUseFloat = (fPrecision == "float");
+
+  // Merged: worker rows go to the master file. Streaming: every worker
+  // flushes full baskets to its own <name>_t<i>.root, so memory stays at
+  // about columns x basketSize per thread whatever the run length.
+  analysisManager->SetNtupleMerging(!fStreaming);
+  analysisManager->SetBasketSize(fBasketSize);
+
+  // Creating Ntuple (columns per detector are consecutive)
+  fNtupleId = analysisManager->CreateNtuple(fNtupleName, "DET01 Events");
+  fColEventID = analysisManager->CreateNtupleIColumn(fNtupleId, "EventID");
+
+  fColEdep = CreateRealColumn("Edep_Scin0");
+  for (G4int i=1; i<nDetectors; i++) CreateRealColumn("Edep_Scin" + std::to_string(i));
+
+  fColPE = analysisManager->CreateNtupleIColumn(fNtupleId, "PE_PMT0");
+  for (G4int i=1; i<nDetectors; i++) analysisManager->CreateNtupleIColumn(fNtupleId, "PE_PMT" + std::to_string(i));
+
+  fColTime = CreateRealColumn("Time_PMT0");
+  for (G4int i=1; i<nDetectors; i++) CreateRealColumn("Time_PMT" + std::to_string(i));
+
+  fColTruthZ = CreateRealColumn("Truth_Z");
+  fColWeight = analysisManager->CreateNtupleDColumn(fNtupleId, "Weight");
+
+  // Pulse heights (energy-only optics mode)
+  fColAmp = -1;
+  if (amplitudes) {
+      fColAmp = CreateRealColumn("Amp_PMT0");
+      for (G4int i=1; i<nDetectors; i++) CreateRealColumn("Amp_PMT" + std::to_string(i));
+  }
+
+  // Per-event seeds (/det01/seeds/), to regenerate single events
+  fColSeed = -1;
+  if (DET01EventSeeds::GetInstance()->IsRecording()) {
+      fColSeed = analysisManager->CreateNtupleIColumn(fNtupleId, "Seed0");
+      analysisManager->CreateNtupleIColumn(fNtupleId, "Seed1");
+  }
+
+  // Digitized PMT pulses: CFD amplitude [mV] and time
+  fColDigiAmp = fColDigiTime = -1;
+  if (fDigitized) {
+      fColDigiAmp = CreateRealColumn("DigiAmp_PMT0");
+      for (G4int i=1; i<nDetectors; i++) CreateRealColumn("DigiAmp_PMT" + std::to_string(i));
+      fColDigiTime = CreateRealColumn("DigiTime_PMT0");
+      for (G4int i=1; i<nDetectors; i++) CreateRealColumn("DigiTime_PMT" + std::to_string(i));
+  }
+
+  // Position Data (Primary), only detectors the primary deposited energy in
+  if (fWritePositions) {
+      analysisManager->CreateNtupleIColumn(fNtupleId, "Pos_DetID", fPosDetID);
+      analysisManager->CreateNtupleFColumn(fNtupleId, "Pos_InX", fPosInX);
+      analysisManager->CreateNtupleFColumn(fNtupleId, "Pos_InY", fPosInY);
+      analysisManager->CreateNtupleFColumn(fNtupleId, "Pos_InZ", fPosInZ);
+      analysisManager->CreateNtupleFColumn(fNtupleId, "Pos_OutX", fPosOutX);
+      analysisManager->CreateNtupleFColumn(fNtupleId, "Pos_OutY", fPosOutY);
+      analysisManager->CreateNtupleFColumn(fNtupleId, "Pos_OutZ", fPosOutZ);
+  }
+
+  analysisManager->FinishNtuple(fNtupleId);
+  fBooked = true;
+  fBookedLayout = Layout(nDetectors, amplitudes);
+}
+
+void DET01RunAction::FillNtuple(const DET01EventData& data)
+{
+  auto analysisManager = G4AnalysisManager::Instance();
+
+  analysisManager->FillNtupleIColumn(fNtupleId, fColEventID, data.eventID);
+  for (G4int i=0; i<fNDetectors; i++) {
+      FillRealColumn(fColEdep + i, data.edep[i]);
+      analysisManager->FillNtupleIColumn(fNtupleId, fColPE + i, data.pe[i]);
+      FillRealColumn(fColTime + i, data.time[i]);
+  }
+  FillRealColumn(fColTruthZ, data.truthZ);
+  analysisManager->FillNtupleDColumn(fNtupleId, fColWeight, data.weight);
+  if (fColAmp >= 0) {
+      for (G4int i=0; i<fNDetectors; i++) FillRealColumn(fColAmp + i, data.amplitude[i]);
+  }
+  if (fColSeed >= 0) {
+      analysisManager->FillNtupleIColumn(fNtupleId, fColSeed, data.seed[0]);
+      analysisManager->FillNtupleIColumn(fNtupleId, fColSeed + 1, data.seed[1]);
+  }
+  if (fColDigiAmp >= 0) {
+      for (G4int i=0; i<fNDetectors; i++) {
+          FillRealColumn(fColDigiAmp + i, data.digiAmplitude[i]);
+          FillRealColumn(fColDigiTime + i, data.digiTime[i]);
+      }
+  }
+
+  if (fWritePositions) {
+      fPosDetID.clear();
+      fPosInX.clear(); fPosInY.clear(); fPosInZ.clear();
+      fPosOutX.clear(); fPosOutY.clear(); fPosOutZ.clear();
+      for (G4int i=0; i<fNDetectors; i++) {
+          if (!data.hasPrimary[i]) continue;
+          fPosDetID.push_back(i);
+          fPosInX.push_back(data.posIn[i].x());
+          fPosInY.push_back(data.posIn[i].y());
+          fPosInZ.push_back(data.posIn[i].z());
+          fPosOutX.push_back(data.posOut[i].x());
+          fPosOutY.push_back(data.posOut[i].y());
+          fPosOutZ.push_back(data.posOut[i].z());
+      }
+  }
+
+  analysisManager->AddNtupleRow(fNtupleId);
+}
+
+void DET01RunAction::WritePhotonTimes(G4int eventID, std::vector<std::vector<G4double>>& times)
+{
+  // Sidecar times are in ns (converted and sorted in place)
+  for (auto& pmt : times) {
+      for (auto& t : pmt) t /= ns;
+  }
+  fPhotonTimesWriter.Write(eventID, times);
+}
+
+void DET01RunAction::BeginOfRunAction(const G4Run* run)
+{
+  // Reset accumulables
+  G4AccumulableManager::Instance()->Reset();
+
+  // Book the ntuple once the geometry (detector count) is known, rebook it
+  // when the geometry (/run/reinitializeGeometry) or /det01/output/ changed it
+  const auto* detector = static_cast<const DET01DetectorConstruction*>(
+      G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  G4bool amplitudes = (detector->GetOpticsMode() == "energy");
+  if (fBooked && Layout(detector->GetNDetectors(), amplitudes) != fBookedLayout) {
+      G4AnalysisManager::Instance()->Clear();
+      fBooked = false;
+  }
+  if (!fBooked) {
+      BookNtuple(detector->GetNDetectors(), amplitudes);
+  }
+
   // Get analysis manager
   auto analysisManager = G4AnalysisManager::Instance();
 
@@ -79,7 +314,34 @@ void DET01RunAction::BeginOfRunAction(const G4Run*)
   if (fileName.empty()) {
     fileName = "DET01_Cosmic_Result";
   }
+#ifdef DET01_USE_MPI
+  // One file per rank: <name>_rank<r>.root
+  if (fileName != fRankFileName) fBaseFileName = fileName;
+  fRankFileName = RankFileName(fBaseFileName, G4MPImanager::GetManager()->GetRank());
+  fileName = fRankFileName;
+#endif
   analysisManager->OpenFile(fileName);
+  if (fStreaming && !IsMaster()) fShards.Add(G4Threading::G4GetThreadId());
+  if (fTelemetry) fTelemetry->Start(run, fileName);
+  if (!IsMaster() || !G4Threading::IsMultithreadedApplication()) DET01Telemetry::RegisterThread();
+
+  // Photon-time sidecar, one per event-processing thread
+  if (fPhotonTimes && (!IsMaster() || !G4Threading::IsMultithreadedApplication())) {
+      G4String sidecar = fileName;
+      if (G4StrUtil::ends_with(sidecar, ".root")) sidecar.erase(sidecar.size() - 5);
+      sidecar += "_photons";
+      if (!IsMaster()) sidecar += "_t" + std::to_string(G4Threading::G4GetThreadId());
+      sidecar += ".bin";
+      if (!fPhotonTimesWriter.Open(sidecar, fNDetectors, 1.*ps / ns)) {
+          G4Exception("DET01RunAction::BeginOfRunAction()", "DET01_601", JustWarning,
+                      ("Cannot open photon-time sidecar " + sidecar).c_str());
+      }
+  }
+
+  // PMT records keep every photoelectron time for the digitizer and sidecar
+  auto pmtSD = static_cast<DET01SensitiveDetector*>(
+      G4SDManager::GetSDMpointer()->FindSensitiveDetector("PmtSD", false));
+  if (pmtSD) pmtSD->SetKeepTimes(IsDigitized() || WritesPhotonTimes());
 }
 
 void DET01RunAction::EndOfRunAction(const G4Run*)
@@ -90,4 +352,163 @@ void DET01RunAction::EndOfRunAction(const G4Run*)
   // Write and close
   analysisManager->Write();
   analysisManager->CloseFile();
+  fPhotonTimesWriter.Close();
+  // Final sample with the closed files (master: all workers are done)
+  if (fTelemetry) fTelemetry->Stop();
+
+  // Merge worker accumulables into the master
+  G4AccumulableManager::Instance()->Merge();
+
+  if (!IsMaster()) return;
+
+  // Selected events of a first pass (one list per MPI rank)
+#ifdef DET01_USE_MPI
+  DET01EventSeeds::GetInstance()->WriteSelection("_rank" + std::to_string(G4MPImanager::GetManager()->GetRank()));
+
+  // Summary after the reduction over the ranks, BeamOnRanks()
+  fRankRan = true;
+#else
+  DET01EventSeeds::GetInstance()->WriteSelection();
+  PrintRunSummary();
+#endif
+}
+
+// Master: end of run, or rank 0 once the ranks are reduced (MPI)
+void DET01RunAction::PrintRunSummary()
+{
+  auto analysisManager = G4AnalysisManager::Instance();
+
+  // Run summary
+  if (fTrigger->IsEnabled()) {
+      G4long nTotal = fNAccepted.GetValue() + fNRejected.GetValue();
+      G4cout << G4endl
+             << " Trigger: " << fNAccepted.GetValue() << " / " << nTotal
+             << " events accepted, " << fNRejected.GetValue() << " rejected" << G4endl;
+  }
+  if (fLiveTime.GetValue() > 0.) {
+      G4cout << " Cosmic live time: " << G4BestUnit(fLiveTime.GetValue(), "Time")
+             << " (" << fLiveTime.GetValue() / s << " s)" << G4endl;
+  }
+  if (fStreaming) WriteShardIndex();
+  DET01PmtCounters::GetInstance()->Print();
+  DET01StepProfile::GetInstance()->Print();
+
+  // Optical response map (buildMap mode)
+  const auto* detector = static_cast<const DET01DetectorConstruction*>(
+      G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  if (detector && detector->GetOpticsMode() == "buildMap") {
+      DET01OpticalResponseMap::GetBuilder()->Write(detector->GetResponseMapFile());
+  }
+
+  // Online azimuthal asymmetry (ring layout)
+  G4String outputName = analysisManager->GetFileName();
+#ifdef DET01_USE_MPI
+  outputName = fBaseFileName;
+#endif
+  if (detector) DET01AsymmetryCounters::GetInstance()->Report(detector, outputName);
+}
+
+// Streaming mode: <name>_shards.txt lists the worker files of the run.
+// Only the workers that opened their file in this run (fShards): in tasking
+// mode a thread without events does not, and its _t<i> file, if any, is
+// left over from an earlier run.
+void DET01RunAction::WriteShardIndex() const
+{
+  G4String base = G4AnalysisManager::Instance()->GetFileName();
+  if (G4StrUtil::ends_with(base, ".root")) base.erase(base.size() - 5);
+
+  G4RunManager* runManager = G4RunManager::GetRunManager();
+  G4int nThreads = (runManager->GetRunManagerType() == G4RunManager::sequentialRM)
+                 ? 0 : runManager->GetNumberOfThreads();
+
+  std::vector<G4String> shards;
+  if (nThreads == 0) shards.push_back(base + ".root");
+  else {
+      for (auto threadId : fShards.GetThreads()) {
+          shards.push_back(base + "_t" + std::to_string(threadId) + ".root");
+      }
+  }
+
+  std::ofstream index(base + "_shards.txt");
+  for (const auto& shard : shards) index << shard << "\n";
+  const G4int nListed = shards.size();
+
+  G4cout << " Output: " << nListed << " shard(s) listed in "
+         << base << "_shards.txt" << G4endl;
+}
+
+#ifdef DET01_USE_MPI
+// <name>[.root] -> <name>_rank<r>.root
+G4String DET01RunAction::RankFileName(const G4String& fileName, G4int rank)
+{
+  G4String base = fileName;
+  if (G4StrUtil::ends_with(base, ".root")) base.erase(base.size() - 5);
+  return base + "_rank" + std::to_string(rank) + ".root";
+}
+
+// /det01/mpi/beamOn, every rank: its share of the events (possibly none,
+// then Geant4 does not call the run actions), then the reduction. The
+// collectives are outside the run so that every rank reaches them.
+void DET01RunAction::BeamOnRanks(G4int nEvents)
+{
+  G4MPImanager* mpi = G4MPImanager::GetManager();
+  const G4int rank = mpi->GetRank();
+  const G4int size = mpi->GetSize();
+  const G4int share = nEvents / size + ((rank < nEvents % size) ? 1 : 0);
+  const G4int first = rank * (nEvents / size) + std::min(rank, nEvents % size);
+
+  // A rank without a run must not sum the counters of its previous one
+  G4AccumulableManager::Instance()->Reset();
+  fRankRan = false;
+  if (share > 0) {
+      // EventIDs first .. first + share - 1 (per-event seeds and selection lists)
+      G4UImanager::GetUIpointer()->ApplyCommand("/det01/seeds/eventOffset " + std::to_string(first));
+      G4RunManager::GetRunManager()->BeamOn(share);
+  }
+
+  if (ReduceOverRanks()) PrintRunSummary();
+}
+
+// Collective: the master thread of every rank, after its run
+G4bool DET01RunAction::ReduceOverRanks()
+{
+  G4MPImanager* mpi = G4MPImanager::GetManager();
+  const G4int rank = mpi->GetRank();
+  const G4int size = mpi->GetSize();
+
+  // Ranks that ran (and wrote an output file)
+  G4int ran = fRankRan ? 1 : 0;
+  std::vector<G4int> ranks(size, 0);
+  MPI_Gather(&ran, 1, MPI_INT, ranks.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+  G4long counts[2] = { fNAccepted.GetValue(), fNRejected.GetValue() };
+  G4long totalCounts[2] = { 0, 0 };
+  MPI_Reduce(counts, totalCounts, 2, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+  G4double liveTime = fLiveTime.GetValue(), totalLiveTime = 0.;
+  MPI_Reduce(&liveTime, &totalLiveTime, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+  DET01PmtCounters::GetInstance()->ReduceOverRanks(MPI_COMM_WORLD);
+  DET01AsymmetryCounters::GetInstance()->ReduceOverRanks(MPI_COMM_WORLD);
+
+  if (rank != 0) return false;
+
+  fNAccepted = totalCounts[0];
+  fNRejected = totalCounts[1];
+  fLiveTime = totalLiveTime;
+
+  // Index of the per-rank ntuple files (hadd them for a single file)
+  G4String indexName = fBaseFileName;
+  if (G4StrUtil::ends_with(indexName, ".root")) indexName.erase(indexName.size() - 5);
+  indexName += "_ranks.txt";
+  std::ofstream index(indexName);
+  G4int nFiles = 0;
+  for (G4int r=0; r<size; r++) {
+      if (!ranks[r]) continue;
+      index << RankFileName(fBaseFileName, r) << "\n";
+      nFiles++;
+  }
+
+  G4cout << G4endl << " MPI: " << nFiles << " rank output(s) of " << size
+         << " ranks listed in " << indexName << G4endl;
+  return true;
 }
+#endif
@@ -0,0 +1,279 @@
+#include "DET01ScatteringSampler.hh"
+#include "DET01DetectorConstruction.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4Deuteron.hh"
+#include "G4Proton.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Exception.hh"
+#include "G4RunManager.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+  const G4int kThetaBins = 3000;
+  const G4int kPhiBins = 3600;
+}
+
+DET01ScatteringSampler::DET01ScatteringSampler()
+ : fMessenger(nullptr),
+   fA(1.), fB(0.), fC(0.),
+   fBeamEnergy(380.*MeV),
+   fSlope(0.),
+   fAcceptance(false),
+   fDistance(0.),
+   fHalfSize(0.),
+   fDirty(true),
+   fThetaMax(pi),
+   fWeight(1.)
+{
+  DefineCommands();
+}
+
+DET01ScatteringSampler::~DET01ScatteringSampler()
+{
+  delete fMessenger;
+}
+
+void DET01ScatteringSampler::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/det01/scatter/", "Scattered deuteron generator");
+
+  fMessenger->DeclareMethod("A", &DET01ScatteringSampler::SetA,
+      "Constant term of f(phi) = A + B cos(phi) + C cos(2 phi).");
+  fMessenger->DeclareMethod("B", &DET01ScatteringSampler::SetB,
+      "cos(phi) coefficient of f(phi).");
+  fMessenger->DeclareMethod("C", &DET01ScatteringSampler::SetC,
+      "cos(2 phi) coefficient of f(phi).");
+
+  fMessenger->DeclareMethodWithUnit("energy", "MeV", &DET01ScatteringSampler::SetBeamEnergy,
+      "Beam deuteron kinetic energy (total, not per nucleon).");
+
+  fMessenger->DeclareMethod("slope", &DET01ScatteringSampler::SetSlope,
+      "Slope b of exp(-b|t|) in (GeV/c)^-2; 0 = isotropic in the lab.");
+
+  fMessenger->DeclareMethod("acceptance", &DET01ScatteringSampler::SetAcceptance,
+      "Only generate deuterons towards the detector faces of the ring layout (weighted events).");
+}
+
+// Follow the geometry (/run/reinitializeGeometry)
+void DET01ScatteringSampler::FollowGeometry()
+{
+  const auto* detector = static_cast<const DET01DetectorConstruction*>(
+      G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  if (!detector) return;
+  if (detector->GetDetectorRings() != fDetectorRing || detector->GetDetectorTheta() != fDetectorTheta
+      || detector->GetDetectorPhi() != fDetectorPhi || detector->GetFaceDistance() != fDistance
+      || detector->GetFaceHalfSize() != fHalfSize) {
+      fDetectorRing = detector->GetDetectorRings();
+      fDetectorTheta = detector->GetDetectorTheta();
+      fDetectorPhi = detector->GetDetectorPhi();
+      fDistance = detector->GetFaceDistance();
+      fHalfSize = detector->GetFaceHalfSize();
+      fDirty = true;
+  }
+}
+
+// Lab momentum of the deuteron scattered at theta (higher-momentum branch)
+G4double DET01ScatteringSampler::ScatteredMomentum(G4double theta) const
+{
+  const G4double m1 = G4Deuteron::Definition()->GetPDGMass();
+  const G4double m2 = G4Proton::Definition()->GetPDGMass();
+
+  G4double e1 = fBeamEnergy + m1;
+  G4double p1 = std::sqrt(fBeamEnergy * (fBeamEnergy + 2.*m1));
+  G4double eTot = e1 + m2;
+  G4double k = (eTot*eTot - p1*p1 + m1*m1 - m2*m2) / 2.;
+
+  G4double pc = p1 * std::cos(theta);
+  G4double a = eTot*eTot - pc*pc;
+  G4double disc = k*k - m1*m1 * a;
+  if (disc < 0.) return -1.;
+  return (k * pc + eTot * std::sqrt(disc)) / a;
+}
+
+void DET01ScatteringSampler::MakeCdf(std::vector<G4double>& pdf)
+{
+  // pdf (per bin) -> cdf with n+1 entries, cdf[0] = 0, cdf[n] = 1
+  std::vector<G4double> cdf(pdf.size() + 1, 0.);
+  for (size_t i=0; i<pdf.size(); i++) cdf[i+1] = cdf[i] + pdf[i];
+  if (cdf.back() > 0.) {
+      for (auto& c : cdf) c /= cdf.back();
+  }
+  pdf.swap(cdf);
+}
+
+G4double DET01ScatteringSampler::SampleCdf(const std::vector<G4double>& cdf,
+                                           G4double lo, G4double width, G4double u)
+{
+  // Piecewise-constant pdf: invert the linear cdf inside the selected bin
+  size_t i = std::upper_bound(cdf.begin(), cdf.end(), u) - cdf.begin() - 1;
+  i = std::min(i, cdf.size() - 2);
+  G4double frac = (u - cdf[i]) / (cdf[i+1] - cdf[i]);
+  return lo + (i + frac) * width;
+}
+
+void DET01ScatteringSampler::Build()
+{
+  const G4double m1 = G4Deuteron::Definition()->GetPDGMass();
+  const G4double m2 = G4Proton::Definition()->GetPDGMass();
+
+  // Kinematic limit of the deuteron lab angle (~30 deg)
+  fThetaMax = (m1 > m2) ? std::asin(m2 / m1) : pi;
+  const G4double dTheta = fThetaMax / kThetaBins;
+  const G4double dPhi = twopi / kPhiBins;
+
+  // theta factor: sin(theta) exp(-b|t|)
+  G4double e1 = fBeamEnergy + m1;
+  G4double p1 = std::sqrt(fBeamEnergy * (fBeamEnergy + 2.*m1));
+  std::vector<G4double> thetaPdf(kThetaBins, 0.);
+  for (G4int i=0; i<kThetaBins; i++) {
+      G4double theta = (i + 0.5) * dTheta;
+      G4double p3 = ScatteredMomentum(theta);
+      if (p3 < 0.) continue;
+      G4double e3 = std::sqrt(p3*p3 + m1*m1);
+      G4double t = 2.*m1*m1 - 2.*(e1*e3 - p1*p3*std::cos(theta));
+      thetaPdf[i] = std::sin(theta) * std::exp(-fSlope * std::fabs(t) / (GeV*GeV));
+  }
+
+  // phi factor: A + B cos(phi) + C cos(2 phi)
+  std::vector<G4double> phiPdf(kPhiBins, 0.);
+  G4bool negative = false;
+  for (G4int i=0; i<kPhiBins; i++) {
+      G4double phi = (i + 0.5) * dPhi;
+      G4double f = fA + fB * std::cos(phi) + fC * std::cos(2.*phi);
+      if (f < 0.) { negative = true; f = 0.; }
+      phiPdf[i] = f;
+  }
+  if (negative) {
+      G4Exception("DET01ScatteringSampler::Build()", "DET01_101", JustWarning,
+                  "f(phi) = A + B cos(phi) + C cos(2 phi) is negative somewhere, clipped to 0.");
+  }
+
+  G4double thetaTotal = 0., phiTotal = 0.;
+  for (auto f : thetaPdf) thetaTotal += f;
+  for (auto f : phiPdf) phiTotal += f;
+  if (thetaTotal <= 0. || phiTotal <= 0.) {
+      G4Exception("DET01ScatteringSampler::Build()", "DET01_102", FatalException,
+                  "Empty angular distribution.");
+      return;
+  }
+
+  // Regions: the full distribution, or one theta band x phi windows per ring
+  fRegions.clear();
+  std::vector<G4double> masses;
+  if (!fAcceptance) {
+      fRegions.push_back({thetaPdf, phiPdf});
+      masses.push_back(1.);
+  }
+  else {
+      // Window of every detector face as seen from the vertex: polar angle and
+      // azimuth of the vertex-to-face vector, half angles from its length
+      const size_t nDetectors = fDetectorRing.size();
+      std::vector<G4double> faceTheta(nDetectors), facePhi(nDetectors);
+      std::vector<G4double> halfTheta(nDetectors), halfPhi(nDetectors);
+      for (size_t copyNo=0; copyNo<nDetectors; copyNo++) {
+          G4ThreeVector face;
+          face.setRThetaPhi(fDistance, fDetectorTheta[copyNo], fDetectorPhi[copyNo]);
+          G4ThreeVector view = face - fVertex;
+          faceTheta[copyNo] = view.theta();
+          facePhi[copyNo] = view.phi();
+          halfTheta[copyNo] = std::atan(fHalfSize / view.mag());
+          halfPhi[copyNo] = std::atan(fHalfSize / view.perp());
+      }
+
+      // One region per theta band: faces with the same band (a ring seen from
+      // a vertex on the beam axis) share it with the union of their phi windows
+      std::vector<G4bool> done(nDetectors, false);
+      for (size_t first=0; first<nDetectors; first++) {
+          if (done[first]) continue;
+          std::vector<size_t> band;
+          for (size_t copyNo=first; copyNo<nDetectors; copyNo++) {
+              if (done[copyNo]) continue;
+              if (std::fabs(faceTheta[copyNo] - faceTheta[first]) > 1e-9
+                  || std::fabs(halfTheta[copyNo] - halfTheta[first]) > 1e-9) continue;
+              band.push_back(copyNo);
+              done[copyNo] = true;
+          }
+
+          Region region{thetaPdf, phiPdf};
+          G4double thetaSum = 0., phiSum = 0.;
+          for (G4int i=0; i<kThetaBins; i++) {
+              G4double theta = (i + 0.5) * dTheta;
+              if (std::fabs(theta - faceTheta[first]) > halfTheta[first]) region.thetaCdf[i] = 0.;
+              thetaSum += region.thetaCdf[i];
+          }
+          for (G4int i=0; i<kPhiBins; i++) {
+              G4double phi = (i + 0.5) * dPhi;
+              G4bool inside = false;
+              for (size_t k=0; k<band.size() && !inside; k++) {
+                  inside = std::fabs(std::remainder(phi - facePhi[band[k]], twopi)) <= halfPhi[band[k]];
+              }
+              if (!inside) region.phiCdf[i] = 0.;
+              phiSum += region.phiCdf[i];
+          }
+
+          G4double mass = (thetaSum / thetaTotal) * (phiSum / phiTotal);
+          if (mass <= 0.) continue;
+          fRegions.push_back(region);
+          masses.push_back(mass);
+      }
+      if (fRegions.empty()) {
+          G4Exception("DET01ScatteringSampler::Build()", "DET01_103", FatalException,
+                      "No detector of the ring layout (/det01/geometry/) is kinematically reachable from the vertex.");
+          return;
+      }
+  }
+
+  for (auto& region : fRegions) {
+      MakeCdf(region.thetaCdf);
+      MakeCdf(region.phiCdf);
+  }
+
+  fWeight = 0.;
+  for (auto m : masses) fWeight += m;
+  fRegionCdf = masses;
+  MakeCdf(fRegionCdf);
+
+  fDirty = false;
+}
+
+void DET01ScatteringSampler::SetVertex(const G4ThreeVector& vertex)
+{
+  if (vertex == fVertex) return;
+  fVertex = vertex;
+  if (fAcceptance) fDirty = true;
+}
+
+G4double DET01ScatteringSampler::GetWeight()
+{
+  FollowGeometry();
+  if (fDirty) Build();
+  return fWeight;
+}
+
+void DET01ScatteringSampler::Sample(G4double& theta, G4double& phi, G4double& kineticEnergy)
+{
+  FollowGeometry();
+  if (fDirty) Build();
+
+  // Three draws per event: region, theta, phi
+  G4double u[3];
+  G4Random::getTheEngine()->flatArray(3, u);
+
+  size_t r = 0;
+  if (fRegions.size() > 1) {
+      r = std::upper_bound(fRegionCdf.begin(), fRegionCdf.end(), u[0]) - fRegionCdf.begin() - 1;
+      r = std::min(r, fRegions.size() - 1);
+  }
+
+  theta = SampleCdf(fRegions[r].thetaCdf, 0., fThetaMax / kThetaBins, u[1]);
+  phi = SampleCdf(fRegions[r].phiCdf, 0., twopi / kPhiBins, u[2]);
+
+  const G4double m1 = G4Deuteron::Definition()->GetPDGMass();
+  G4double p3 = std::max(ScatteredMomentum(theta), 0.);
+  kineticEnergy = std::sqrt(p3*p3 + m1*m1) - m1;
+}
@@ -1,4 +1,6 @@
 #include "DET01ScintSD.hh"
+#include "DET01EnergyResponse.hh"
+#include "DET01OpticalDepositModel.hh"
 #include "G4HCofThisEvent.hh"
 #include "G4Step.hh"
 #include "G4ThreeVector.hh"
@@ -8,20 +10,47 @@
 #include "G4ios.hh"
 
 DET01ScintSD::DET01ScintSD(const G4String& name,
-                         const G4String& hitsCollectionName)
+                         const G4String& hitsCollectionName,
+                         G4int nDetectors)
  : G4VSensitiveDetector(name),
-   fHitsCollection(nullptr)
+   fHitsCollection(nullptr),
+   fNDetectors(nDetectors),
+   fResponse(nullptr),
+   fOpticalModel(nullptr),
+   fVisible(nDetectors, 0.)
 {
   collectionName.insert(hitsCollectionName);
 }
 
 DET01ScintSD::~DET01ScintSD()
-{}
+{
+  delete fResponse;
+  delete fOpticalModel;
+}
+
+void DET01ScintSD::SetOpticalModel(DET01OpticalDepositModel* model)
+{
+  delete fOpticalModel;
+  fOpticalModel = model;
+}
+
+void DET01ScintSD::SetEnergyResponse(DET01EnergyResponse* response)
+{
+  delete fResponse;
+  fResponse = response;
+}
 
 void DET01ScintSD::Initialize(G4HCofThisEvent* hce)
 {
-  // Create hits collection
+  // Create hits collection, one hit per detector indexed by copy number
   fHitsCollection = new DET01HitsCollection(SensitiveDetectorName, collectionName[0]);
+  for (G4int i=0; i<fNDetectors; i++) {
+      DET01Hit* hit = new DET01Hit();
+      hit->SetDetID(i);
+      fHitsCollection->insert(hit);
+  }
+
+  if (fResponse) fVisible.assign(fNDetectors, 0.);
 
   // Add this collection in hce
   G4int hcID = GetCollectionID(0);
@@ -36,32 +65,25 @@ G4bool DET01ScintSD::ProcessHits(G4Step* step, G4TouchableHistory*)
   if (edep == 0.) return false;
 
   // We are inside the Scintillator.
-  // Identify which detector (Top=0 or Bottom=1)
-  // Since we used PVPlacement with copy numbers in the loop in DetectorConstruction:
-  G4int detID = step->GetPreStepPoint()->GetTouchable()->GetCopyNumber();
-
-  // Check if we already have a hit for this detector in this event
-  // If so, add energy to it. If not, create new.
-  
-  DET01Hit* hit = nullptr;
-  
-  // Simple linear search (since only 2 detectors, it's fast)
-  for(size_t i=0; i<fHitsCollection->entries(); i++) {
-      DET01Hit* existingHit = (*fHitsCollection)[i];
-      if(existingHit->GetDetID() == detID) {
-          hit = existingHit;
-          break;
-      }
-  }
+  // Identify which detector (Top=0 or Bottom=1): copy number of the
+  // module envelope the scintillator sits in
+  G4int detID = step->GetPreStepPoint()->GetTouchable()->GetCopyNumber(1);
 
-  if(!hit) {
-      hit = new DET01Hit();
-      hit->SetDetID(detID);
-      fHitsCollection->insert(hit);
+  if (detID < 0 || detID >= fNDetectors) return false;
+
+  // Direct lookup by copy number
+  DET01Hit* hit = (*fHitsCollection)[detID];
+
+  // First deposit time (steps are not time ordered across tracks)
+  G4double time = step->GetPreStepPoint()->GetGlobalTime();
+  if (hit->GetEdep() == 0. || time < hit->GetTime()) {
+      hit->SetTime(time);
   }
 
   // Add Energy
   hit->AddEdep(edep);
+  if (fResponse) fVisible[detID] += fResponse->Quench(edep, step->GetStepLength());
+  if (fOpticalModel) fOpticalModel->Deposit(step, detID);
 
   // Track Primary Muon Position (Entry/Exit)
   if (step->GetTrack()->GetTrackID() == 1) {
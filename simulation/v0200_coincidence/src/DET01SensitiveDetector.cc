@@ -1,5 +1,8 @@
 #include "DET01SensitiveDetector.hh"
 #include "DET01Hit.hh"
+#include "DET01PmtHit.hh"
+#include "DET01OpticalResponseMap.hh"
+#include "DET01PmtCounters.hh"
 #include "G4HCofThisEvent.hh"
 #include "G4Step.hh"
 #include "G4ThreeVector.hh"
@@ -8,9 +11,17 @@
 #include "G4OpticalPhoton.hh"
 
 DET01SensitiveDetector::DET01SensitiveDetector(const G4String& name,
-                                               const G4String& hitsCollectionName)
+                                               const G4String& hitsCollectionName,
+                                               G4int nDetectors)
  : G4VSensitiveDetector(name),
-   fHitsCollection(nullptr)
+   fHitsCollection(nullptr),
+   fPmtHitsCollection(nullptr),
+   fNDetectors(nDetectors),
+   fAccumulate(true),
+   fTimeBins(0),
+   fTimeBinWidth(0.),
+   fKeepTimes(false),
+   fMapBuilder(nullptr)
 {
   collectionName.insert(hitsCollectionName);
 }
@@ -18,13 +29,34 @@ DET01SensitiveDetector::DET01SensitiveDetector(const G4String& name,
 DET01SensitiveDetector::~DET01SensitiveDetector()
 {}
 
+void DET01SensitiveDetector::SetTimeBinning(G4int nBins, G4double binWidth)
+{
+  fTimeBins = nBins;
+  fTimeBinWidth = binWidth;
+}
+
 void DET01SensitiveDetector::Initialize(G4HCofThisEvent* hce)
 {
+  G4int hcID = GetCollectionID(0);
+
+  if (fAccumulate) {
+      // One record per PMT, indexed by copy number
+      fPmtHitsCollection = new DET01PmtHitsCollection(SensitiveDetectorName, collectionName[0]);
+      for (G4int i=0; i<fNDetectors; i++) {
+          DET01PmtHit* hit = new DET01PmtHit();
+          hit->SetDetID(i);
+          if (fTimeBins > 0) hit->SetTimeBinning(fTimeBins, fTimeBinWidth);
+          hit->SetKeepTimes(fKeepTimes);
+          fPmtHitsCollection->insert(hit);
+      }
+      hce->AddHitsCollection(hcID, fPmtHitsCollection);
+      return;
+  }
+
   // Create hits collection
   fHitsCollection = new DET01HitsCollection(SensitiveDetectorName, collectionName[0]);
 
   // Add this collection in hce
-  G4int hcID = GetCollectionID(0);
   hce->AddHitsCollection(hcID, fHitsCollection);
 }
 
@@ -34,18 +66,18 @@ G4bool DET01SensitiveDetector::ProcessHits(G4Step* step, G4TouchableHistory*)
   G4ParticleDefinition* particleType = step->GetTrack()->GetDefinition();
   if(particleType != G4OpticalPhoton::OpticalPhotonDefinition()) return false;
 
-  // Create new hit
-  DET01Hit* newHit = new DET01Hit();
-  newHit->SetTime(step->GetPostStepPoint()->GetGlobalTime());
-  
   // Identify which detector was hit
-  // The Photocathode is placed into World with a specific Copy Number in Construct()
-  // 0 = Bottom (or Top depending on loop), 1 = The other one.
-  G4int detID = step->GetPreStepPoint()->GetTouchable()->GetReplicaNumber(0);
-  newHit->SetDetID(detID);
+  // The Photocathode sits in a module envelope whose copy number is the detector ID
+  G4int detID = step->GetPreStepPoint()->GetTouchable()->GetReplicaNumber(1);
 
-  // Insert hit into collection
-  fHitsCollection->insert(newHit);
+  AddPhotoelectron(detID, step->GetPostStepPoint()->GetGlobalTime());
+
+  // Response-map building: local time is the photon's transit time since emission
+  if (fMapBuilder) {
+      G4Track* track = step->GetTrack();
+      fMapBuilder->RecordDetection(track->GetVertexPosition(), detID,
+                                   step->GetPostStepPoint()->GetLocalTime());
+  }
   
   // Kill the photon
   step->GetTrack()->SetTrackStatus(fStopAndKill);
@@ -53,27 +85,53 @@ G4bool DET01SensitiveDetector::ProcessHits(G4Step* step, G4TouchableHistory*)
   return true;
 }
 
+void DET01SensitiveDetector::AddPhotoelectron(G4int detID, G4double time)
+{
+  if (fAccumulate) {
+      if (detID >= 0 && detID < fNDetectors) {
+          (*fPmtHitsCollection)[detID]->AddPhotoelectron(time);
+      }
+      return;
+  }
+
+  // One hit per photon
+  DET01Hit* newHit = new DET01Hit();
+  newHit->SetTime(time);
+  newHit->SetDetID(detID);
+  fHitsCollection->insert(newHit);
+}
+
 void DET01SensitiveDetector::EndOfEvent(G4HCofThisEvent*)
 {
-  G4int nofHits = fHitsCollection->entries();
-  if (nofHits > 0) {
-      G4int count0 = 0;
-      G4int count1 = 0;
-      G4int count2 = 0;
-      G4int count3 = 0;
-      
+  std::vector<G4int>& counts = fEventCounts;
+  counts.assign(fNDetectors, 0);
+  G4int nofHits = 0;
+
+  if (fAccumulate) {
+      for (G4int i=0; i<fNDetectors; i++) {
+          counts[i] = (*fPmtHitsCollection)[i]->GetNPE();
+          nofHits += counts[i];
+      }
+  }
+  else {
+      nofHits = fHitsCollection->entries();
       for(size_t i=0; i<fHitsCollection->GetSize(); i++) {
           DET01Hit* hit = static_cast<DET01Hit*>(fHitsCollection->GetHit(i));
           G4int id = hit->GetDetID();
-          if(id == 0) count0++;
-          else if(id == 1) count1++;
-          else if(id == 2) count2++;
-          else if(id == 3) count3++;
+          if (id >= 0 && id < fNDetectors) counts[id]++;
+      }
+  }
+
+  // Run-level counters (merged and printed by the master run action)
+  DET01PmtCounters::GetInstance()->Fill(counts);
+
+  // Per-event summary only on request (/det01/pmt/verbose 1)
+  if (verboseLevel > 0 && nofHits > 0) {
+      G4cout << "Use log: Event Summary ->";
+      for (G4int i=0; i<fNDetectors; i++) {
+          G4cout << " DET_" << i << ": " << counts[i] << " photons"
+                 << ((i < fNDetectors - 1) ? "," : ".");
       }
-      
-      G4cout << "Use log: Event Summary -> DET_0: " << count0 
-             << " photons, DET_1: " << count1 
-             << " photons, DET_2: " << count2 
-             << " photons, DET_3: " << count3 << " photons." << G4endl;
+      G4cout << G4endl;
   }
 }
@@ -0,0 +1,100 @@
+#include "DET01StackingAction.hh"
+#include "DET01RunAction.hh"
+#include "DET01Trigger.hh"
+#include "DET01IsolatedOptics.hh"
+#include "DET01Telemetry.hh"
+#include "G4EventManager.hh"
+#include "G4Event.hh"
+#include "G4HCofThisEvent.hh"
+#include "G4SDManager.hh"
+#include "G4StackManager.hh"
+#include "G4Track.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4GenericMessenger.hh"
+
+DET01StackingAction::DET01StackingAction(DET01RunAction* runAction)
+ : G4UserStackingAction(),
+   fRunAction(runAction),
+   fMessenger(nullptr),
+   fDeferOptical(false),
+   fReleased(false),
+   fIsolated(false),
+   fScintHCID(-1)
+{
+  DefineCommands();
+}
+
+DET01StackingAction::~DET01StackingAction()
+{
+  delete fMessenger;
+}
+
+void DET01StackingAction::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/det01/stack/", "Track stacking");
+
+  fMessenger->DeclareProperty("deferOptical", fDeferOptical,
+      "Track optical photons only after the event passed /det01/trigger/.");
+}
+
+G4ClassificationOfNewTrack DET01StackingAction::ClassifyNewTrack(const G4Track* track)
+{
+  const G4bool photon = track->GetDefinition() == G4OpticalPhoton::OpticalPhotonDefinition();
+
+  // Photons made (reclassified ones come after the release and are not recounted)
+  if (photon && !fReleased) DET01Telemetry::CountPhoton();
+
+  if (fReleased || !(fDeferOptical || fIsolated)) return fUrgent;
+
+  // Hold optical photons until the charged tracks have deposited their energy
+  if (photon) return fWaiting;
+
+  return fUrgent;
+}
+
+void DET01StackingAction::NewStage()
+{
+  if (fReleased) return;
+  if (!fDeferOptical) {
+      // Isolated optics: the photons only wait for the end of the charged stage
+      if (fIsolated) {
+          fReleased = true;
+          stackManager->ReClassify();
+      }
+      return;
+  }
+  fReleased = true;
+
+  // Deposits so far, indexed by copy number (one DET01Hit per scintillator)
+  if (fScintHCID == -1) {
+      fScintHCID = G4SDManager::GetSDMpointer()->GetCollectionID("ScintSD/ScintHitsCollection");
+  }
+
+  const G4int nDet = fRunAction->GetNDetectors();
+  fEdep.assign(nDet, 0.);
+
+  const G4Event* event = G4EventManager::GetEventManager()->GetConstCurrentEvent();
+  G4HCofThisEvent* hce = event ? event->GetHCofThisEvent() : nullptr;
+  if (hce && fScintHCID != -1) {
+      auto scintHC = static_cast<DET01HitsCollection*>(hce->GetHC(fScintHCID));
+      for (size_t i=0; scintHC && i<scintHC->entries(); i++) {
+          G4int id = (*scintHC)[i]->GetDetID();
+          if (id >= 0 && id < nDet) fEdep[id] += (*scintHC)[i]->GetEdep();
+      }
+  }
+
+  // Rejected: drop the optical stack, the event action still counts the event
+  if (!fRunAction->GetTrigger()->Accept(fEdep)) {
+      stackManager->ClearWaitingStack();
+      return;
+  }
+
+  // Accepted: move the photons back to the urgent stack
+  stackManager->ReClassify();
+}
+
+void DET01StackingAction::PrepareNewEvent()
+{
+  fReleased = false;
+  fIsolated = DET01IsolatedOptics::IsActive();
+}
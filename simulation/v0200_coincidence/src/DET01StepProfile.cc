@@ -0,0 +1,146 @@
+#include "DET01StepProfile.hh"
+
+#include "G4LogicalVolume.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4VProcess.hh"
+#include "G4GenericMessenger.hh"
+#include "G4ios.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+DET01StepProfile* DET01StepProfile::GetInstance()
+{
+  static G4ThreadLocal DET01StepProfile* instance = nullptr;
+  if (!instance) instance = new DET01StepProfile();
+  return instance;
+}
+
+DET01StepProfile::DET01StepProfile(const G4String& name)
+ : G4VAccumulable(name),
+   fMessenger(nullptr),
+   fEnabled(false),
+   fTop(20)
+{
+  fMessenger = new G4GenericMessenger(this, "/det01/profile/", "Step-level CPU attribution");
+
+  fMessenger->DeclareProperty("enable", fEnabled,
+      "Time every step per (volume x particle x process) bucket.");
+
+  fMessenger->DeclareProperty("top", fTop,
+      "Number of buckets in the end-of-run report (0 = all).");
+
+  fMessenger->DeclareProperty("file", fFileName,
+      "Also write all merged buckets as CSV to this file (empty = no file).");
+}
+
+DET01StepProfile::~DET01StepProfile()
+{
+  delete fMessenger;
+}
+
+void DET01StepProfile::Fill(const G4LogicalVolume* volume, const G4ParticleDefinition* particle,
+                            const G4VProcess* process, G4double wallTime, G4double cpuTime)
+{
+  Bucket& bucket = fBuckets[Key(volume, particle, process)];
+  bucket.steps++;
+  bucket.wall += wallTime;
+  bucket.cpu += cpuTime;
+}
+
+DET01StepProfile::NameKey DET01StepProfile::Names(const Key& key)
+{
+  const G4LogicalVolume* volume = std::get<0>(key);
+  const G4ParticleDefinition* particle = std::get<1>(key);
+  const G4VProcess* process = std::get<2>(key);
+  return NameKey(volume ? volume->GetName() : "OutOfWorld",
+                 particle ? particle->GetParticleName() : "unknown",
+                 process ? process->GetProcessName() : "none");
+}
+
+std::map<DET01StepProfile::NameKey, DET01StepProfile::Bucket> DET01StepProfile::Merged() const
+{
+  std::map<NameKey, Bucket> merged = fNamedBuckets;
+  for (const auto& entry : fBuckets) {
+      Bucket& bucket = merged[Names(entry.first)];
+      bucket.steps += entry.second.steps;
+      bucket.wall += entry.second.wall;
+      bucket.cpu += entry.second.cpu;
+  }
+  return merged;
+}
+
+void DET01StepProfile::Merge(const G4VAccumulable& other)
+{
+  const DET01StepProfile& right = static_cast<const DET01StepProfile&>(other);
+  for (const auto& entry : right.Merged()) {
+      Bucket& bucket = fNamedBuckets[entry.first];
+      bucket.steps += entry.second.steps;
+      bucket.wall += entry.second.wall;
+      bucket.cpu += entry.second.cpu;
+  }
+}
+
+void DET01StepProfile::Reset()
+{
+  fBuckets.clear();
+  fNamedBuckets.clear();
+}
+
+void DET01StepProfile::Print() const
+{
+  if (!fEnabled) return;
+
+  std::map<NameKey, Bucket> merged = Merged();
+  if (merged.empty()) return;
+
+  // Sort by CPU time
+  std::vector<std::pair<NameKey, Bucket>> sorted(merged.begin(), merged.end());
+  std::sort(sorted.begin(), sorted.end(),
+            [](const std::pair<NameKey, Bucket>& a, const std::pair<NameKey, Bucket>& b)
+            { return a.second.cpu > b.second.cpu; });
+
+  G4long totalSteps = 0;
+  G4double totalCpu = 0., totalWall = 0.;
+  for (const auto& entry : sorted) {
+      totalSteps += entry.second.steps;
+      totalCpu += entry.second.cpu;
+      totalWall += entry.second.wall;
+  }
+
+  std::streamsize prec = G4cout.precision();
+  G4cout << G4endl
+         << "--------------------- Step Profile ---------------------" << G4endl
+         << " Steps: " << totalSteps << std::fixed << std::setprecision(3)
+         << ", CPU: " << totalCpu << " s, wall: " << totalWall << " s (all threads)" << G4endl
+         << std::setw(16) << "Volume" << std::setw(16) << "Particle" << std::setw(22) << "Process"
+         << std::setw(14) << "Steps" << std::setw(11) << "CPU [s]"
+         << std::setw(11) << "Wall [s]" << std::setw(8) << "CPU %" << G4endl;
+
+  size_t nPrint = (fTop > 0) ? std::min(sorted.size(), size_t(fTop)) : sorted.size();
+  for (size_t i=0; i<nPrint; i++) {
+      const auto& key = sorted[i].first;
+      const auto& bucket = sorted[i].second;
+      G4cout << std::setw(16) << std::get<0>(key) << std::setw(16) << std::get<1>(key)
+             << std::setw(22) << std::get<2>(key)
+             << std::setw(14) << bucket.steps
+             << std::setw(11) << bucket.cpu << std::setw(11) << bucket.wall
+             << std::setw(8) << std::setprecision(1)
+             << (totalCpu > 0. ? 100. * bucket.cpu / totalCpu : 0.)
+             << std::setprecision(3) << G4endl;
+  }
+  G4cout << "--------------------------------------------------------" << G4endl;
+  G4cout << std::defaultfloat << std::setprecision(prec);
+
+  if (!fFileName.empty()) {
+      std::ofstream out(fFileName);
+      out << "volume,particle,process,steps,cpu_s,wall_s\n";
+      for (const auto& entry : sorted) {
+          out << std::get<0>(entry.first) << "," << std::get<1>(entry.first) << ","
+              << std::get<2>(entry.first) << "," << entry.second.steps << ","
+              << entry.second.cpu << "," << entry.second.wall << "\n";
+      }
+  }
+}
@@ -0,0 +1,63 @@
+#include "DET01SteppingAction.hh"
+#include "DET01StepProfile.hh"
+
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4VProcess.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4EventManager.hh"
+#include "G4Event.hh"
+
+#include <chrono>
+#include <time.h>
+
+namespace {
+  G4double WallSeconds()
+  {
+    return std::chrono::duration<G4double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  G4double ThreadCpuSeconds()
+  {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+  }
+}
+
+DET01SteppingAction::DET01SteppingAction()
+ : G4UserSteppingAction(),
+   fProfile(DET01StepProfile::GetInstance()),
+   fEventID(-1),
+   fLastWall(0.),
+   fLastCpu(0.)
+{}
+
+DET01SteppingAction::~DET01SteppingAction()
+{}
+
+void DET01SteppingAction::UserSteppingAction(const G4Step* step)
+{
+  if (!fProfile->IsEnabled()) return;
+
+  G4double wall = WallSeconds();
+  G4double cpu = ThreadCpuSeconds();
+
+  // First step of an event: no reference point (event boundaries and
+  // ntuple filling are not attributed to any bucket)
+  const G4Event* event = G4EventManager::GetEventManager()->GetConstCurrentEvent();
+  G4int eventID = event ? event->GetEventID() : -1;
+  if (eventID == fEventID) {
+      G4VPhysicalVolume* volume = step->GetPreStepPoint()->GetPhysicalVolume();
+      fProfile->Fill(volume ? volume->GetLogicalVolume() : nullptr,
+                     step->GetTrack()->GetDefinition(),
+                     step->GetPostStepPoint()->GetProcessDefinedStep(),
+                     wall - fLastWall, cpu - fLastCpu);
+  }
+
+  fEventID = eventID;
+  fLastWall = wall;
+  fLastCpu = cpu;
+}
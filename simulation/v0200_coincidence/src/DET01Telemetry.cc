@@ -0,0 +1,263 @@
+#include "DET01Telemetry.hh"
+
+#include "G4Run.hh"
+#include "G4GenericMessenger.hh"
+#include "G4Threading.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Exception.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace
+{
+  // name == <prefix>_t<i><suffix>: thread index i, else -1
+  G4int ThreadIndex(const std::string& name, const std::string& prefix, const std::string& suffix)
+  {
+    const std::string head = prefix + "_t";
+    if (name.size() <= head.size() + suffix.size()) return -1;
+    if (name.compare(0, head.size(), head) != 0) return -1;
+    if (name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) return -1;
+    const std::string digits = name.substr(head.size(), name.size() - head.size() - suffix.size());
+    if (digits.size() > 4 || digits.find_first_not_of("0123456789") != std::string::npos) return -1;
+    return std::stoi(digits);
+  }
+}
+
+std::atomic<G4bool> DET01Telemetry::fActive(false);
+DET01Telemetry::Counters DET01Telemetry::fSlots[DET01Telemetry::kMaxSlots];
+
+DET01Telemetry::DET01Telemetry()
+ : fMessenger(nullptr),
+   fEnabled(false),
+   fConsole(false),
+   fInterval(10.*s),
+   fRunID(0),
+   fTotalEvents(0),
+   fLastPhotons(0),
+   fStop(false)
+{
+  DefineCommands();
+}
+
+DET01Telemetry::~DET01Telemetry()
+{
+  Stop();
+  delete fMessenger;
+}
+
+void DET01Telemetry::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/det01/telemetry/", "Live run telemetry");
+
+  auto& enableCmd = fMessenger->DeclareProperty("enable", fEnabled,
+      "Sample throughput, acceptance, memory and output size during the run.");
+  enableCmd.SetToBeBroadcasted(false);
+
+  auto& intervalCmd = fMessenger->DeclarePropertyWithUnit("interval", "s", fInterval,
+      "Time between two samples.");
+  intervalCmd.SetRange("interval > 0.");
+  intervalCmd.SetToBeBroadcasted(false);
+
+  auto& fileCmd = fMessenger->DeclareProperty("file", fFileName,
+      "JSON-lines file (empty: <output name>_telemetry.jsonl).");
+  fileCmd.SetToBeBroadcasted(false);
+
+  auto& consoleCmd = fMessenger->DeclareProperty("console", fConsole,
+      "Also print a one-line summary of every sample.");
+  consoleCmd.SetToBeBroadcasted(false);
+}
+
+DET01Telemetry::Counters& DET01Telemetry::Slot()
+{
+  // Worker IDs start at 0, the master (and sequential mode) is -1
+  G4int slot = G4Threading::G4GetThreadId() + 1;
+  return fSlots[std::min(std::max(slot, 0), kMaxSlots - 1)];
+}
+
+void DET01Telemetry::RegisterThread()
+{
+  if (fActive.load(std::memory_order_relaxed)) Slot().started.store(true, std::memory_order_relaxed);
+}
+
+void DET01Telemetry::CountEvent(G4bool accepted)
+{
+  if (!fActive.load(std::memory_order_relaxed)) return;
+  Counters& counters = Slot();
+  counters.events.fetch_add(1, std::memory_order_relaxed);
+  if (accepted) counters.accepted.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DET01Telemetry::Start(const G4Run* run, const G4String& outputFile)
+{
+  Stop();
+  if (!fEnabled) return;
+
+  fOutputStem = outputFile;
+  if (G4StrUtil::ends_with(fOutputStem, ".root")) fOutputStem.erase(fOutputStem.size() - 5);
+  fTelemetryFile = fFileName.empty() ? fOutputStem + "_telemetry.jsonl" : fFileName;
+
+  fOut.open(fTelemetryFile, std::ios::app);
+  if (!fOut) {
+      G4Exception("DET01Telemetry::Start()", "DET01_901", JustWarning,
+                  ("Cannot open telemetry file " + fTelemetryFile).c_str());
+      return;
+  }
+
+  fRunID = run->GetRunID();
+  fTotalEvents = run->GetNumberOfEventToBeProcessed();
+  for (auto& counters : fSlots) {
+      counters.events.store(0, std::memory_order_relaxed);
+      counters.accepted.store(0, std::memory_order_relaxed);
+      counters.photons.store(0, std::memory_order_relaxed);
+      counters.started.store(false, std::memory_order_relaxed);
+  }
+  fLastEvents.assign(kMaxSlots, 0);
+  fIdle.assign(kMaxSlots, 0.);
+  fLastPhotons = 0;
+  fStartTime = fLastTime = std::chrono::steady_clock::now();
+
+  fActive = true;
+  fStop = false;
+  fReporter = std::thread(&DET01Telemetry::Loop, this);
+}
+
+void DET01Telemetry::Stop()
+{
+  if (!fReporter.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fStop = true;
+  }
+  fWake.notify_all();
+  fReporter.join();
+
+  fActive = false;
+  fOut.close();
+}
+
+void DET01Telemetry::Loop()
+{
+  const auto interval = std::chrono::duration<G4double>(fInterval / s);
+  std::unique_lock<std::mutex> lock(fMutex);
+  while (!fStop) {
+      fWake.wait_for(lock, interval, [this] { return fStop; });
+      Sample(fStop);
+  }
+}
+
+// Reporter thread: not a Geant4 thread, so plain std::cout for the console
+void DET01Telemetry::Sample(G4bool final)
+{
+  const auto now = std::chrono::steady_clock::now();
+  const G4double elapsed = std::chrono::duration<G4double>(now - fStartTime).count();
+  const G4double dt = std::max(std::chrono::duration<G4double>(now - fLastTime).count(), 1.e-9);
+  fLastTime = now;
+
+  G4long events = 0, accepted = 0, photons = 0, lastEvents = 0;
+  std::ostringstream threads;
+  G4bool first = true;
+  for (G4int slot=0; slot<kMaxSlots; slot++) {
+      G4long n = fSlots[slot].events.load(std::memory_order_relaxed);
+      events += n;
+      accepted += fSlots[slot].accepted.load(std::memory_order_relaxed);
+      photons += fSlots[slot].photons.load(std::memory_order_relaxed);
+      lastEvents += fLastEvents[slot];
+      // MT master (slot 0) and unused slots never start
+      if (!fSlots[slot].started.load(std::memory_order_relaxed)) continue;
+
+      // No event since the previous sample: the thread has been idle that long
+      fIdle[slot] = (n == fLastEvents[slot]) ? fIdle[slot] + dt : 0.;
+      threads << (first ? "" : ",") << "{\"thread\":" << slot - 1 << ",\"events\":" << n
+              << ",\"events_per_s\":" << (n - fLastEvents[slot]) / dt
+              << ",\"idle_s\":" << fIdle[slot] << "}";
+      fLastEvents[slot] = n;
+      first = false;
+  }
+
+  const G4double rate = (events - lastEvents) / dt;
+  const G4double meanRate = (elapsed > 0.) ? events / elapsed : 0.;
+  const G4double photonRate = (photons - fLastPhotons) / dt;
+  fLastPhotons = photons;
+  const G4double eta = (meanRate > 0.) ? std::max<G4long>(fTotalEvents - events, 0) / meanRate : -1.;
+  const G4long rss = ResidentBytes();
+  const G4long output = OutputBytes();
+  const G4long unixTime = std::chrono::duration_cast<std::chrono::seconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+
+  std::ostringstream line;
+  line << std::setprecision(6)
+       << "{\"run\":" << fRunID << ",\"time\":" << unixTime << ",\"elapsed_s\":" << elapsed
+       << ",\"events\":" << events << ",\"total\":" << fTotalEvents
+       << ",\"events_per_s\":" << rate << ",\"eta_s\":" << eta
+       << ",\"accepted\":" << accepted
+       << ",\"acceptance\":" << ((events > 0) ? (G4double)accepted / events : 0.)
+       << ",\"photons\":" << photons << ",\"photons_per_s\":" << photonRate
+       << ",\"rss_bytes\":" << rss << ",\"output_bytes\":" << output
+       << ",\"threads\":[" << threads.str() << "]"
+       << (final ? ",\"final\":true" : "") << "}";
+  fOut << line.str() << "\n";
+  fOut.flush();
+
+  if (fConsole) {
+      std::ostringstream summary;
+      summary << std::fixed << std::setprecision(1)
+              << "Telemetry: " << events << " / " << fTotalEvents << " events, "
+              << rate << " ev/s, ETA " << eta << " s, acceptance "
+              << 100. * ((events > 0) ? (G4double)accepted / events : 0.) << "%, "
+              << photonRate << " photons/s, RSS " << rss / 1048576. << " MB, output "
+              << output / 1048576. << " MB";
+      std::cout << summary.str() << std::endl;
+  }
+}
+
+// Files this run writes: <stem>.root and <stem>_photons.bin, and the
+// _t<i> shards and sidecars of the threads that began it. Other files
+// with the same prefix (earlier runs, other stems, summaries) are left out.
+G4long DET01Telemetry::OutputBytes() const
+{
+  namespace fs = std::filesystem;
+  std::error_code error;
+  fs::path stem(static_cast<const std::string&>(fOutputStem));
+  fs::path dir = stem.has_parent_path() ? stem.parent_path() : fs::path(".");
+  const std::string prefix = stem.filename().string();
+  auto threadStarted = [](G4int i) {
+    return i >= 0 && i + 1 < kMaxSlots && fSlots[i + 1].started.load(std::memory_order_relaxed);
+  };
+
+  G4long bytes = 0;
+  for (fs::directory_iterator it(dir, error), end; !error && it != end; it.increment(error)) {
+      const std::string name = it->path().filename().string();
+      const G4bool ours = name == prefix + ".root" || name == prefix + "_photons.bin"
+                       || threadStarted(ThreadIndex(name, prefix, ".root"))
+                       || threadStarted(ThreadIndex(name, prefix + "_photons", ".bin"));
+      if (!ours) continue;
+      std::error_code sizeError;
+      auto size = fs::file_size(it->path(), sizeError);
+      if (!sizeError) bytes += size;
+  }
+  return bytes;
+}
+
+G4long DET01Telemetry::ResidentBytes()
+{
+#ifdef __linux__
+  // Second field of /proc/self/statm: resident pages
+  G4long pages = 0, resident = 0;
+  FILE* statm = std::fopen("/proc/self/statm", "r");
+  if (!statm) return 0;
+  G4int n = std::fscanf(statm, "%ld %ld", &pages, &resident);
+  std::fclose(statm);
+  return (n == 2) ? resident * sysconf(_SC_PAGESIZE) : 0;
+#else
+  return 0;
+#endif
+}
@@ -0,0 +1,136 @@
+#include "DET01Trigger.hh"
+#include "DET01DetectorConstruction.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4RunManager.hh"
+#include "G4UIcommand.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+
+#include <algorithm>
+#include <sstream>
+
+DET01Trigger::DET01Trigger()
+ : fMessenger(nullptr),
+   fEnabled(false),
+   fThreshold(0.),
+   fMultiplicity(1)
+{
+  DefineCommands();
+}
+
+DET01Trigger::~DET01Trigger()
+{
+  delete fMessenger;
+}
+
+void DET01Trigger::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/det01/trigger/", "Software trigger before ntuple filling");
+
+  fMessenger->DeclareProperty("enable", fEnabled,
+      "Only write events accepted by the trigger.");
+
+  fMessenger->DeclarePropertyWithUnit("threshold", "MeV", fThreshold,
+      "Energy threshold for a detector to fire (all detectors).");
+
+  fMessenger->DeclareMethod("detThreshold", &DET01Trigger::SetDetThreshold,
+      "Per-detector threshold: <copyNo> <value> [unit, default MeV].");
+
+  fMessenger->DeclareProperty("multiplicity", fMultiplicity,
+      "Minimum number of fired detectors in the selected rings.");
+
+  fMessenger->DeclareMethod("addPattern", &DET01Trigger::AddPattern,
+      "Coincidence pattern: list of copy numbers that must all fire, e.g. \"0 1 2 3\".");
+
+  fMessenger->DeclareMethod("clearPatterns", &DET01Trigger::ClearPatterns,
+      "Remove all coincidence patterns.");
+
+  fMessenger->DeclareMethod("rings", &DET01Trigger::SetRings,
+      "Rings of the ring layout counted for the multiplicity, e.g. \"0 1\" (empty = all).");
+}
+
+void DET01Trigger::SetDetThreshold(const G4String& value)
+{
+  std::istringstream is(value);
+  G4int det = -1;
+  G4double threshold = 0.;
+  G4String unit = "MeV";
+  is >> det >> threshold >> unit;
+  if (det < 0) {
+      G4cerr << "DET01Trigger: bad detThreshold \"" << value << "\"" << G4endl;
+      return;
+  }
+
+  if ((G4int)fDetThresholds.size() <= det) fDetThresholds.resize(det + 1, -1.);
+  fDetThresholds[det] = threshold * G4UIcommand::ValueOf(unit);
+}
+
+void DET01Trigger::AddPattern(const G4String& value)
+{
+  std::istringstream is(value);
+  std::vector<G4int> pattern;
+  G4int det;
+  while (is >> det) pattern.push_back(det);
+  if (!pattern.empty()) fPatterns.push_back(pattern);
+}
+
+void DET01Trigger::ClearPatterns()
+{
+  fPatterns.clear();
+}
+
+void DET01Trigger::SetRings(const G4String& value)
+{
+  std::istringstream is(value);
+  fRings.clear();
+  G4int ring;
+  while (is >> ring) fRings.push_back(ring);
+}
+
+G4double DET01Trigger::GetThreshold(G4int det) const
+{
+  if (det < (G4int)fDetThresholds.size() && fDetThresholds[det] >= 0.) return fDetThresholds[det];
+  return fThreshold;
+}
+
+G4bool DET01Trigger::Fired(const std::vector<G4double>& edep, G4int det) const
+{
+  if (det < 0 || det >= (G4int)edep.size()) return false;
+  return edep[det] > 0. && edep[det] >= GetThreshold(det);
+}
+
+G4bool DET01Trigger::Accept(const std::vector<G4double>& edep) const
+{
+  if (!fEnabled) return true;
+
+  // Ring of every copyNo as built (empty for the stack layout)
+  static const std::vector<G4int> noRings;
+  const std::vector<G4int>* detectorRings = &noRings;
+  if (!fRings.empty()) {
+      const auto* detector = static_cast<const DET01DetectorConstruction*>(
+          G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+      if (detector) detectorRings = &detector->GetDetectorRings();
+  }
+
+  // Multiplicity in the selected rings
+  G4int multiplicity = 0;
+  for (G4int i=0; i<(G4int)edep.size(); i++) {
+      if (!Fired(edep, i)) continue;
+      if (i < (G4int)detectorRings->size() &&
+          std::find(fRings.begin(), fRings.end(), (*detectorRings)[i]) == fRings.end()) continue;
+      multiplicity++;
+  }
+  if (multiplicity < fMultiplicity) return false;
+
+  // Coincidence patterns (any of them)
+  if (fPatterns.empty()) return true;
+  for (const auto& pattern : fPatterns) {
+      G4bool all = true;
+      for (G4int det : pattern) {
+          if (!Fired(edep, det)) { all = false; break; }
+      }
+      if (all) return true;
+  }
+  return false;
+}
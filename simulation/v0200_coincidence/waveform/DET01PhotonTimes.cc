@@ -0,0 +1,217 @@
+#include "DET01PhotonTimes.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+  const char kMagic[8] = { 'D', 'E', 'T', '0', '1', 'P', 'T', '1' };
+  const std::size_t kHeaderSize = 16;
+
+  void PutVarint(std::string& out, std::uint64_t value)
+  {
+    while (value >= 0x80) {
+        out.push_back(char((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(char(value));
+  }
+
+  void PutUInt32(std::string& out, std::uint32_t value)
+  {
+    for (int i=0; i<4; i++) out.push_back(char((value >> (8 * i)) & 0xff));
+  }
+
+  // false at the end of the buffer or on a malformed (> 10 byte) varint
+  bool GetVarint(const unsigned char*& p, const unsigned char* end, std::uint64_t& value)
+  {
+    value = 0;
+    for (int shift=0; shift<64 && p<end; shift+=7) {
+        unsigned char byte = *p++;
+        value |= std::uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+  }
+
+  std::uint32_t GetUInt32(const unsigned char* p)
+  {
+    return std::uint32_t(p[0]) | (std::uint32_t(p[1]) << 8)
+         | (std::uint32_t(p[2]) << 16) | (std::uint32_t(p[3]) << 24);
+  }
+
+  std::uint64_t ZigZag(std::int64_t v) { return (std::uint64_t(v) << 1) ^ std::uint64_t(v >> 63); }
+  std::int64_t UnZigZag(std::uint64_t v) { return std::int64_t(v >> 1) ^ -std::int64_t(v & 1); }
+}
+
+// ---------------------------------------------------------------------------
+// Writer
+
+DET01PhotonTimesWriter::DET01PhotonTimesWriter()
+ : fNPmts(0), fQuantum(0.001), fBytes(0)
+{}
+
+DET01PhotonTimesWriter::~DET01PhotonTimesWriter()
+{
+  Close();
+}
+
+bool DET01PhotonTimesWriter::Open(const std::string& fileName, int nPmts, double quantum)
+{
+  Close();
+  fOut.open(fileName, std::ios::binary | std::ios::trunc);
+  if (!fOut) return false;
+
+  fNPmts = nPmts;
+  fQuantum = quantum;
+
+  std::string header(kMagic, sizeof(kMagic));
+  PutUInt32(header, nPmts);
+  PutUInt32(header, std::uint32_t(std::lround(quantum * 1.e6)));   // ns -> fs
+  fOut.write(header.data(), header.size());
+  fBytes = header.size();
+  return true;
+}
+
+void DET01PhotonTimesWriter::Close()
+{
+  if (fOut.is_open()) fOut.close();
+}
+
+void DET01PhotonTimesWriter::Write(long eventID, std::vector<std::vector<double>>& times)
+{
+  if (!fOut.is_open()) return;
+
+  fPayload.clear();
+  PutVarint(fPayload, std::uint64_t(eventID));
+  for (int pmt=0; pmt<fNPmts; pmt++) {
+      if (pmt >= int(times.size()) || times[pmt].empty()) {
+          PutVarint(fPayload, 0);
+          continue;
+      }
+      std::vector<double>& t = times[pmt];
+      std::sort(t.begin(), t.end());
+      PutVarint(fPayload, t.size());
+
+      std::int64_t previous = std::llround(t[0] / fQuantum);
+      PutVarint(fPayload, ZigZag(previous));
+      for (std::size_t i=1; i<t.size(); i++) {
+          std::int64_t tick = std::llround(t[i] / fQuantum);
+          PutVarint(fPayload, std::uint64_t(tick - previous));
+          previous = tick;
+      }
+  }
+
+  // One write per event; the stream may still flush part of it (the reader
+  // drops a cut last record by its size prefix)
+  fRecord.clear();
+  PutVarint(fRecord, fPayload.size());
+  fRecord += fPayload;
+  fOut.write(fRecord.data(), fRecord.size());
+  fBytes += fRecord.size();
+}
+
+// ---------------------------------------------------------------------------
+// Reader
+
+DET01PhotonTimesReader::DET01PhotonTimesReader()
+ : fData(nullptr), fSize(0), fNPmts(0), fQuantum(0.)
+{}
+
+DET01PhotonTimesReader::~DET01PhotonTimesReader()
+{
+  Close();
+}
+
+bool DET01PhotonTimesReader::Open(const std::string& fileName, std::string& error)
+{
+  Close();
+
+  int fd = ::open(fileName.c_str(), O_RDONLY);
+  if (fd < 0) {
+      error = "cannot open " + fileName;
+      return false;
+  }
+  struct stat info;
+  if (::fstat(fd, &info) != 0 || std::size_t(info.st_size) < kHeaderSize) {
+      ::close(fd);
+      error = fileName + " is not a photon-time sidecar (too short)";
+      return false;
+  }
+  fSize = info.st_size;
+  void* map = ::mmap(nullptr, fSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED) {
+      fSize = 0;
+      error = "cannot map " + fileName;
+      return false;
+  }
+  fData = static_cast<const unsigned char*>(map);
+  ::madvise(map, fSize, MADV_SEQUENTIAL);
+
+  if (std::memcmp(fData, kMagic, sizeof(kMagic)) != 0) {
+      Close();
+      error = fileName + " is not a photon-time sidecar (bad magic)";
+      return false;
+  }
+  fNPmts = GetUInt32(fData + 8);
+  fQuantum = GetUInt32(fData + 12) * 1.e-6;   // fs -> ns
+
+  // Index the records; a cut last record (or a zero-filled tail) is dropped:
+  // a payload holds at least the eventID and one nPE per PMT
+  const unsigned char* p = fData + kHeaderSize;
+  const unsigned char* end = fData + fSize;
+  const std::uint64_t minSize = 1 + std::uint64_t(fNPmts);
+  std::uint64_t size;
+  while (p < end && GetVarint(p, end, size) && size >= minSize && size <= std::uint64_t(end - p)) {
+      fOffsets.push_back(p - fData);
+      p += size;
+      fEnds.push_back(p - fData);
+  }
+  return true;
+}
+
+void DET01PhotonTimesReader::Close()
+{
+  if (fData) ::munmap(const_cast<unsigned char*>(fData), fSize);
+  fData = nullptr;
+  fSize = 0;
+  fOffsets.clear();
+  fEnds.clear();
+}
+
+void DET01PhotonTimesReader::Read(std::size_t i, long& eventID,
+                                  std::vector<std::vector<double>>& times) const
+{
+  times.resize(fNPmts);
+  for (auto& t : times) t.clear();
+
+  const unsigned char* p = fData + fOffsets[i];
+  const unsigned char* end = fData + fEnds[i];
+
+  std::uint64_t value;
+  GetVarint(p, end, value);
+  eventID = long(value);
+  for (int pmt=0; pmt<fNPmts; pmt++) {
+      std::uint64_t nPE;
+      if (!GetVarint(p, end, nPE) || nPE == 0) continue;
+      if (!GetVarint(p, end, value)) return;
+
+      // Every further time takes at least one byte: a larger count is corrupt
+      if (nPE - 1 > std::uint64_t(end - p)) return;
+
+      std::vector<double>& t = times[pmt];
+      t.reserve(nPE);
+      std::int64_t tick = UnZigZag(value);
+      t.push_back(tick * fQuantum);
+      for (std::uint64_t k=1; k<nPE && GetVarint(p, end, value); k++) {
+          tick += std::int64_t(value);
+          t.push_back(tick * fQuantum);
+      }
+  }
+}
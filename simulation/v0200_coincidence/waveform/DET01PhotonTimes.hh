@@ -0,0 +1,82 @@
+#ifndef DET01PhotonTimes_h
+#define DET01PhotonTimes_h 1
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/// Photon-time sidecar: per-event, per-PMT photoelectron arrival times.
+///
+/// Plain C++ (no Geant4), part of det01_waveform, so det01 writes the files
+/// and det01_replay re-digitizes them without Geant4 in the loop.
+///
+/// Layout (little-endian):
+///  - header: "DET01PT1", uint32 nPmts, uint32 time quantum [fs]
+///  - one record per event: varint payload size, then the payload
+///      varint eventID,
+///      per PMT: varint nPE, zigzag varint first tick, nPE-1 varint deltas
+///    with the times sorted and rounded to the quantum (ticks).
+/// A few photoelectrons ns apart cost 1-2 bytes each. Records are
+/// self-delimiting: the reader memory-maps the file, indexes the records by
+/// their sizes and decodes events independently (any order, any thread).
+/// A file cut by a killed job may end inside a record (the stream flushes
+/// at buffer boundaries, not at record ends); the reader stops at the first
+/// record whose size prefix is cut, runs past the end of the file or is
+/// too small for nPmts, so only complete records are read.
+
+class DET01PhotonTimesWriter
+{
+  public:
+    DET01PhotonTimesWriter();
+    ~DET01PhotonTimesWriter();
+
+    // Times and quantum in ns (e.g. 0.001: 1 ps ticks)
+    bool Open(const std::string& fileName, int nPmts, double quantum);
+    void Close();
+    bool IsOpen() const { return fOut.is_open(); }
+
+    // times[pmt]: photoelectron times of the event [ns] (any order, sorted here)
+    void Write(long eventID, std::vector<std::vector<double>>& times);
+
+    std::size_t GetBytesWritten() const { return fBytes; }
+
+  private:
+    std::ofstream fOut;
+    int fNPmts;
+    double fQuantum;
+    std::size_t fBytes;
+    std::string fPayload, fRecord;     // per-event buffers
+};
+
+class DET01PhotonTimesReader
+{
+  public:
+    DET01PhotonTimesReader();
+    ~DET01PhotonTimesReader();
+
+    DET01PhotonTimesReader(const DET01PhotonTimesReader&) = delete;
+    DET01PhotonTimesReader& operator=(const DET01PhotonTimesReader&) = delete;
+
+    // Map the file and index its records; false (and an error) if not a sidecar
+    bool Open(const std::string& fileName, std::string& error);
+    void Close();
+
+    int GetNPmts() const { return fNPmts; }
+    double GetQuantum() const { return fQuantum; }
+    std::size_t GetNEvents() const { return fOffsets.size(); }
+
+    // Decode event i, times in ns (thread-safe, the mapping is read-only);
+    // a corrupt record stops at the first PMT whose count exceeds its size
+    void Read(std::size_t i, long& eventID, std::vector<std::vector<double>>& times) const;
+
+  private:
+    const unsigned char* fData;
+    std::size_t fSize;
+    int fNPmts;
+    double fQuantum;
+    std::vector<std::size_t> fOffsets, fEnds;   // payload range per event
+};
+
+#endif
@@ -0,0 +1,24 @@
+#include "DET01PmtResponse.hh"
+
+#include <cmath>
+
+std::vector<float> DET01PmtResponse::BuildTemplate(const Settings& settings)
+{
+  if (!settings.templateFile.empty()) return DET01Waveform::ReadTemplate(settings.templateFile);
+
+  int nTemplate = int(8. * settings.fallTime / settings.samplePeriod) + 1;
+  return DET01Waveform::BiExponentialTemplate(settings.riseTime, settings.fallTime,
+                                              settings.samplePeriod, nTemplate);
+}
+
+DET01PmtResponse::DET01PmtResponse(const Settings& settings, const std::vector<float>& pulseTemplate)
+ : fSettings(settings),
+   fTemplate(pulseTemplate),
+   fWave(std::max(settings.samples, 0), 0.f),
+   fScratch(std::max(settings.samples, 0), 0.f)
+{
+  fCfd.fraction = settings.cfdFraction;
+  fCfd.delay = std::max(1, int(std::lround(settings.cfdDelay / settings.samplePeriod)));
+  fCfd.threshold = settings.threshold;
+  fCfd.baselineSamples = std::max(1, int(settings.baselineTime / settings.samplePeriod));
+}
@@ -0,0 +1,97 @@
+#ifndef DET01PmtResponse_h
+#define DET01PmtResponse_h 1
+
+#include "DET01Waveform.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// PMT response model: the photoelectron times of one PMT folded into a
+/// digitized pulse, on top of the DET01Waveform kernel.
+///
+/// Each photoelectron is delayed by the transit-time spread (Gaussian, tts),
+/// gets a gain from the single-PE spectrum (Gaussian, gain x (1 +-
+/// gainSpread), truncated at 0) and adds the single-PE template to a
+/// waveform of `samples` x `samplePeriod` from the window start; white noise
+/// of `noise` rms is added per sample. Analyse() then gives the
+/// baseline-subtracted amplitude and the CFD time.
+///
+/// Plain C++ (no Geant4), part of det01_waveform: DET01PmtDigitizer (with
+/// the Geant4 engine) and det01_replay (with its own per-event engines)
+/// share the model. Random numbers come from the caller's gauss(), which
+/// returns standard normal deviates. Times are in ns, amplitudes in mV.
+
+class DET01PmtResponse
+{
+  public:
+    // Defaults are the /det01/digi/ defaults
+    struct Settings {
+      double gain = 4.;           // per PE
+      double gainSpread = 0.4;    // relative sigma of the single-PE gain
+      double tts = 0.35;          // transit-time spread sigma
+      double noise = 0.5;         // rms per sample
+      double riseTime = 1.0;      // bi-exponential template
+      double fallTime = 3.5;
+      std::string templateFile;   // measured template; empty: bi-exponential
+      double samplePeriod = 0.2;
+      int    samples = 1024;
+      double preTrigger = 20.;    // window start before the event's first PE
+      double cfdFraction = 0.3;
+      double cfdDelay = 1.0;
+      double threshold = 5.;      // CFD arming level above baseline
+      double baselineTime = 10.;  // leading part of the waveform
+    };
+
+    // Single-PE template of the settings (empty if templateFile is unreadable)
+    static std::vector<float> BuildTemplate(const Settings& settings);
+
+    DET01PmtResponse(const Settings& settings, const std::vector<float>& pulseTemplate);
+
+    const Settings& GetSettings() const { return fSettings; }
+
+    // Digitize the photoelectron times of one PMT; the pulse time is in
+    // the frame of the input times (-1: no CFD time)
+    template <class Gauss>
+    DET01Waveform::Pulse Digitize(const double* peTimes, std::size_t nPE, double windowStart,
+                                  Gauss& gauss);
+
+  private:
+    Settings fSettings;
+    std::vector<float> fTemplate;
+    DET01Waveform::CfdSettings fCfd;
+
+    // Per-call buffers
+    std::vector<float> fWave, fScratch, fTimes, fGains;
+};
+
+template <class Gauss>
+DET01Waveform::Pulse DET01PmtResponse::Digitize(const double* peTimes, std::size_t nPE,
+                                                double windowStart, Gauss& gauss)
+{
+  // Photoelectron times (TTS) and gains (single-PE spectrum)
+  fTimes.resize(nPE);
+  fGains.resize(nPE);
+  for (std::size_t i=0; i<nPE; i++) {
+      fTimes[i] = peTimes[i] - windowStart + fSettings.tts * gauss();
+      fGains[i] = std::max(0., 1. + fSettings.gainSpread * gauss()) * fSettings.gain;
+  }
+
+  // Noise, then pulses
+  if (fSettings.noise > 0.) {
+      for (auto& v : fWave) v = fSettings.noise * gauss();
+  }
+  else {
+      std::fill(fWave.begin(), fWave.end(), 0.f);
+  }
+  DET01Waveform::AddPhotoelectrons(fTimes.data(), fGains.data(), nPE, fTemplate,
+                                   fSettings.samplePeriod, fWave.data(), fSettings.samples);
+
+  DET01Waveform::Pulse pulse = DET01Waveform::Analyse(fWave.data(), fSettings.samples,
+                                                      fSettings.samplePeriod, fCfd, fScratch.data());
+  if (pulse.time >= 0.f) pulse.time += windowStart;
+  return pulse;
+}
+
+#endif
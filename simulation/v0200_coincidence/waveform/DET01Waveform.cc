@@ -0,0 +1,114 @@
+#include "DET01Waveform.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define DET01_RESTRICT __restrict__
+#else
+#define DET01_RESTRICT
+#endif
+
+std::vector<float> DET01Waveform::BiExponentialTemplate(float riseTime, float fallTime,
+                                                        float samplePeriod, int nSamples)
+{
+  std::vector<float> pulse(std::max(nSamples, 1), 0.f);
+  if (riseTime <= 0.f || fallTime <= riseTime) return pulse;
+
+  float peak = 0.f;
+  for (int i=0; i<nSamples; i++) {
+      float t = i * samplePeriod;
+      pulse[i] = std::exp(-t / fallTime) - std::exp(-t / riseTime);
+      peak = std::max(peak, pulse[i]);
+  }
+  if (peak > 0.f) {
+      for (auto& v : pulse) v /= peak;
+  }
+  return pulse;
+}
+
+std::vector<float> DET01Waveform::ReadTemplate(const std::string& fileName)
+{
+  std::vector<float> pulse;
+  std::ifstream in(fileName);
+  float value;
+  while (in >> value) pulse.push_back(value);
+
+  float peak = pulse.empty() ? 0.f : *std::max_element(pulse.begin(), pulse.end());
+  if (peak <= 0.f) return {};
+  for (auto& v : pulse) v /= peak;
+  return pulse;
+}
+
+void DET01Waveform::AddPhotoelectrons(const float* time, const float* gain, std::size_t nPE,
+                                      const std::vector<float>& pulseTemplate,
+                                      float samplePeriod, float* DET01_RESTRICT wave, int nSamples)
+{
+  const int nTemplate = pulseTemplate.size();
+  const float* DET01_RESTRICT tmpl = pulseTemplate.data();
+
+  for (std::size_t p=0; p<nPE; p++) {
+      float position = time[p] / samplePeriod;
+      if (position < 0.f || position >= nSamples) continue;
+
+      // Sample start + k sees the template at k - frac:
+      //   (1 - frac) tmpl[k] + frac tmpl[k-1]
+      int start = int(position);
+      float frac = position - start;
+      float a = gain[p] * (1.f - frac);
+      float b = gain[p] * frac;
+
+      int n = std::min(nTemplate, nSamples - start);
+      float* DET01_RESTRICT out = wave + start;
+      out[0] += a * tmpl[0];
+      for (int k=1; k<n; k++) out[k] += a * tmpl[k] + b * tmpl[k-1];
+  }
+}
+
+DET01Waveform::Pulse DET01Waveform::Analyse(const float* DET01_RESTRICT wave, int nSamples,
+                                            float samplePeriod, const CfdSettings& settings,
+                                            float* DET01_RESTRICT scratch)
+{
+  Pulse pulse;
+  if (nSamples <= 0) return pulse;
+
+  // Baseline (reduction)
+  const int nBase = std::min(std::max(settings.baselineSamples, 1), nSamples);
+  float sum = 0.f;
+  for (int i=0; i<nBase; i++) sum += wave[i];
+  pulse.baseline = sum / nBase;
+
+  // Peak (branch-free max)
+  float peak = wave[0];
+  for (int i=1; i<nSamples; i++) peak = std::max(peak, wave[i]);
+  pulse.amplitude = peak - pulse.baseline;
+  if (pulse.amplitude < settings.threshold) return pulse;
+
+  // CFD signal c[i] = f x[i] - x[i-d], x = wave - baseline
+  const int d = std::min(std::max(settings.delay, 1), nSamples - 1);
+  const float f = settings.fraction;
+  const float b = pulse.baseline;
+  for (int i=0; i<d; i++) scratch[i] = f * (wave[i] - b);
+  for (int i=d; i<nSamples; i++) scratch[i] = f * (wave[i] - b) - (wave[i-d] - b);
+
+  // Arming: first sample above threshold; the zero crossing is searched
+  // from there to one delay after the peak, so baseline noise before the
+  // pulse cannot set the time
+  const float level = b + settings.threshold;
+  int arm = 0;
+  while (arm < nSamples && wave[arm] < level) arm++;
+  int peakSample = arm;
+  for (int i=arm; i<nSamples && wave[i] < peak; i++) peakSample = i + 1;
+  pulse.peakSample = std::min(peakSample, nSamples - 1);
+
+  const int last = std::min(nSamples - 1, pulse.peakSample + d);
+  for (int i=arm+1; i<=last; i++) {
+      if (scratch[i-1] > 0.f && scratch[i] <= 0.f) {
+          float t = (i - 1) + scratch[i-1] / (scratch[i-1] - scratch[i]);
+          pulse.time = t * samplePeriod;
+          break;
+      }
+  }
+  return pulse;
+}
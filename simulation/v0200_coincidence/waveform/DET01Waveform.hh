@@ -0,0 +1,57 @@
+#ifndef DET01Waveform_h
+#define DET01Waveform_h 1
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// PMT waveform kernel: pulse synthesis, amplitude and CFD timing.
+///
+/// Plain C++ (no Geant4), built as the det01_waveform library so the same
+/// code runs in the simulation (DET01PmtDigitizer) and on measured scope
+/// waveforms. Waveforms are float arrays with a fixed sample period; times
+/// are in units of that period's clock (e.g. ns) from the first sample.
+///
+/// The inner loops run over contiguous arrays without branches or aliasing
+/// (restrict pointers), so compilers vectorize them at -O3 (set for the
+/// library outside Debug builds, Release is the default); the only
+/// scalar parts are the zero-crossing search and the final interpolation.
+
+class DET01Waveform
+{
+  public:
+    struct CfdSettings {
+      float fraction = 0.3f;      // attenuation of the prompt signal
+      int   delay = 5;            // samples
+      float threshold = 5.f;      // arming level above baseline
+      int   baselineSamples = 50; // leading samples averaged for the baseline
+    };
+
+    struct Pulse {
+      float baseline = 0.f;
+      float amplitude = 0.f;      // peak above baseline
+      float time = -1.f;          // CFD time from the first sample, -1: none
+      int   peakSample = -1;
+    };
+
+    // Single-photoelectron template exp(-t/fall) - exp(-t/rise), peak 1
+    static std::vector<float> BiExponentialTemplate(float riseTime, float fallTime,
+                                                    float samplePeriod, int nSamples);
+
+    // Measured single-PE template: one sample per line, normalised to peak 1
+    // (empty if the file is missing or has no positive sample)
+    static std::vector<float> ReadTemplate(const std::string& fileName);
+
+    // Add one pulse per photoelectron: template x gain[i], starting at
+    // time[i] (linear interpolation of the template between samples)
+    static void AddPhotoelectrons(const float* time, const float* gain, std::size_t nPE,
+                                  const std::vector<float>& pulseTemplate,
+                                  float samplePeriod, float* wave, int nSamples);
+
+    // Baseline, peak and CFD time of a positive pulse. scratch must hold
+    // nSamples floats (no allocation per call).
+    static Pulse Analyse(const float* wave, int nSamples, float samplePeriod,
+                         const CfdSettings& settings, float* scratch);
+};
+
+#endif